@@ -1,101 +1,721 @@
 #include "ServerCore.h"
 
-#include <map>
+#include <atomic>
+#include <csignal>
+#include <future>
+#include <mutex>
+#include <thread>
 
 #include "SocketWrapperLib\SocketWrapperShared.h"
 #include "ChatITF/ChatException.hpp"
 
 const int GOOD_SEGMENT_SIZE = 300;
+// room for the "address: " prefix in front of a segment, an IPv6 address with port fits
+const int MAX_PREFIX_SIZE = 64;
+// segments read from one client per round; the rest waits for the next round, so a fast sender can not
+// fill the queues of the others far beyond the high watermark before a congestion is seen
+const int MAX_RECEIVES_PER_ROUND = 16;
+// accept failures in a row after which the listen socket is tried again from a timer
+const int MAX_ACCEPT_FAILURES = 16;
+const std::chrono::milliseconds ACCEPT_RETRY_DELAY{100};
 
-void serverErrorCallBack(ILoggerPtr logger, std::string error)
+void serverErrorCallBack(ILoggerPtr logger, const SocketError& error)
 {
-    logger->LogTrace(error);
+    logger->LogTrace(std::string(error.operation) + ". GLE=" + std::to_string(error.error));
 }
 
+// The process or, on Linux, the whole system has no descriptor left for an accepted socket.
+bool isOutOfDescriptors(int error)
+{
+#if _WIN32
+    return error == WSAEMFILE;
+#else
+    return error == WSAEMFILE || error == ENFILE;
+#endif
+}
+
+// A connected client, owned by the reactor which serves it. All state of a connection is in this value, the values
+// of a reactor lie in one array; the slot key of its handle is the poller user data.
+struct Client
+{
+    SlotHandle handle = 0;
+    TCPSocketPtr socket;
+    SocketAddress address;
+    // "address: ", in front of every line of the client
+    std::string prefix;
+    // encoded messages not yet taken by the socket, each one shared with the queues of the other recipients
+    std::deque<PooledBufferPtr> outbound;
+    // bytes of the first message which went out already
+    size_t outboundOffset = 0;
+    // bytes of all queued messages, the first one counted in full
+    size_t outboundBytes = 0;
+    // the socket was full, POLL_WRITE is registered until the queue is empty
+    bool isWaitingForWrite = false;
+    // in the flush list of the current round
+    bool isFlushPending = false;
+    // above the high watermark and not yet back at the low one
+    bool isCongested = false;
+    // the slow client policy applies when it fires
+    TimerId graceTimer = 0;
+    // no reactor reads lines until readPauseTimer fires or the client is no longer congested
+    bool isPausingReads = false;
+    TimerId readPauseTimer = 0;
+    // data left in the socket while reading was paused or the client was out of receives for the round
+    bool isReadPaused = false;
+    size_t peakOutboundBytes = 0;
+    uint64_t droppedMessages = 0;
+    uint64_t congestionCount = 0;
+};
+
+typedef std::promise<std::vector<ClientQueueStats>> ClientStatsPromise;
+
+// What a reactor gets from other threads: a client accepted for it, an encoded message for its clients,
+// or a request for the stats of its clients.
+struct ShardMessage
+{
+    TCPSocketPtr newClient;
+    SocketAddress newClientAddress;
+    PooledBufferPtr message;
+    std::shared_ptr<ClientStatsPromise> statsRequest;
+};
+
+typedef std::vector<ShardMessage> ShardBatch;
+
 struct ServerCore::impl
 {
+    struct Reactor;
+
     IUserInterfacePtr ui;
     ILoggerPtr logger;
-    bool isServerRunning;
+    SocketErrorCallBack errorCallBack;
+    ServerCoreOptions options;
+    std::atomic<bool> isServerRunning{false};
+    // clients of all reactors, for the notifications
+    std::atomic<size_t> clientCount{0};
+    // congested clients of all reactors within their maxReadPause; while there is one no reactor reads lines
+    std::atomic<size_t> pausingClientCount{0};
+    std::unique_ptr<ShardedListener> listener;
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    // accepted clients go round robin when there are fewer listen sockets than reactors
+    std::atomic<size_t> nextReactor{0};
+    // every message is encoded once into one of these buffers and shared by the queues of all its recipients,
+    // also across reactors; a line is received behind the prefix of its sender, so it is never copied
+    BufferPool messagePool{GOOD_SEGMENT_SIZE + MAX_PREFIX_SIZE};
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+
+    // Ends every reactor loop, start() rethrows the first reason.
+    void stop(std::exception_ptr reason);
+    void wakeAllReactors();
+};
+
+// One event loop thread with its own poller and its own shard of the clients. Only this thread touches
+// its clients: other reactors push clients and messages into its inbox and wake it up, so there is
+// no lock on the way from a sender to the recipients.
+struct ServerCore::impl::Reactor
+{
+    Reactor(impl& inServer, size_t inIndex) : server(inServer), index(inIndex), outboxes(inServer.reactors.size()) {}
+
+    impl& server;
+    size_t index;
+    // nullptr when another reactor accepts the clients of this one
     TCPSocketPtr listenSocket;
-    std::vector<TCPSocketPtr> readBlockSockets;
-    std::map<TCPSocketPtr, SocketAddress> socketToAddressTable;
+    // a descriptor held back for the listen socket, closed to make room when accept runs out of descriptors
+    TCPSocketPtr spareSocket;
+    // set while the listen socket waits for the next try after a run of failures
+    TimerId acceptRetryTimer = 0;
+    // the lists below and the timer callbacks keep handles, a client which left is skipped, not erased from them
+    SlotMap<Client> clients;
+    // clients with new messages in their queue, flushed at the end of the round with one SendV each
+    std::vector<SlotHandle> pendingFlush;
+    // clients which were not read to the end, because a congested client paused the reads or they used up their round
+    std::vector<SlotHandle> pausedClients;
+    // read pauses and grace periods of the congested clients
+    TimerWheel timers;
+    SocketPoller poller;
+    PollerWakeup wakeup;
+    MpscQueue<ShardBatch> inbox;
+    // what goes to the other reactors during one round, pushed as one batch per reactor at its end
+    std::vector<ShardBatch> outboxes;
+    std::thread thread;
+
+    PooledBufferPtr encode(const std::string& text)
+    {
+        PooledBufferPtr message = server.messagePool.Acquire();
+        size_t length = std::min(text.length(), message->GetCapacity());
+        memcpy(message->GetData(), text.data(), length);
+        message->SetLength(length);
+        return message;
+    }
 
     void onClientConnect(TCPSocketPtr newSocket, SocketAddress newClientAddress)
     {
-        logger->LogInfo("Connected client: " + newClientAddress.ToString());
-        readBlockSockets.push_back(newSocket);
-        socketToAddressTable[newSocket] = newClientAddress;
+        newSocket->SetNonBlockingMode(true);
+        // chat lines are small, they should not wait for Nagle to fill a segment
+        newSocket->SetNoDelay(true);
+        SlotHandle handle = clients.Add(Client());
+        // a client the poller can not watch would never be read, it is closed instead
+        if (poller.Add(newSocket, POLL_READ, clients.GetKey(handle)) != NO_ERROR)
+        {
+            server.logger->LogWarning("Reactor " + std::to_string(index) + " is full, rejected client: "
+                + newClientAddress.ToString());
+            clients.Remove(handle);
+            return;
+        }
+        server.logger->LogInfo("Connected client: " + newClientAddress.ToString());
+        auto& client = *clients.Find(handle);
+        client.handle = handle;
+        client.socket = newSocket;
+        client.address = newClientAddress;
+        client.prefix = newClientAddress.ToString().substr(0, MAX_PREFIX_SIZE - 2) + ": ";
+        size_t count = ++server.clientCount;
 
         std::string replyForAll = "Connected client: " + newClientAddress.ToString()
-        + ". Count clients is " + std::to_string(socketToAddressTable.size()) + ".\0";
+        + ". Count clients is " + std::to_string(count) + "." + '\0';
+
+        broadcast(encode(replyForAll), handle);
+
+        std::string replyForCurrentUser = "Count clients is " + std::to_string(count) + "." + '\0';
+
+        enqueue(client, encode(replyForCurrentUser));
+    }
+
+    void onClientDisconnect(SlotHandle handle)
+    {
+        server.logger->LogInfo("onClientDisconnect");
+        auto& client = *clients.Find(handle);
+
+        std::string reply = "Disconnected client: " + client.address.ToString()
+            + ". Count clients is " + std::to_string(--server.clientCount) + "." + '\0';
+
+        poller.Remove(client.socket);
+        if (client.isCongested)
+        {
+            endCongestion(client);
+        }
+        clients.Remove(handle);
+
+        broadcast(encode(reply), 0);
+    }
+
+    void processDataFromClient(Client& sender, PooledBufferPtr& message)
+    {
+        const char* recvMsg = message->GetData() + sender.prefix.length();
+        size_t segmentLength = message->GetLength() - sender.prefix.length();
+        size_t msgLenght = strnlen(recvMsg, segmentLength);
+        server.logger->LogInfo("Received msg from client. TransportSize=" + std::to_string(segmentLength)
+            + " bytes; MsgLenght=" + std::to_string(msgLenght));
+        server.logger->LogInfo("Msg: " + std::string(recvMsg, msgLenght));
+
+        if(msgLenght == 0)
+            return;
+
+        // the line goes out with its terminator; a segment cut short by the network has no terminator
+        message->SetLength(sender.prefix.length() + std::min(msgLenght + 1, segmentLength));
+
+        broadcast(message, sender.handle);
+    }
 
-        for (auto s : readBlockSockets)
+    // Queues the message for every client of this reactor but exclude and hands it to the other reactors.
+    // The message must not change any more, from now on it is shared.
+    void broadcast(const PooledBufferPtr& message, SlotHandle exclude)
+    {
+        enqueueForClients(message, exclude);
+        for (size_t i = 0; i < outboxes.size(); ++i)
         {
-            if (s != listenSocket && s != newSocket)
+            if (i != index)
             {
-                s->Send(static_cast<const void*>(replyForAll.c_str()), replyForAll.length());
+                outboxes[i].push_back({nullptr, SocketAddress(), message, nullptr});
             }
         }
+    }
 
-        std::string replyForCurrentUser = "Count clients is " + std::to_string(socketToAddressTable.size()) + ".\0";
+    // Fan-out is a reference per recipient, the bytes are written by flushPendingClients.
+    void enqueueForClients(const PooledBufferPtr& message, SlotHandle exclude)
+    {
+        for (auto& client : clients)
+        {
+            if (client.handle != exclude)
+            {
+                enqueue(client, message);
+            }
+        }
+    }
 
-        newSocket->Send(static_cast<const void*>(replyForCurrentUser.c_str()), replyForCurrentUser.length());
+    void enqueue(Client& client, const PooledBufferPtr& message)
+    {
+        client.outbound.push_back(message);
+        client.outboundBytes += message->GetLength();
+        client.peakOutboundBytes = std::max(client.peakOutboundBytes, client.outboundBytes);
+        if (!client.isCongested && client.outboundBytes > server.options.outboundHighWatermark)
+        {
+            beginCongestion(client);
+        }
+        // a client waiting for POLL_WRITE is flushed by its event
+        if (!client.isFlushPending && !client.isWaitingForWrite)
+        {
+            client.isFlushPending = true;
+            pendingFlush.push_back(client.handle);
+        }
     }
 
-    void onClientDisconnect(TCPSocketPtr socket)
+    // Writes the queue of the client with as few SendV calls as it takes. Returns false when the connection broke.
+    bool flush(Client& client)
     {
-        logger->LogInfo("onClientDisconnect");
-        auto& ss = readBlockSockets;
+        while (!client.outbound.empty())
+        {
+            SendBuffer buffers[MAX_SOCKET_BUFFERS];
+            size_t count = 0;
+            for (auto& message : client.outbound)
+            {
+                if (count == MAX_SOCKET_BUFFERS)
+                    break;
+                size_t offset = count == 0 ? client.outboundOffset : 0;
+                buffers[count++] = {message->GetData() + offset, message->GetLength() - offset};
+            }
 
-        std::string reply = "Disconnected client: " + socketToAddressTable.at(socket).ToString()
-            + ". Count clients is " + std::to_string(socketToAddressTable.size() - 1) + ".\0";
+            auto dataSent = client.socket->SendV(buffers, count);
+            if (dataSent == -WSAEWOULDBLOCK)
+            {
+                if (!client.isWaitingForWrite)
+                {
+                    client.isWaitingForWrite = true;
+                    updateInterest(client);
+                }
+                return true;
+            }
+            if (dataSent < 0)
+            {
+                return false;
+            }
+
+            // messages which went out completely leave the queue, the rest of a partial one stays first
+            size_t sentLength = client.outboundOffset + static_cast<size_t>(dataSent);
+            while (!client.outbound.empty() && sentLength >= client.outbound.front()->GetLength())
+            {
+                sentLength -= client.outbound.front()->GetLength();
+                client.outboundBytes -= client.outbound.front()->GetLength();
+                client.outbound.pop_front();
+            }
+            client.outboundOffset = sentLength;
+            if (client.isCongested && client.outboundBytes <= server.options.outboundLowWatermark)
+            {
+                server.logger->LogInfo("Client " + client.address.ToString() + " caught up");
+                endCongestion(client);
+            }
+        }
+
+        if (client.isWaitingForWrite)
+        {
+            client.isWaitingForWrite = false;
+            updateInterest(client);
+        }
+        return true;
+    }
+
+    // POLL_READ unless reading is paused, POLL_WRITE while the queue waits for the socket. A paused client
+    // stays readable, the level triggered select fallback would report it in every Wait until it is resumed.
+    void updateInterest(Client& client)
+    {
+        int interest = (client.isReadPaused ? 0 : POLL_READ) | (client.isWaitingForWrite ? POLL_WRITE : 0);
+        poller.Modify(client.socket, interest, clients.GetKey(client.handle));
+    }
+
+    // The client has more than the high watermark queued: no reactor reads new lines until it catches up or
+    // maxReadPause is over, so the senders of a burst are held back by TCP instead of the queue growing.
+    // A client which is slower than that does not stop the chat, only its own queue grows until the grace period.
+    void beginCongestion(Client& client)
+    {
+        client.isCongested = true;
+        ++client.congestionCount;
+        client.isPausingReads = true;
+        ++server.pausingClientCount;
+        client.readPauseTimer = timers.Schedule(server.options.maxReadPause, [this, handle = client.handle] { onReadPauseOver(handle); });
+        client.graceTimer = timers.Schedule(server.options.slowClientGracePeriod, [this, handle = client.handle] { onGracePeriodOver(handle); });
+        server.logger->LogWarning("Client " + client.address.ToString() + " is congested: "
+            + std::to_string(client.outbound.size()) + " messages, " + std::to_string(client.outboundBytes) + " bytes queued");
+    }
 
-        ss.erase(std::remove(ss.begin(), ss.end(), socket), ss.end());
-        socketToAddressTable.erase(socket);
+    void endCongestion(Client& client)
+    {
+        client.isCongested = false;
+        timers.Cancel(client.graceTimer);
+        client.graceTimer = 0;
+        endReadPause(client);
+    }
 
-        for (auto s : readBlockSockets)
+    void endReadPause(Client& client)
+    {
+        if (!client.isPausingReads)
+            return;
+        client.isPausingReads = false;
+        timers.Cancel(client.readPauseTimer);
+        client.readPauseTimer = 0;
+        // the reactors with paused clients are woken to read them
+        if (--server.pausingClientCount == 0)
         {
-            if (s != listenSocket)
+            server.wakeAllReactors();
+        }
+    }
+
+    void onReadPauseOver(SlotHandle handle)
+    {
+        auto client = clients.Find(handle);
+        if (!client)
+            return;
+        client->readPauseTimer = 0;
+        server.logger->LogWarning("Client " + client->address.ToString() + " is still congested, the others are read again: "
+            + std::to_string(client->outbound.size()) + " messages, " + std::to_string(client->outboundBytes) + " bytes queued");
+        endReadPause(*client);
+    }
+
+    void onGracePeriodOver(SlotHandle handle)
+    {
+        auto found = clients.Find(handle);
+        if (!found)
+            return;
+        auto& client = *found;
+        client.graceTimer = 0;
+        size_t queuedMessages = client.outbound.size();
+        server.logger->LogWarning("Client " + client.address.ToString() + " is still congested after the grace period: "
+            + std::to_string(queuedMessages) + " messages, " + std::to_string(client.outboundBytes) + " bytes queued");
+
+        if (server.options.slowClientPolicy == SlowClientPolicy::Disconnect)
+        {
+            onClientDisconnect(handle);
+            return;
+        }
+
+        // a message which went out in part has to be finished, or the stream breaks
+        size_t keptCount = client.outboundOffset > 0 ? 1 : 0;
+        size_t droppedCount = 0;
+        while (client.outbound.size() > keptCount)
+        {
+            if (server.options.slowClientPolicy == SlowClientPolicy::DropOldest
+                && client.outboundBytes <= server.options.outboundLowWatermark)
+                break;
+            auto oldest = client.outbound.begin() + keptCount;
+            client.outboundBytes -= (*oldest)->GetLength();
+            client.outbound.erase(oldest);
+            ++droppedCount;
+        }
+        client.droppedMessages += droppedCount;
+        if (server.options.slowClientPolicy == SlowClientPolicy::Coalesce)
+        {
+            enqueue(client, encode("Skipped " + std::to_string(droppedCount) + " messages." + '\0'));
+        }
+
+        if (client.outboundBytes <= server.options.outboundLowWatermark)
+        {
+            endCongestion(client);
+        }
+        else
+        {
+            // the watermarks leave no room, e.g. a low watermark below one message
+            client.graceTimer = timers.Schedule(server.options.slowClientGracePeriod, [this, handle = client.handle] { onGracePeriodOver(handle); });
+        }
+    }
+
+    void resumePausedClients()
+    {
+        std::vector<SlotHandle> resuming;
+        resuming.swap(pausedClients);
+        // a line of a resumed client may congest another one and pause the rest again
+        for (auto handle : resuming)
+        {
+            auto client = clients.Find(handle);
+            if (client)
             {
-                s->Send(static_cast<const void*>(reply.c_str()), reply.length());
+                client->isReadPaused = false;
+                updateInterest(*client);
+                receiveFromClient(*client);
             }
         }
     }
 
-    void processDataFromClient(TCPSocketPtr socket, char * segment, int32_t dataReceived)
+    void flushPendingClients()
     {
-        std::string recvMsg = segment;
-        size_t msgLenght = recvMsg.length();
-        logger->LogInfo("Received msg from client. TransportSize=" + std::to_string(dataReceived)
-            + " bytes; MsgLenght=" + std::to_string(msgLenght));
-        logger->LogInfo("Msg: " + recvMsg);
+        // a broken connection is dropped after the pass, its notification makes another pass for the others
+        while (!pendingFlush.empty())
+        {
+            std::vector<SlotHandle> flushing;
+            flushing.swap(pendingFlush);
+            std::vector<SlotHandle> brokenClients;
+            for (auto handle : flushing)
+            {
+                auto client = clients.Find(handle);
+                if (!client)
+                    continue;
+                client->isFlushPending = false;
+                if (!flush(*client))
+                {
+                    brokenClients.push_back(handle);
+                }
+            }
+            for (auto handle : brokenClients)
+            {
+                onClientDisconnect(handle);
+            }
+        }
+    }
 
-        if(msgLenght == 0)
+    void acceptClients()
+    {
+        // edge triggered poller reports the listen socket once for the whole backlog, so it is drained
+        // until WSAEWOULDBLOCK; a failure only ends the drain when it keeps coming, then a timer tries again
+        for (int failures = 0; failures < MAX_ACCEPT_FAILURES; )
+        {
+            SocketAddress newClientAddress;
+            auto newSocket = listenSocket->Accept(newClientAddress);
+            if (!newSocket)
+            {
+                int error = SocketUtil::GetLastError();
+                if (error == WSAEWOULDBLOCK)
+                    return;
+                ++failures;
+                if (isOutOfDescriptors(error))
+                {
+                    rejectClient();
+                }
+                // anything else, e.g. ECONNABORTED, EINTR or ENOBUFS, concerns one connection or passes
+                continue;
+            }
+            failures = 0;
+
+            // with a listen socket per reactor the kernel has spread the clients already
+            size_t target = index;
+            if (server.listener->GetShardCount() < server.reactors.size())
+            {
+                target = server.nextReactor++ % server.reactors.size();
+            }
+
+            if (target == index)
+            {
+                onClientConnect(newSocket, newClientAddress);
+            }
+            else
+            {
+                outboxes[target].push_back({newSocket, newClientAddress, PooledBufferPtr(), nullptr});
+            }
+        }
+
+        if (acceptRetryTimer == 0)
+        {
+            server.logger->LogWarning("Accept keeps failing, the listen socket is tried again in "
+                + std::to_string(ACCEPT_RETRY_DELAY.count()) + " ms");
+            acceptRetryTimer = timers.Schedule(ACCEPT_RETRY_DELAY, [this]
+            {
+                acceptRetryTimer = 0;
+                acceptClients();
+            });
+        }
+    }
+
+    // Out of descriptors the client would stay in the backlog and the listen socket would not be reported
+    // again: the spare descriptor is given up to take the client off the backlog and close it.
+    void rejectClient()
+    {
+        if (!spareSocket)
+        {
+            spareSocket = SocketUtil::CreateTCPSocket(INET);
             return;
+        }
+        spareSocket.reset();
+        SocketAddress rejectedAddress;
+        if (listenSocket->Accept(rejectedAddress))
+        {
+            server.logger->LogWarning("Out of descriptors, rejected client: " + rejectedAddress.ToString());
+        }
+        spareSocket = SocketUtil::CreateTCPSocket(INET);
+    }
+
+    void receiveFromClient(Client& client)
+    {
+        for (int receives = 0; ; ++receives)
+        {
+            // while a congested client pauses the reads new lines stay in the socket and TCP holds their senders back
+            if (server.pausingClientCount > 0 || receives == MAX_RECEIVES_PER_ROUND)
+            {
+                if (!client.isReadPaused)
+                {
+                    client.isReadPaused = true;
+                    updateInterest(client);
+                    pausedClients.push_back(client.handle);
+                }
+                return;
+            }
+
+            // the segment is received behind the prefix of the sender, then the buffer holds the encoded line;
+            // clients send one line per GOOD_SEGMENT_SIZE segment, so no more is read, the rest is the next line
+            PooledBufferPtr message = server.messagePool.Acquire();
+            memcpy(message->GetData(), client.prefix.data(), client.prefix.length());
+            auto dataReceived = client.socket->Receive(message->GetData() + client.prefix.length(), GOOD_SEGMENT_SIZE);
+            if (dataReceived > 0)
+            {
+                message->SetLength(client.prefix.length() + dataReceived);
+                processDataFromClient(client, message);
+            }
+            else if (dataReceived == -WSAEWOULDBLOCK)
+            {
+                return;
+            }
+            else
+            {
+                // 0 is graceful shutdown, anything else is a broken connection
+                onClientDisconnect(client.handle);
+                return;
+            }
+        }
+    }
+
+    void processInbox()
+    {
+        // cleared before the inbox is read, so a push after the last pop wakes the reactor again
+        wakeup.Clear();
+        ShardBatch batch;
+        while (inbox.TryPop(batch))
+        {
+            for (auto& shardMessage : batch)
+            {
+                if (shardMessage.newClient)
+                {
+                    onClientConnect(shardMessage.newClient, shardMessage.newClientAddress);
+                }
+                else if (shardMessage.statsRequest)
+                {
+                    shardMessage.statsRequest->set_value(getClientQueueStats());
+                }
+                else
+                {
+                    enqueueForClients(shardMessage.message, 0);
+                }
+            }
+        }
+    }
 
-        std::string reply = socketToAddressTable.at(socket).ToString() + ": " + recvMsg + '\0';
+    std::vector<ClientQueueStats> getClientQueueStats() const
+    {
+        std::vector<ClientQueueStats> stats;
+        stats.reserve(clients.GetCount());
+        for (auto& client : clients)
+        {
+            stats.push_back({client.address.ToString(), index, client.outbound.size(), client.outboundBytes,
+                             client.peakOutboundBytes, client.droppedMessages, client.congestionCount});
+        }
+        return stats;
+    }
 
-        for (auto s : readBlockSockets)
+    void flushOutboxes()
+    {
+        for (size_t i = 0; i < outboxes.size(); ++i)
         {
-            if(s != listenSocket && s != socket)
+            if (!outboxes[i].empty())
             {
-                s->Send(static_cast<const void*>(reply.c_str()), reply.length());
+                Reactor& target = *server.reactors[i];
+                target.inbox.Push(std::move(outboxes[i]));
+                outboxes[i].clear();
+                target.wakeup.Notify();
             }
         }
     }
 
+    void run()
+    {
+        // socket errors of this reactor go to the logger of the server
+        SocketErrorScope errorScope(server.errorCallBack);
+        if (server.options.isPinned && SocketUtil::SetCurrentThreadAffinity(server.options.firstCpu + index) != NO_ERROR)
+        {
+            server.logger->LogWarning("Reactor " + std::to_string(index) + " is not pinned to CPU "
+                + std::to_string(server.options.firstCpu + index));
+        }
+
+        try
+        {
+            std::vector<SocketPollEvent> events;
+            while (server.isServerRunning)
+            {
+                // clients with data left from the last round only get a look at new events first
+                bool hasReadableClients = !pausedClients.empty() && server.pausingClientCount == 0;
+                if (poller.Wait(events, hasReadableClients ? 0 : timers.GetTimeoutMs()) < 0)
+                {
+                    throw ChatException("poller.Wait() < 0");
+                }
+
+                for (const auto& event : events)
+                {
+                    if (event.userData == nullptr)
+                    {
+                        acceptClients();
+                    }
+                    else if (event.userData == &wakeup)
+                    {
+                        processInbox();
+                    }
+                    else
+                    {
+                        // a client which left earlier in the round has no handle; when a new one took its slot
+                        // meanwhile, the event costs the new one a receive or flush which finds nothing
+                        SlotHandle handle = clients.GetHandle(event.userData);
+                        if (handle == 0)
+                            continue;
+                        auto& client = *clients.Find(handle);
+                        if (event.isWritable && !flush(client))
+                        {
+                            onClientDisconnect(handle);
+                            continue;
+                        }
+                        if (event.isReadable || event.isClosed)
+                        {
+                            receiveFromClient(client);
+                        }
+                    }
+                }
+                timers.Advance();
+                if (!pausedClients.empty() && server.pausingClientCount == 0)
+                {
+                    resumePausedClients();
+                }
+                flushPendingClients();
+                flushOutboxes();
+            }
+        }
+        catch (...)
+        {
+            server.stop(std::current_exception());
+        }
+    }
 };
 
-ServerCore::ServerCore(IUserInterfacePtr ui, ILoggerPtr logger)
+void ServerCore::impl::stop(std::exception_ptr reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (!failure)
+        {
+            failure = reason;
+        }
+    }
+    isServerRunning = false;
+    wakeAllReactors();
+}
+
+void ServerCore::impl::wakeAllReactors()
+{
+    for (auto& reactor : reactors)
+    {
+        reactor->wakeup.Notify();
+    }
+}
+
+ServerCore::ServerCore(IUserInterfacePtr ui, ILoggerPtr logger, ServerCoreOptions options)
 {
     SocketUtil::StaticInit();
-    std::function<void(std::string)> bindedCallBack = std::bind(serverErrorCallBack, logger, std::placeholders::_1);
-    SocketUtil::SetErrorCallBack(bindedCallBack);
     m_pimpl = std::make_unique<impl>();
+    // socket errors of this server go to its own logger, on every thread which runs a reactor
+    m_pimpl->errorCallBack = std::bind(serverErrorCallBack, logger, std::placeholders::_1);
     m_pimpl->ui = ui; // TODO read port
     m_pimpl->logger = logger;
-    m_pimpl->isServerRunning = false;
+    m_pimpl->options = options;
     m_pimpl->logger->LogInfo("ChatServer v0.1 started");
 }
 
@@ -106,55 +726,95 @@ ServerCore::~ServerCore()
 
 void ServerCore::start()
 {
-    m_pimpl->isServerRunning = true; // TODO
+    SocketErrorScope errorScope(m_pimpl->errorCallBack);
+#if !_WIN32
+    // a client which went away shows up as a failed SendV, not as a signal which ends the server
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
     auto ci = m_pimpl->ui->getConnectionInfo();
+    size_t reactorCount = m_pimpl->options.reactorCount;
+    if (reactorCount == 0)
+    {
+        reactorCount = std::max(1u, std::thread::hardware_concurrency());
+    }
 
-    m_pimpl->listenSocket = SocketUtil::CreateTCPSocket(INET);
+    // a SO_REUSEPORT listen socket per reactor where the platform has it, a single one otherwise;
+    // a restarted server gets its port back while old connections are in TIME_WAIT
+    ShardedListenerOptions listenerOptions;
+    listenerOptions.shardCount = reactorCount;
+    m_pimpl->listener = std::make_unique<ShardedListener>(listenerOptions);
     auto receivingAddress = SocketAddressFactory::CreateIPv4FromString(ci.ipV4_ip_port);
-    if(m_pimpl->listenSocket->Bind(*receivingAddress) != NO_ERROR)
+    if (m_pimpl->listener->Open(*receivingAddress) != NO_ERROR)
     {
         throw ChatException("Listen Socket Bind Errors");
     }
-    m_pimpl->logger->LogInfo("Listen raw=" + ci.ipV4_ip_port + "; converted=" + receivingAddress->ToString());
-    
-    if (m_pimpl->listenSocket->Listen() != NO_ERROR)
+    m_pimpl->logger->LogInfo("Listen raw=" + ci.ipV4_ip_port + "; converted=" + receivingAddress->ToString()
+        + "; reactors=" + std::to_string(reactorCount)
+        + "; listen sockets=" + std::to_string(m_pimpl->listener->GetShardCount()));
+
+    // all reactors exist before the first one runs, they push into each other
+    auto& reactors = m_pimpl->reactors;
+    reactors.resize(reactorCount);
+    for (size_t i = 0; i < reactorCount; ++i)
+    {
+        reactors[i] = std::make_unique<impl::Reactor>(*m_pimpl, i);
+        auto& reactor = *reactors[i];
+        if (reactor.wakeup.Open() != NO_ERROR)
+        {
+            throw ChatException("wakeup.Open() != NO_ERROR");
+        }
+        reactor.poller.Add(reactor.wakeup.GetSocket(), POLL_READ, &reactor.wakeup);
+        if (i < m_pimpl->listener->GetShardCount())
+        {
+            reactor.listenSocket = m_pimpl->listener->GetListenSocket(i);
+            reactor.spareSocket = SocketUtil::CreateTCPSocket(INET);
+            reactor.poller.Add(reactor.listenSocket, POLL_READ, nullptr);
+        }
+    }
+
+    m_pimpl->isServerRunning = true;
+    for (auto& reactor : reactors)
+    {
+        reactor->thread = std::thread(&impl::Reactor::run, reactor.get());
+    }
+    for (auto& reactor : reactors)
     {
-        throw ChatException("listenSocket->Listen() != NO_ERROR");
+        reactor->thread.join();
     }
 
-    m_pimpl->readBlockSockets.push_back(m_pimpl->listenSocket);
+    if (m_pimpl->failure)
+    {
+        std::rethrow_exception(m_pimpl->failure);
+    }
+}
 
-    while (m_pimpl->isServerRunning)
+std::vector<ClientQueueStats> ServerCore::getClientQueueStats()
+{
+    std::vector<ClientQueueStats> stats;
+    if (!m_pimpl->isServerRunning)
     {
-        std::vector<TCPSocketPtr> readableSockets;
-        auto isPacketReceived = SocketUtil::Select(&m_pimpl->readBlockSockets, &readableSockets,
-            nullptr, nullptr, nullptr, nullptr);
+        return stats;
+    }
 
-        if(isPacketReceived)
+    // every reactor answers for its own clients on its own thread
+    std::vector<std::future<std::vector<ClientQueueStats>>> answers;
+    for (auto& reactor : m_pimpl->reactors)
+    {
+        auto request = std::make_shared<ClientStatsPromise>();
+        answers.push_back(request->get_future());
+        ShardBatch batch;
+        batch.push_back({nullptr, SocketAddress(), PooledBufferPtr(), request});
+        reactor->inbox.Push(std::move(batch));
+        reactor->wakeup.Notify();
+    }
+    for (auto& answer : answers)
+    {
+        // a reactor which stopped meanwhile does not answer
+        if (answer.wait_for(std::chrono::seconds(1)) == std::future_status::ready)
         {
-            for(auto socket : readableSockets)
-            {
-                if(socket == m_pimpl->listenSocket)
-                {
-                    SocketAddress newClientAddress;
-                    auto newSocket = m_pimpl->listenSocket->Accept(newClientAddress);
-                    m_pimpl->onClientConnect(newSocket, newClientAddress);
-                }
-                else
-                {
-                    char segment[GOOD_SEGMENT_SIZE];
-                    auto dataReceived = socket->Receive(segment, GOOD_SEGMENT_SIZE);
-                    if(dataReceived > 0)
-                    {
-                        m_pimpl->processDataFromClient(socket, segment, dataReceived);
-                    }
-                    else if(dataReceived == -WSAECONNRESET)
-                    {
-                        m_pimpl->onClientDisconnect(socket);
-                    }
-                }
-            }
+            auto reactorStats = answer.get();
+            stats.insert(stats.end(), reactorStats.begin(), reactorStats.end());
         }
-
     }
+    return stats;
 }
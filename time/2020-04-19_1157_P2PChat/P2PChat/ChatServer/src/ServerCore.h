@@ -1,15 +1,62 @@
 #pragma once
 
+#include <chrono>
+#include <vector>
+
 #include "ChatITF\ILogger.h"
 #include "ChatITF\IUserInterface.h"
 
+// What happens to a client which stays congested for the whole grace period.
+enum class SlowClientPolicy
+{
+    // the oldest queued messages are dropped until the queue is at the low watermark
+    DropOldest,
+    // the queued messages are replaced by one notice of how many were skipped
+    Coalesce,
+    Disconnect
+};
+
+struct ServerCoreOptions
+{
+    // reactor threads, each with its own shard of the clients; 0 starts one per hardware thread
+    size_t reactorCount = 0;
+    // pins reactor i to CPU firstCpu + i
+    bool isPinned = false;
+    size_t firstCpu = 0;
+
+    // Bytes queued for one client. Above the high watermark the client is congested until it is back at the
+    // low watermark or its grace period is over. The server stops reading lines from everybody for at most
+    // maxReadPause of it, so a burst is held back by TCP; after that only the queue of the client grows.
+    size_t outboundHighWatermark = 256 * 1024;
+    size_t outboundLowWatermark = 64 * 1024;
+    SlowClientPolicy slowClientPolicy = SlowClientPolicy::Disconnect;
+    std::chrono::milliseconds slowClientGracePeriod{3000};
+    std::chrono::milliseconds maxReadPause{200};
+};
+
+struct ClientQueueStats
+{
+    std::string address;
+    size_t reactor;
+    // messages and bytes waiting for the socket
+    size_t queuedMessages;
+    size_t queuedBytes;
+    size_t peakQueuedBytes;
+    uint64_t droppedMessages;
+    // times the queue went above the high watermark
+    uint64_t congestionCount;
+};
+
 class ServerCore
 {
     struct impl;
     std::unique_ptr<impl> m_pimpl;
 
 public:
-    ServerCore(IUserInterfacePtr ui, ILoggerPtr logger);
+    ServerCore(IUserInterfacePtr ui, ILoggerPtr logger, ServerCoreOptions options = ServerCoreOptions());
     ~ServerCore();
-    void start();    
+    void start();
+    // The outbound queues of all clients, asked from the reactors while start() runs on another thread;
+    // empty when the server is not running.
+    std::vector<ClientQueueStats> getClientQueueStats();
 };
\ No newline at end of file
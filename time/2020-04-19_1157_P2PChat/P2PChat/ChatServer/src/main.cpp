@@ -20,7 +20,30 @@ int main(int argc, char** argv)
 
     try
     {
-        ServerCore chat(ui, lg);
+        // ChatServer <ip:port> [reactors] [firstCpu|-] [drop|coalesce|disconnect],
+        // a first CPU pins the reactors to consecutive CPUs, the last one is the slow client policy
+        ServerCoreOptions options;
+        if (argc > 2)
+            options.reactorCount = std::stoul(argv[2]);
+        if (argc > 3 && std::string(argv[3]) != "-")
+        {
+            options.isPinned = true;
+            options.firstCpu = std::stoul(argv[3]);
+        }
+        if (argc > 4)
+        {
+            std::string policy = argv[4];
+            if (policy == "drop")
+                options.slowClientPolicy = SlowClientPolicy::DropOldest;
+            else if (policy == "coalesce")
+                options.slowClientPolicy = SlowClientPolicy::Coalesce;
+            else if (policy == "disconnect")
+                options.slowClientPolicy = SlowClientPolicy::Disconnect;
+            else
+                throw ChatException("Unknown slow client policy: " + policy);
+        }
+
+        ServerCore chat(ui, lg, options);
         chat.start();
     }
     catch (const ChatException& e)
@@ -11,20 +11,23 @@ struct SocketConnectionPoint::impl {
     std::mutex socketMutex;
     CpStatus status;
     ILoggerPtr logger;
+    SocketErrorCallBack errorCallBack;
+    // receive buffers of one segment, instead of a segment on the stack
+    BufferPool segmentPool{GOOD_SEGMENT_SIZE, 16, 4};
 };
 
-void errorCallBack(ILoggerPtr logger, std::string error)
+void errorCallBack(ILoggerPtr logger, const SocketError& error)
 {
-    logger->LogTrace(error);
+    logger->LogTrace(std::string(error.operation) + ". GLE=" + std::to_string(error.error));
 }
 
 SocketConnectionPoint::SocketConnectionPoint(ILoggerPtr logger)
 {
     SocketUtil::StaticInit();
-    std::function<void(std::string)> bindedCallBack = std::bind(errorCallBack, logger, std::placeholders::_1);
-    SocketUtil::SetErrorCallBack(bindedCallBack);
     m_pimpl = std::make_unique<impl>();
     m_pimpl->logger = logger;
+    // every method opens a SocketErrorScope, so the errors reach this logger on the UI and the receiving thread
+    m_pimpl->errorCallBack = std::bind(errorCallBack, logger, std::placeholders::_1);
 }
 
 SocketConnectionPoint::~SocketConnectionPoint()
@@ -35,6 +38,7 @@ SocketConnectionPoint::~SocketConnectionPoint()
 
 void SocketConnectionPoint::accept(ConnectionInfo connectInfo)
 {
+    SocketErrorScope errorScope(m_pimpl->errorCallBack);
     TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
     auto receivingAddress = SocketAddressFactory::CreateIPv4FromString(connectInfo.ipV4_ip_port);
     m_pimpl->logger->LogInfo("Binding " + receivingAddress->ToString());
@@ -66,6 +70,7 @@ void SocketConnectionPoint::accept(ConnectionInfo connectInfo)
 
 void SocketConnectionPoint::connect(ConnectionInfo connectInfo)
 {
+    SocketErrorScope errorScope(m_pimpl->errorCallBack);
     m_pimpl->logger->LogTrace("SocketConnectionPoint::connect");
     SocketAddressPtr clientAddress = SocketAddressFactory::CreateIPv4FromString(connectInfo.ipV4_ip_port);
     if(!clientAddress)
@@ -87,6 +92,7 @@ void SocketConnectionPoint::connect(ConnectionInfo connectInfo)
 
 void SocketConnectionPoint::send(std::string msg)
 {
+    SocketErrorScope errorScope(m_pimpl->errorCallBack);
     std::lock_guard<std::mutex> lg(m_pimpl->socketMutex);
     msg.resize(GOOD_SEGMENT_SIZE-1);
     msg += '\0';
@@ -101,10 +107,11 @@ void SocketConnectionPoint::send(std::string msg)
 
 std::string SocketConnectionPoint::receive()
 {
+    SocketErrorScope errorScope(m_pimpl->errorCallBack);
     std::lock_guard<std::mutex> lg(m_pimpl->socketMutex);
-    char segment[GOOD_SEGMENT_SIZE] = {};
+    PooledBufferPtr segment = m_pimpl->segmentPool.Acquire();
 
-    int bytesReceived = m_pimpl->clientSocket->Receive(segment, 0);
+    int bytesReceived = m_pimpl->clientSocket->Receive(segment->GetData(), 0);
     if (bytesReceived < 0 && -bytesReceived != WSAEWOULDBLOCK)
     {
         m_pimpl->status = CpStatus::ConnectionError;
@@ -112,10 +119,10 @@ std::string SocketConnectionPoint::receive()
     }
     else
     {
-        bytesReceived = m_pimpl->clientSocket->Receive(segment, GOOD_SEGMENT_SIZE);
+        bytesReceived = m_pimpl->clientSocket->Receive(*segment);
     }
 
-    return segment;
+    return std::string(segment->GetData(), strnlen(segment->GetData(), segment->GetLength()));
 }
 
 void SocketConnectionPoint::disconnect()
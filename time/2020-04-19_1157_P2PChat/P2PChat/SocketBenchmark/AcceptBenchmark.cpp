@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Connection rate of ShardedListener with one listen socket and with one SO_REUSEPORT socket per shard.
+// Client threads connect and close as fast as they can, the accept loops close every connection at once.
+
+namespace
+{
+    const uint16_t ACCEPT_PORT = 56808;
+
+    struct AcceptBenchmarkOptions
+    {
+        int connections = 4000;
+        size_t shards = 0;
+        int clientThreads = 4;
+    };
+
+    void RunClients(const AcceptBenchmarkOptions& inOptions, std::atomic<int>& ioFailures)
+    {
+        vector<std::thread> clients;
+        for (int thread = 0; thread < inOptions.clientThreads; ++thread)
+        {
+            clients.emplace_back([&, thread]
+            {
+                for (int i = thread; i < inOptions.connections; i += inOptions.clientThreads)
+                {
+                    TCPSocketPtr socket = SocketUtil::CreateTCPSocket(INET);
+                    if (!socket || socket->Connect(SocketAddress(INADDR_LOOPBACK, ACCEPT_PORT)) != NO_ERROR)
+                    {
+                        ++ioFailures;
+                    }
+                }
+            });
+        }
+        for (std::thread& client : clients)
+        {
+            client.join();
+        }
+    }
+
+    bool RunListener(const AcceptBenchmarkOptions& inOptions, size_t inShards)
+    {
+        ShardedListenerOptions listenerOptions;
+        listenerOptions.shardCount = inShards;
+        ShardedListener listener(listenerOptions);
+        if (listener.Open(SocketAddress(INADDR_LOOPBACK, ACCEPT_PORT)) != NO_ERROR)
+        {
+            std::cout << inShards << " shards: open failed" << std::endl;
+            return false;
+        }
+
+        std::atomic<int> accepted(0);
+        listener.Start([&](size_t, TCPSocketPtr, const SocketAddress&) { ++accepted; });
+
+        std::atomic<int> failures(0);
+        auto start = std::chrono::steady_clock::now();
+        RunClients(inOptions, failures);
+        while (accepted + failures < inOptions.connections)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        listener.Stop();
+
+        std::cout << listener.GetShardCount() << " shards: " << static_cast<long>(accepted / elapsed.count())
+            << " connections/s, accepted per shard:";
+        for (size_t shard = 0; shard < listener.GetShardCount(); ++shard)
+        {
+            std::cout << " " << listener.GetAcceptCount(shard);
+        }
+        std::cout << ", " << failures << " failed" << std::endl;
+        return failures == 0;
+    }
+}
+
+int RunAcceptBenchmark(const std::vector<std::string>& args)
+{
+    AcceptBenchmarkOptions options;
+    if (args.size() > 0) options.connections = std::stoi(args[0]);
+    if (args.size() > 1) options.shards = std::stoi(args[1]);
+    if (args.size() > 2) options.clientThreads = std::stoi(args[2]);
+
+    size_t shards = options.shards > 0 ? options.shards : std::max(2u, std::thread::hardware_concurrency());
+    std::cout << "accept: " << options.connections << " connections from " << options.clientThreads
+        << " threads, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    bool isDone = RunListener(options, 1);
+    isDone = RunListener(options, shards) && isDone;
+    return isDone ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// unordered_map<SocketAddress, ...> lookups with many peers, the way a server finds the state of a sender.
+// Peers are clients behind NATs: consecutive IPv4 addresses with many source ports each, and IPv6 addresses
+// of one /64 prefix. The hash of SocketAddress is compared with the previous one, which ORed the address,
+// the shifted port and the family together.
+
+namespace
+{
+    struct AddressOptions
+    {
+        int peers = 100000;
+        int portsPerAddress = 100;
+        int rounds = 20;
+    };
+
+    struct LegacyHash
+    {
+        size_t operator()(const SocketAddress& inAddress) const
+        {
+            const sockaddr_in* address = reinterpret_cast<const sockaddr_in*>(inAddress.GetSockAddr());
+            return address->sin_addr.s_addr | (static_cast<uint32_t>(address->sin_port) << 13) | address->sin_family;
+        }
+    };
+
+    vector<SocketAddress> CreateIPv4Peers(const AddressOptions& inOptions)
+    {
+        vector<SocketAddress> peers;
+        for (int i = 0; i < inOptions.peers; ++i)
+        {
+            uint32_t address = (10u << 24) + 1 + i / inOptions.portsPerAddress;
+            uint16_t port = static_cast<uint16_t>(40000 + i % inOptions.portsPerAddress);
+            peers.emplace_back(address, port);
+        }
+        return peers;
+    }
+
+    vector<SocketAddress> CreateIPv6Peers(const AddressOptions& inOptions)
+    {
+        vector<SocketAddress> peers;
+        for (int i = 0; i < inOptions.peers; ++i)
+        {
+            //2001:db8::<host>
+            in6_addr address;
+            memset(&address, 0, sizeof(address));
+            address.s6_addr[0] = 0x20;
+            address.s6_addr[1] = 0x01;
+            address.s6_addr[2] = 0x0d;
+            address.s6_addr[3] = 0xb8;
+            uint32_t host = 1 + i / inOptions.portsPerAddress;
+            for (int b = 0; b < 4; ++b)
+            {
+                address.s6_addr[15 - b] = static_cast<uint8_t>(host >> (8 * b));
+            }
+            peers.emplace_back(address, static_cast<uint16_t>(40000 + i % inOptions.portsPerAddress));
+        }
+        return peers;
+    }
+
+    template <typename Hash>
+    void MeasureLookups(const char* inName, const vector<SocketAddress>& inPeers, const AddressOptions& inOptions)
+    {
+        std::unordered_map<SocketAddress, int, Hash> table;
+        table.reserve(inPeers.size());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < inPeers.size(); ++i)
+        {
+            table.emplace(inPeers[i], static_cast<int>(i));
+        }
+        std::chrono::duration<double> insertTime = std::chrono::steady_clock::now() - start;
+
+        vector<SocketAddress> lookups = inPeers;
+        std::shuffle(lookups.begin(), lookups.end(), std::mt19937(1));
+        long found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int round = 0; round < inOptions.rounds; ++round)
+        {
+            for (const SocketAddress& address : lookups)
+            {
+                found += table.count(address);
+            }
+        }
+        std::chrono::duration<double> lookupTime = std::chrono::steady_clock::now() - start;
+
+        unordered_set<size_t> hashes;
+        size_t longestBucket = 0;
+        for (size_t b = 0; b < table.bucket_count(); ++b)
+        {
+            longestBucket = std::max(longestBucket, table.bucket_size(b));
+        }
+        for (const SocketAddress& address : inPeers)
+        {
+            hashes.insert(Hash()(address));
+        }
+
+        std::cout << "  " << inName << ": insert " << insertTime.count() * 1e9 / inPeers.size() << " ns, lookup "
+            << lookupTime.count() * 1e9 / found << " ns, " << hashes.size() << " distinct hashes, longest bucket "
+            << longestBucket << std::endl;
+    }
+}
+
+int RunAddressBenchmark(const std::vector<std::string>& args)
+{
+    AddressOptions options;
+    if (args.size() > 0) options.peers = std::stoi(args[0]);
+    if (args.size() > 1) options.portsPerAddress = std::stoi(args[1]);
+    if (args.size() > 2) options.rounds = std::stoi(args[2]);
+
+    std::cout << "address: " << options.peers << " peers, " << options.portsPerAddress << " ports per address"
+        << std::endl;
+
+    vector<SocketAddress> ipv4Peers = CreateIPv4Peers(options);
+    std::cout << "IPv4 " << ipv4Peers.front().ToString() << " .. " << ipv4Peers.back().ToString() << std::endl;
+    MeasureLookups<LegacyHash>("or of fields", ipv4Peers, options);
+    MeasureLookups<std::hash<SocketAddress>>("mixed", ipv4Peers, options);
+
+    vector<SocketAddress> ipv6Peers = CreateIPv6Peers(options);
+    std::cout << "IPv6 " << ipv6Peers.front().ToString() << " .. " << ipv6Peers.back().ToString() << std::endl;
+    MeasureLookups<std::hash<SocketAddress>>("mixed", ipv6Peers, options);
+    return 0;
+}
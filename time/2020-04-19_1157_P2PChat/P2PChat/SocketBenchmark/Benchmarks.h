@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Every benchmark gets the arguments which follow its name in the command line.
+int RunAcceptBenchmark(const std::vector<std::string>& args);
+int RunAddressBenchmark(const std::vector<std::string>& args);
+int RunBufferBenchmark(const std::vector<std::string>& args);
+int RunConnectBenchmark(const std::vector<std::string>& args);
+int RunConnectionBenchmark(const std::vector<std::string>& args);
+int RunEchoBenchmark(const std::vector<std::string>& args);
+int RunErrorBenchmark(const std::vector<std::string>& args);
+int RunLocalBenchmark(const std::vector<std::string>& args);
+int RunLoopbackBenchmark(const std::vector<std::string>& args);
+int RunTimerBenchmark(const std::vector<std::string>& args);
+int RunUdpBenchmark(const std::vector<std::string>& args);
+int RunReactorBenchmark(const std::vector<std::string>& args);
+int RunRelayBenchmark(const std::vector<std::string>& args);
+int RunReliableBenchmark(const std::vector<std::string>& args);
+int RunResolveBenchmark(const std::vector<std::string>& args);
@@ -0,0 +1,158 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Cost of getting a receive buffer and handing a message to recipients, per message:
+//  - segment + strings: a stack segment copied into a std::string, one more string per recipient
+//    (what ServerCore did before BufferPool)
+//  - new[] + shared_ptr: a heap buffer shared between the recipients
+//  - BufferPool: a pooled buffer shared through PooledBufferPtr
+// Every thread runs the same loop; then one thread acquires and another releases, which moves buffers
+// between the thread caches.
+
+namespace
+{
+    struct BufferBenchmarkOptions
+    {
+        int threads = 4;
+        int messages = 1000000;
+        int recipients = 8;
+        int messageSize = 300;
+    };
+
+    // keeps the compiler from dropping the copies
+    std::atomic<size_t> gChecksum(0);
+
+    void RunStrings(const BufferBenchmarkOptions& inOptions)
+    {
+        size_t checksum = 0;
+        for (int i = 0; i < inOptions.messages; ++i)
+        {
+            char segment[2048];
+            std::memset(segment, 'a' + i % 26, inOptions.messageSize);
+            segment[inOptions.messageSize - 1] = '\0';
+            std::string message = segment;
+            for (int recipient = 0; recipient < inOptions.recipients; ++recipient)
+            {
+                std::string copy = message;
+                checksum += copy.size();
+            }
+        }
+        gChecksum += checksum;
+    }
+
+    void RunSharedHeap(const BufferBenchmarkOptions& inOptions)
+    {
+        size_t checksum = 0;
+        for (int i = 0; i < inOptions.messages; ++i)
+        {
+            shared_ptr<char> buffer(new char[2048], std::default_delete<char[]>());
+            std::memset(buffer.get(), 'a' + i % 26, inOptions.messageSize);
+            for (int recipient = 0; recipient < inOptions.recipients; ++recipient)
+            {
+                shared_ptr<char> copy = buffer;
+                checksum += copy.get()[0];
+            }
+        }
+        gChecksum += checksum;
+    }
+
+    void RunPool(BufferPool& ioPool, const BufferBenchmarkOptions& inOptions)
+    {
+        size_t checksum = 0;
+        for (int i = 0; i < inOptions.messages; ++i)
+        {
+            PooledBufferPtr buffer = ioPool.Acquire();
+            std::memset(buffer->GetData(), 'a' + i % 26, inOptions.messageSize);
+            buffer->SetLength(inOptions.messageSize);
+            for (int recipient = 0; recipient < inOptions.recipients; ++recipient)
+            {
+                PooledBufferPtr copy = buffer;
+                checksum += copy->GetLength();
+            }
+        }
+        gChecksum += checksum;
+    }
+
+    template <typename Loop>
+    void Measure(const char* inName, const BufferBenchmarkOptions& inOptions, Loop inLoop)
+    {
+        vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int thread = 0; thread < inOptions.threads; ++thread)
+        {
+            threads.emplace_back(inLoop);
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        double messages = static_cast<double>(inOptions.threads) * inOptions.messages;
+        std::cout << inName << ": " << elapsed.count() / messages << " ns per message" << std::endl;
+    }
+
+    // One thread receives into pooled buffers, another one sends and releases them.
+    bool MeasureHandOver(BufferPool& ioPool, const BufferBenchmarkOptions& inOptions)
+    {
+        const size_t QUEUE_SIZE = 1024;
+        vector<PooledBufferPtr> queue(QUEUE_SIZE);
+        std::atomic<size_t> head(0), tail(0);
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&]
+        {
+            for (int i = 0; i < inOptions.messages; ++i)
+            {
+                while (tail.load(std::memory_order_acquire) == head.load(std::memory_order_relaxed))
+                {
+                    std::this_thread::yield();
+                }
+                size_t index = head.load(std::memory_order_relaxed);
+                queue[index % QUEUE_SIZE].Reset();
+                head.store(index + 1, std::memory_order_release);
+            }
+        });
+        for (int i = 0; i < inOptions.messages; ++i)
+        {
+            size_t index = tail.load(std::memory_order_relaxed);
+            while (index - head.load(std::memory_order_acquire) >= QUEUE_SIZE)
+            {
+                std::this_thread::yield();
+            }
+            queue[index % QUEUE_SIZE] = ioPool.Acquire();
+            tail.store(index + 1, std::memory_order_release);
+        }
+        consumer.join();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "BufferPool hand over between threads: " << elapsed.count() / inOptions.messages << " ns per message, "
+            << ioPool.GetSlabCount() << " slabs, " << ioPool.GetUsedCount() << " buffers in use" << std::endl;
+        return ioPool.GetUsedCount() == 0;
+    }
+}
+
+int RunBufferBenchmark(const std::vector<std::string>& args)
+{
+    BufferBenchmarkOptions options;
+    if (args.size() > 0) options.threads = std::stoi(args[0]);
+    if (args.size() > 1) options.messages = std::stoi(args[1]);
+    if (args.size() > 2) options.recipients = std::stoi(args[2]);
+    if (args.size() > 3) options.messageSize = std::min(std::stoi(args[3]), 2048);
+
+    std::cout << "buffers: " << options.threads << " threads, " << options.messages << " messages of "
+        << options.messageSize << " bytes to " << options.recipients << " recipients" << std::endl;
+
+    BufferPool pool(2048);
+    Measure("segment + strings", options, [&] { RunStrings(options); });
+    Measure("new[] + shared_ptr", options, [&] { RunSharedHeap(options); });
+    Measure("BufferPool", options, [&] { RunPool(pool, options); });
+    std::cout << "BufferPool: " << pool.GetSlabCount() << " slabs for " << options.threads << " threads" << std::endl;
+    return MeasureHandOver(pool, options) ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Latency of a one byte request on loopback with connection setup in the request path
+// (resolve, connect, close every time) and with connections from ConnectionPool.
+// Then TCPConnector races a dead address against a live one.
+
+namespace
+{
+    const uint16_t CONNECT_PORT = 56806;
+    // TEST-NET-1, nothing answers there
+    const uint32_t UNREACHABLE_ADDRESS = (192u << 24) | (0 << 16) | (2 << 8) | 1;
+
+    struct ConnectBenchmarkOptions
+    {
+        int requests = 2000;
+        int warmConnections = 4;
+    };
+
+    // Answers every byte with the same byte until it is stopped.
+    void RunServer(const TCPSocketPtr& inListenSocket, const std::atomic<bool>& inShouldStop)
+    {
+        vector<TCPSocketPtr> sockets{inListenSocket};
+        vector<TCPSocketPtr> readable;
+        while (!inShouldStop)
+        {
+            if (SocketUtil::Select(&sockets, &readable, nullptr, nullptr, nullptr, nullptr, 50) <= 0)
+            {
+                continue;
+            }
+            for (const TCPSocketPtr& socket : readable)
+            {
+                if (socket == inListenSocket)
+                {
+                    SocketAddress address;
+                    if (TCPSocketPtr client = inListenSocket->Accept(address))
+                    {
+                        sockets.push_back(client);
+                    }
+                    continue;
+                }
+                char byte;
+                if (socket->Receive(&byte, 1) <= 0 || socket->Send(&byte, 1) != 1)
+                {
+                    sockets.erase(std::find(sockets.begin(), sockets.end(), socket));
+                }
+            }
+        }
+    }
+
+    bool Request(const TCPSocketPtr& inSocket)
+    {
+        char byte = 'x';
+        return inSocket->Send(&byte, 1) == 1 && inSocket->Receive(&byte, 1) == 1;
+    }
+
+    double ToMicroseconds(std::chrono::steady_clock::duration inDuration)
+    {
+        return std::chrono::duration<double, std::micro>(inDuration).count();
+    }
+}
+
+int RunConnectBenchmark(const std::vector<std::string>& args)
+{
+    ConnectBenchmarkOptions options;
+    if (args.size() > 0) options.requests = std::stoi(args[0]);
+    if (args.size() > 1) options.warmConnections = std::stoi(args[1]);
+
+    const string endpoint = "localhost:" + std::to_string(CONNECT_PORT);
+    std::cout << "connect: " << options.requests << " requests to " << endpoint << std::endl;
+
+    TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
+    if (!listenSocket || listenSocket->Bind(SocketAddress(INADDR_LOOPBACK, CONNECT_PORT)) != NO_ERROR
+        || listenSocket->Listen(128) != NO_ERROR)
+    {
+        std::cout << "connect: listen failed" << std::endl;
+        return 1;
+    }
+    std::atomic<bool> shouldStop(false);
+    std::thread server(RunServer, listenSocket, std::cref(shouldStop));
+
+    int failures = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.requests; ++i)
+    {
+        vector<SocketAddress> addresses;
+        SocketAddressFactory::CreateAllFromString(endpoint, addresses, AF_INET);
+        TCPSocketPtr socket = TCPConnector::Connect(addresses);
+        failures += socket && Request(socket) ? 0 : 1;
+    }
+    std::cout << "connect per request: " << ToMicroseconds(std::chrono::steady_clock::now() - start) / options.requests
+        << " us per request" << std::endl;
+
+    {
+        ConnectionPool pool;
+        pool.Prewarm(endpoint, options.warmConnections);
+        while (pool.GetIdleCount(endpoint) < static_cast<size_t>(options.warmConnections))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < options.requests; ++i)
+        {
+            TCPSocketPtr socket = pool.Acquire(endpoint);
+            bool isDone = socket && Request(socket);
+            failures += isDone ? 0 : 1;
+            if (isDone)
+            {
+                pool.Release(endpoint, socket);
+            }
+        }
+        std::cout << "ConnectionPool: " << ToMicroseconds(std::chrono::steady_clock::now() - start) / options.requests
+            << " us per request, " << pool.GetIdleCount(endpoint) << " idle connections" << std::endl;
+    }
+
+    ConnectOptions raceOptions;
+    raceOptions.attemptTimeoutMs = 2000;
+    start = std::chrono::steady_clock::now();
+    int error = NO_ERROR;
+    TCPSocketPtr raced = TCPConnector::Connect({SocketAddress(UNREACHABLE_ADDRESS, CONNECT_PORT),
+                                                SocketAddress(INADDR_LOOPBACK, CONNECT_PORT)}, raceOptions, &error);
+    std::cout << "dead address first: " << (raced ? "connected" : "failed") << " after "
+        << ToMicroseconds(std::chrono::steady_clock::now() - start) / 1000 << " ms (attempt delay "
+        << raceOptions.attemptDelayMs << " ms)" << std::endl;
+    failures += raced ? 0 : 1;
+
+    shouldStop = true;
+    server.join();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// The client table of a chat server under churn: every round broadcasts one message to all connections,
+// handles events of a tenth of them and replaces a hundredth by new connections. The table ChatServer had,
+// a std::map from the socket to the client and a vector of pointers for the broadcast, erased with std::remove,
+// against SlotMap, where the poller event carries the handle. No sockets are opened, the keys only stand for them.
+
+namespace
+{
+    struct ConnectionBenchmarkOptions
+    {
+        int maxConnections = 100000;
+        int rounds = 100;
+    };
+
+    struct Connection
+    {
+        SocketAddress address;
+        size_t queuedBytes = 0;
+        uint64_t queuedMessages = 0;
+        uint64_t events = 0;
+    };
+
+    typedef shared_ptr<int> SocketKey;
+
+    struct Timings
+    {
+        double broadcastSeconds = 0;
+        double eventSeconds = 0;
+        double churnSeconds = 0;
+        uint64_t checksum = 0;
+    };
+
+    class MapTable
+    {
+    public:
+        typedef SocketKey Id;
+
+        Id Add()
+        {
+            SocketKey key = std::make_shared<int>(0);
+            Connection& connection = mConnections[key];
+            mBroadcastList.push_back(&connection);
+            return key;
+        }
+
+        void Remove(const Id& inId)
+        {
+            Connection* connection = &mConnections.at(inId);
+            mBroadcastList.erase(std::remove(mBroadcastList.begin(), mBroadcastList.end(), connection), mBroadcastList.end());
+            mConnections.erase(inId);
+        }
+
+        Connection& Get(const Id& inId) { return mConnections.at(inId); }
+
+        template <typename Function>
+        void ForEach(Function inFunction)
+        {
+            for (Connection* connection : mBroadcastList)
+            {
+                inFunction(*connection);
+            }
+        }
+
+    private:
+        std::map<SocketKey, Connection> mConnections;
+        vector<Connection*> mBroadcastList;
+    };
+
+    class SlotTable
+    {
+    public:
+        typedef SlotHandle Id;
+
+        Id Add() { return mConnections.Add(Connection()); }
+        void Remove(Id inId) { mConnections.Remove(inId); }
+        Connection& Get(Id inId) { return *mConnections.Find(inId); }
+
+        template <typename Function>
+        void ForEach(Function inFunction)
+        {
+            for (Connection& connection : mConnections)
+            {
+                inFunction(connection);
+            }
+        }
+
+    private:
+        SlotMap<Connection> mConnections;
+    };
+
+    template <typename Table>
+    Timings Measure(int inConnections, const ConnectionBenchmarkOptions& inOptions)
+    {
+        typedef std::chrono::steady_clock Clock;
+        Table table;
+        vector<typename Table::Id> ids;
+        for (int i = 0; i < inConnections; ++i)
+        {
+            ids.push_back(table.Add());
+        }
+
+        //the same sequence of events and disconnects for both tables
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+        int eventsPerRound = std::max(inConnections / 10, 1);
+        int churnPerRound = std::max(inConnections / 100, 1);
+        Timings timings;
+        for (int round = 0; round < inOptions.rounds; ++round)
+        {
+            auto start = Clock::now();
+            table.ForEach([](Connection& connection)
+            {
+                connection.queuedBytes += 64;
+                ++connection.queuedMessages;
+            });
+            auto broadcastEnd = Clock::now();
+
+            for (int i = 0; i < eventsPerRound; ++i)
+            {
+                Connection& connection = table.Get(ids[pick(random)]);
+                ++connection.events;
+                connection.queuedBytes = 0;
+            }
+            auto eventEnd = Clock::now();
+
+            for (int i = 0; i < churnPerRound; ++i)
+            {
+                size_t leaving = pick(random);
+                table.Remove(ids[leaving]);
+                ids[leaving] = table.Add();
+            }
+            auto churnEnd = Clock::now();
+
+            timings.broadcastSeconds += std::chrono::duration<double>(broadcastEnd - start).count();
+            timings.eventSeconds += std::chrono::duration<double>(eventEnd - broadcastEnd).count();
+            timings.churnSeconds += std::chrono::duration<double>(churnEnd - eventEnd).count();
+        }
+        table.ForEach([&](Connection& connection) { timings.checksum += connection.queuedMessages + connection.events; });
+        return timings;
+    }
+
+    void Print(const char* inName, const Timings& inTimings, int inConnections, const ConnectionBenchmarkOptions& inOptions)
+    {
+        double rounds = inOptions.rounds;
+        std::cout << "  " << inName
+            << ": broadcast " << inTimings.broadcastSeconds * 1e9 / rounds / inConnections << " ns/connection"
+            << ", event lookup " << inTimings.eventSeconds * 1e9 / rounds / std::max(inConnections / 10, 1) << " ns"
+            << ", disconnect + connect " << inTimings.churnSeconds * 1e9 / rounds / std::max(inConnections / 100, 1) << " ns"
+            << std::endl;
+    }
+}
+
+int RunConnectionBenchmark(const std::vector<std::string>& args)
+{
+    ConnectionBenchmarkOptions options;
+    if (args.size() > 0) options.maxConnections = std::stoi(args[0]);
+    if (args.size() > 1) options.rounds = std::max(std::stoi(args[1]), 1);
+
+    std::cout << "connections: " << options.rounds << " rounds of a broadcast, events on a tenth of the connections "
+        << "and a hundredth replaced" << std::endl;
+    int result = 0;
+    for (int connections = 1000; connections <= options.maxConnections; connections *= 10)
+    {
+        std::cout << connections << " connections" << std::endl;
+        Timings mapTimings = Measure<MapTable>(connections, options);
+        Timings slotTimings = Measure<SlotTable>(connections, options);
+        Print("map + vector", mapTimings, connections, options);
+        Print("SlotMap", slotTimings, connections, options);
+        if (mapTimings.checksum != slotTimings.checksum)
+        {
+            std::cout << "  checksums differ" << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
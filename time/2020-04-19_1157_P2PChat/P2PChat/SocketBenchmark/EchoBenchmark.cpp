@@ -0,0 +1,360 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "SocketWrapperLib/SocketCoroutines.h"
+#include "Benchmarks.h"
+
+// Loopback echo server driven by SocketUtil::Select, by SocketRing and by coroutines on a SocketScheduler.
+// One client thread keeps all connections in lock step: every round it sends one message
+// on each connection and then reads all the echoes back.
+
+namespace
+{
+    const uint16_t SELECT_PORT = 56801;
+    const uint16_t RING_PORT = 56802;
+    const uint16_t COROUTINE_PORT = 56807;
+    const int SEGMENT_SIZE = 4096;
+
+    struct EchoOptions
+    {
+        int connections = 256;
+        int rounds = 2000;
+        int messageSize = 64;
+    };
+
+    struct EchoResult
+    {
+        double seconds = 0;
+        long wakeups = 0;
+    };
+
+    SocketAddress LoopbackAddress(uint16_t inPort)
+    {
+        return SocketAddress(INADDR_LOOPBACK, inPort);
+    }
+
+    TCPSocketPtr CreateListenSocket(uint16_t inPort)
+    {
+        TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
+        if (!listenSocket || listenSocket->Bind(LoopbackAddress(inPort)) != NO_ERROR
+            || listenSocket->Listen(1024) != NO_ERROR)
+        {
+            return nullptr;
+        }
+        return listenSocket;
+    }
+
+    bool SendAll(const TCPSocketPtr& inSocket, const char* inData, int inLen)
+    {
+        while (inLen > 0)
+        {
+            int sent = inSocket->Send(inData, inLen);
+            if (sent <= 0)
+            {
+                return false;
+            }
+            inData += sent;
+            inLen -= sent;
+        }
+        return true;
+    }
+
+    double RunClients(uint16_t inPort, const EchoOptions& inOptions)
+    {
+        vector<TCPSocketPtr> sockets;
+        for (int i = 0; i < inOptions.connections; ++i)
+        {
+            TCPSocketPtr socket = SocketUtil::CreateTCPSocket(INET);
+            if (socket->Connect(LoopbackAddress(inPort)) != NO_ERROR)
+            {
+                return -1;
+            }
+            sockets.push_back(socket);
+        }
+
+        string message(inOptions.messageSize, 'x');
+        vector<char> echo(inOptions.messageSize);
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < inOptions.rounds; ++round)
+        {
+            for (const auto& socket : sockets)
+            {
+                SendAll(socket, message.data(), inOptions.messageSize);
+            }
+            for (const auto& socket : sockets)
+            {
+                for (int received = 0; received < inOptions.messageSize;)
+                {
+                    int count = socket->Receive(echo.data() + received, inOptions.messageSize - received);
+                    if (count <= 0)
+                    {
+                        return -1;
+                    }
+                    received += count;
+                }
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        //clients close first, so TIME_WAIT does not hold the server port
+        return elapsed.count();
+    }
+
+    bool RunSelectServer(const EchoOptions& inOptions, EchoResult& outResult)
+    {
+        TCPSocketPtr listenSocket = CreateListenSocket(SELECT_PORT);
+        if (!listenSocket)
+        {
+            return false;
+        }
+
+        double seconds = 0;
+        std::thread clients([&] { seconds = RunClients(SELECT_PORT, inOptions); });
+
+        vector<TCPSocketPtr> readBlockSockets = {listenSocket};
+        vector<TCPSocketPtr> readableSockets;
+        char segment[SEGMENT_SIZE];
+        int closedCount = 0;
+        while (closedCount < inOptions.connections)
+        {
+            if (SocketUtil::Select(&readBlockSockets, &readableSockets, nullptr, nullptr, nullptr, nullptr) < 0)
+            {
+                break;
+            }
+            ++outResult.wakeups;
+
+            for (const auto& socket : readableSockets)
+            {
+                if (socket == listenSocket)
+                {
+                    SocketAddress address;
+                    readBlockSockets.push_back(listenSocket->Accept(address));
+                    continue;
+                }
+
+                int received = socket->Receive(segment, SEGMENT_SIZE);
+                if (received <= 0 || !SendAll(socket, segment, received))
+                {
+                    readBlockSockets.erase(std::find(readBlockSockets.begin(), readBlockSockets.end(), socket));
+                    ++closedCount;
+                }
+            }
+        }
+
+        clients.join();
+        outResult.seconds = seconds;
+        return seconds > 0;
+    }
+
+    struct RingConnection
+    {
+        TCPSocketPtr socket;
+        // the kernel reads from sending until the send completes, new data waits in queued
+        string sending;
+        string queued;
+        bool isSending = false;
+    };
+
+    void FlushQueued(SocketRing& ioRing, RingConnection& ioConnection)
+    {
+        ioConnection.sending.swap(ioConnection.queued);
+        ioConnection.queued.clear();
+        ioConnection.isSending = true;
+        ioRing.Send(ioConnection.socket, ioConnection.sending.data(), ioConnection.sending.size(), &ioConnection);
+    }
+
+    bool RunRingServer(const EchoOptions& inOptions, EchoResult& outResult)
+    {
+        SocketRingPtr ring = SocketRing::Create();
+        TCPSocketPtr listenSocket = CreateListenSocket(RING_PORT);
+        if (!ring || !listenSocket)
+        {
+            return false;
+        }
+
+        double seconds = 0;
+        std::thread clients([&] { seconds = RunClients(RING_PORT, inOptions); });
+
+        ring->Accept(listenSocket, nullptr);
+
+        vector<unique_ptr<RingConnection>> connections;
+        vector<SocketCompletion> completions;
+        int closedCount = 0;
+        while (closedCount < inOptions.connections)
+        {
+            if (ring->Wait(completions) < 0)
+            {
+                break;
+            }
+            ++outResult.wakeups;
+
+            for (const auto& completion : completions)
+            {
+                auto connection = static_cast<RingConnection*>(completion.userData);
+                switch (completion.type)
+                {
+                case COMPLETION_ACCEPT:
+                    if (completion.acceptedSocket)
+                    {
+                        connections.emplace_back(new RingConnection());
+                        connections.back()->socket = completion.acceptedSocket;
+                        ring->Receive(completion.acceptedSocket, connections.back().get());
+                    }
+                    break;
+
+                case COMPLETION_RECEIVE:
+                    if (completion.result > 0)
+                    {
+                        connection->queued.append(completion.data, completion.result);
+                        if (!connection->isSending)
+                        {
+                            FlushQueued(*ring, *connection);
+                        }
+                    }
+                    else if (completion.isFinal)
+                    {
+                        ++closedCount;
+                    }
+                    break;
+
+                case COMPLETION_SEND:
+                    if (completion.result > 0 && completion.result < static_cast<int>(connection->sending.size()))
+                    {
+                        connection->queued.insert(0, connection->sending, completion.result, string::npos);
+                    }
+                    connection->isSending = false;
+                    if (!connection->queued.empty())
+                    {
+                        FlushQueued(*ring, *connection);
+                    }
+                    break;
+                }
+            }
+        }
+
+        clients.join();
+        outResult.seconds = seconds;
+        return seconds > 0;
+    }
+
+    SocketTask<void> RunCoroutineSession(AsyncSocket inSocket, SocketScheduler& ioScheduler, int& ioClosedCount,
+                                         int inConnections)
+    {
+        char segment[SEGMENT_SIZE];
+        while (true)
+        {
+            int received = co_await inSocket.Receive(segment, SEGMENT_SIZE);
+            if (received <= 0 || co_await inSocket.Send(segment, received) < 0)
+            {
+                break;
+            }
+        }
+        if (++ioClosedCount == inConnections)
+        {
+            ioScheduler.Stop();
+        }
+    }
+
+    SocketTask<void> RunCoroutineAcceptor(AsyncSocket& ioListenSocket, SocketScheduler& ioScheduler, int& ioClosedCount,
+                                          int inConnections)
+    {
+        while (true)
+        {
+            AsyncSocket socket = co_await ioListenSocket.Accept();
+            if (socket)
+            {
+                ioScheduler.Spawn(RunCoroutineSession(std::move(socket), ioScheduler, ioClosedCount, inConnections));
+            }
+        }
+    }
+
+    bool RunCoroutineServer(const EchoOptions& inOptions, EchoResult& outResult)
+    {
+        SocketScheduler scheduler;
+        AsyncSocket listenSocket(scheduler, CreateListenSocket(COROUTINE_PORT));
+        if (!listenSocket)
+        {
+            return false;
+        }
+
+        double seconds = 0;
+        std::thread clients([&] { seconds = RunClients(COROUTINE_PORT, inOptions); });
+
+        int closedCount = 0;
+        scheduler.Spawn(RunCoroutineAcceptor(listenSocket, scheduler, closedCount, inOptions.connections));
+        int result = scheduler.Run();
+
+        clients.join();
+        outResult.seconds = seconds;
+        outResult.wakeups = scheduler.GetPollCount();
+        return result == NO_ERROR && seconds > 0;
+    }
+
+    void PrintResult(const char* inName, const EchoOptions& inOptions, const EchoResult& inResult)
+    {
+        double messages = static_cast<double>(inOptions.connections) * inOptions.rounds;
+        std::cout << inName << ": " << inResult.seconds << " s, "
+            << static_cast<long>(messages / inResult.seconds) << " msg/s, "
+            << inResult.wakeups << " server wakeups" << std::endl;
+    }
+}
+
+int RunEchoBenchmark(const std::vector<std::string>& args)
+{
+    EchoOptions options;
+    if (args.size() > 0) options.connections = std::stoi(args[0]);
+    if (args.size() > 1) options.rounds = std::stoi(args[1]);
+    if (args.size() > 2) options.messageSize = std::stoi(args[2]);
+
+    std::cout << "echo: " << options.connections << " connections, " << options.rounds << " rounds, "
+        << options.messageSize << " bytes" << std::endl;
+
+    //select can not watch descriptors above FD_SETSIZE
+    if (options.connections + 16 < FD_SETSIZE)
+    {
+        EchoResult result;
+        if (RunSelectServer(options, result))
+        {
+            PrintResult("select", options, result);
+        }
+        else
+        {
+            std::cout << "select: failed" << std::endl;
+        }
+    }
+    else
+    {
+        std::cout << "select: skipped, too many connections" << std::endl;
+    }
+
+    if (SocketRing::IsSupported())
+    {
+        EchoResult result;
+        if (RunRingServer(options, result))
+        {
+            PrintResult("io_uring", options, result);
+        }
+        else
+        {
+            std::cout << "io_uring: failed" << std::endl;
+        }
+    }
+    else
+    {
+        std::cout << "io_uring: not supported by the kernel" << std::endl;
+    }
+
+    EchoResult coroutineResult;
+    if (RunCoroutineServer(options, coroutineResult))
+    {
+        PrintResult("coroutines", options, coroutineResult);
+    }
+    else
+    {
+        std::cout << "coroutines: failed" << std::endl;
+    }
+
+    return 0;
+}
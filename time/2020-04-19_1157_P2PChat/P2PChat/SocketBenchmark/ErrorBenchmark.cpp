@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Cost of SocketUtil::ReportError when several threads report at the same time, each thread with its own
+// SocketErrorScope. Every thread also formats with StringUtils::Sprintf and checks that no other thread
+// wrote into its text, then the entries of SocketErrorLog are checked.
+
+namespace
+{
+    const char* const OPERATIONS[] = {"ErrorBenchmark::Thread0", "ErrorBenchmark::Thread1", "ErrorBenchmark::Thread2",
+                                      "ErrorBenchmark::Thread3", "ErrorBenchmark::Thread4", "ErrorBenchmark::Thread5",
+                                      "ErrorBenchmark::Thread6", "ErrorBenchmark::Thread7"};
+    const int MAX_THREADS = sizeof(OPERATIONS) / sizeof(OPERATIONS[0]);
+    const int FIRST_ERROR = 1000;
+
+    struct ErrorBenchmarkOptions
+    {
+        int threads = 4;
+        int reports = 200000;
+    };
+
+    void SetLastError(int inError)
+    {
+#if _WIN32
+        WSASetLastError(inError);
+#else
+        errno = inError;
+#endif
+    }
+
+    // Reports errors FIRST_ERROR + thread with the operation of the thread.
+    void RunReporter(int inThread, int inReports, std::atomic<long>& ioBadCount)
+    {
+        long callBackCount = 0;
+        SocketErrorCallBack callBack = [&](const SocketError& inError)
+        {
+            callBackCount += inError.operation == OPERATIONS[inThread] ? 1 : 0;
+        };
+        SocketErrorScope scope(callBack);
+
+        long badCount = 0;
+        for (int i = 0; i < inReports; ++i)
+        {
+            SetLastError(FIRST_ERROR + inThread);
+            SocketUtil::ReportError(OPERATIONS[inThread]);
+            badCount += SocketUtil::GetLastError() == FIRST_ERROR + inThread ? 0 : 1;
+
+            string text = StringUtils::Sprintf("%d:%d", inThread, i);
+            badCount += text == std::to_string(inThread) + ":" + std::to_string(i) ? 0 : 1;
+        }
+        ioBadCount += badCount + (inReports - callBackCount);
+    }
+}
+
+int RunErrorBenchmark(const std::vector<std::string>& args)
+{
+    ErrorBenchmarkOptions options;
+    if (args.size() > 0) options.threads = std::min(std::stoi(args[0]), MAX_THREADS);
+    if (args.size() > 1) options.reports = std::stoi(args[1]);
+
+    std::cout << "errors: " << options.threads << " threads, " << options.reports << " reports each" << std::endl;
+
+    std::atomic<long> badCount(0);
+    vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int thread = 0; thread < options.threads; ++thread)
+    {
+        threads.emplace_back(RunReporter, thread, options.reports, std::ref(badCount));
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    vector<SocketError> recent;
+    SocketUtil::GetErrorLog().GetRecent(recent);
+    for (const SocketError& error : recent)
+    {
+        int thread = error.error - FIRST_ERROR;
+        badCount += thread >= 0 && thread < options.threads && error.operation == OPERATIONS[thread] ? 0 : 1;
+    }
+
+    double reports = static_cast<double>(options.threads) * options.reports;
+    std::cout << "ReportError with Sprintf: " << elapsed.count() / reports << " ns per report, "
+        << SocketUtil::GetErrorLog().GetTotalCount() << " logged, " << recent.size() << " in the ring, "
+        << badCount << " corrupted" << std::endl;
+    return badCount == 0 ? 0 : 1;
+}
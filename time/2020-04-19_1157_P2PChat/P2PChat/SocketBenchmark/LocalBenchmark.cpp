@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Round trip latency of one message between two threads over loopback TCP and over AF_UNIX sockets.
+// A second thread echoes every message, the first one waits for the echo before it sends the next.
+// Then a pipe is passed with SCM_RIGHTS and used on the other side.
+
+namespace
+{
+    const uint16_t LOCAL_TCP_PORT = 56809;
+    const char* const LOCAL_NAME = "@p2pchat-local-benchmark";
+
+    struct LocalBenchmarkOptions
+    {
+        int roundTrips = 20000;
+        int messageSize = 300;
+    };
+
+    bool SendAll(const TCPSocketPtr& inSocket, const char* inData, int inLen)
+    {
+        while (inLen > 0)
+        {
+            int sent = inSocket->Send(inData, inLen);
+            if (sent <= 0)
+            {
+                return false;
+            }
+            inData += sent;
+            inLen -= sent;
+        }
+        return true;
+    }
+
+    bool ReceiveAll(const TCPSocketPtr& inSocket, char* outData, int inLen)
+    {
+        while (inLen > 0)
+        {
+            int received = inSocket->Receive(outData, inLen);
+            if (received <= 0)
+            {
+                return false;
+            }
+            outData += received;
+            inLen -= received;
+        }
+        return true;
+    }
+
+    void RunEcho(TCPSocketPtr inSocket, int inMessageSize)
+    {
+        vector<char> message(inMessageSize);
+        while (ReceiveAll(inSocket, message.data(), inMessageSize) && SendAll(inSocket, message.data(), inMessageSize))
+        {
+        }
+    }
+
+    // Measures round trips from inClient to an echo thread on inServer, both connected.
+    // The caller hands over the client, closing it ends the echo thread.
+    bool Measure(const char* inName, TCPSocketPtr inClient, TCPSocketPtr inServer, const LocalBenchmarkOptions& inOptions)
+    {
+        if (!inClient || !inServer)
+        {
+            std::cout << inName << ": failed to connect" << std::endl;
+            return false;
+        }
+        std::thread echo(RunEcho, inServer, inOptions.messageSize);
+
+        vector<char> message(inOptions.messageSize, 'x');
+        vector<double> roundTrips;
+        roundTrips.reserve(inOptions.roundTrips);
+        bool isDone = true;
+        for (int i = 0; i < inOptions.roundTrips && isDone; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            isDone = SendAll(inClient, message.data(), inOptions.messageSize)
+                && ReceiveAll(inClient, message.data(), inOptions.messageSize);
+            roundTrips.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        //closing the client ends the echo loop
+        inClient.reset();
+        echo.join();
+
+        std::sort(roundTrips.begin(), roundTrips.end());
+        double sum = 0;
+        for (double roundTrip : roundTrips)
+        {
+            sum += roundTrip;
+        }
+        std::cout << inName << ": " << sum / roundTrips.size() << " us mean, "
+            << roundTrips[roundTrips.size() / 2] << " us p50, " << roundTrips[roundTrips.size() * 99 / 100]
+            << " us p99" << (isDone ? "" : ", failed") << std::endl;
+        return isDone;
+    }
+
+    bool MeasureTCP(const LocalBenchmarkOptions& inOptions)
+    {
+        SocketAddress address(INADDR_LOOPBACK, LOCAL_TCP_PORT);
+        TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
+        listenSocket->SetReuseAddress(true);
+        if (listenSocket->Bind(address) != NO_ERROR || listenSocket->Listen() != NO_ERROR)
+        {
+            return false;
+        }
+        TCPSocketPtr client = SocketUtil::CreateTCPSocket(INET);
+        if (client->Connect(address) != NO_ERROR)
+        {
+            return false;
+        }
+        SocketAddress clientAddress;
+        TCPSocketPtr server = listenSocket->Accept(clientAddress);
+        client->SetNoDelay(true);
+        if (server)
+        {
+            server->SetNoDelay(true);
+        }
+        return Measure("TCP loopback", std::move(client), std::move(server), inOptions);
+    }
+
+    bool MeasureLocal(const char* inName, LocalSocketType inType, const LocalBenchmarkOptions& inOptions)
+    {
+        LocalSocketPtr listenSocket = SocketUtil::CreateLocalSocket(inType);
+        if (!listenSocket || listenSocket->Bind(LOCAL_NAME) != NO_ERROR || listenSocket->Listen() != NO_ERROR)
+        {
+            return false;
+        }
+        LocalSocketPtr client = SocketUtil::CreateLocalSocket(inType);
+        if (client->Connect(LOCAL_NAME) != NO_ERROR)
+        {
+            return false;
+        }
+        return Measure(inName, std::move(client), listenSocket->Accept(), inOptions);
+    }
+
+    bool MeasureSocketPair(const LocalBenchmarkOptions& inOptions)
+    {
+        LocalSocketPtr client, server;
+        if (SocketUtil::CreateLocalSocketPair(client, server) != NO_ERROR)
+        {
+            return false;
+        }
+        return Measure("AF_UNIX socketpair", std::move(client), std::move(server), inOptions);
+    }
+
+    // The write end of a pipe goes through a socket pair, a byte written to the received copy comes out of the pipe.
+    bool CheckDescriptorPassing()
+    {
+        LocalSocketPtr first, second;
+        int pipeEnds[2];
+        if (SocketUtil::CreateLocalSocketPair(first, second, LOCAL_SEQPACKET) != NO_ERROR || pipe(pipeEnds) < 0)
+        {
+            return false;
+        }
+
+        char tag = 'p';
+        vector<int> received;
+        bool isPassed = first->SendWithDescriptors(&tag, 1, &pipeEnds[1], 1) == 1
+            && second->ReceiveWithDescriptors(&tag, 1, received) == 1 && received.size() == 1;
+        close(pipeEnds[1]);
+
+        char byte = 0;
+        if (isPassed)
+        {
+            isPassed = write(received[0], "!", 1) == 1 && read(pipeEnds[0], &byte, 1) == 1 && byte == '!';
+            close(received[0]);
+        }
+        close(pipeEnds[0]);
+
+        std::cout << "SCM_RIGHTS: " << (isPassed ? "pipe passed and used" : "failed") << std::endl;
+        return isPassed;
+    }
+}
+
+int RunLocalBenchmark(const std::vector<std::string>& args)
+{
+    LocalBenchmarkOptions options;
+    if (args.size() > 0) options.roundTrips = std::stoi(args[0]);
+    if (args.size() > 1) options.messageSize = std::stoi(args[1]);
+
+    std::cout << "local: " << options.roundTrips << " round trips of " << options.messageSize << " bytes" << std::endl;
+
+    bool isDone = MeasureTCP(options);
+    isDone = MeasureLocal("AF_UNIX stream", LOCAL_STREAM, options) && isDone;
+    isDone = MeasureLocal("AF_UNIX seqpacket", LOCAL_SEQPACKET, options) && isDone;
+    isDone = MeasureSocketPair(options) && isDone;
+    isDone = CheckDescriptorPassing() && isDone;
+    return isDone ? 0 : 1;
+}
@@ -0,0 +1,646 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#if !_WIN32
+#include <sys/resource.h>
+#endif
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Loopback measurements of TCPSocket, UDPSocket, SocketUtil::Select and SocketPoller with blocking threads:
+//  - tcp_pingpong, udp_pingpong: round trip latency of one message per connection, concurrency connections at once
+//  - tcp_stream: throughput of concurrency connections which send as fast as they can
+//  - connect_rate: connects per second of concurrency client threads against one listener
+//  - idle_connections_select, idle_connections_poller: round trip latency of one active connection through
+//    a Select and a SocketPoller server loop, without and with many idle connections on the same server
+// Every result is printed and written to a JSON report.
+
+namespace
+{
+    const uint16_t TCP_PORT = 56810;
+    const uint16_t CONNECT_PORT = 56811;
+    const uint16_t IDLE_PORT = 56812;
+    // one port per UDP pair from here on
+    const uint16_t UDP_FIRST_PORT = 56820;
+    const int MAX_DATAGRAM_SIZE = 65507;
+
+    struct LoopbackBenchmarkOptions
+    {
+        vector<int> messageSizes = {64, 1024, 16384};
+        int concurrency = 1;
+        int idleConnections = 400;
+        string reportPath = "loopback_report.json";
+        int roundTrips = 20000;
+        long long streamBytes = 256LL * 1024 * 1024;
+        int connects = 2000;
+    };
+
+    // One line of the report: the name of the test and its numbers in order.
+    struct LoopbackResult
+    {
+        string test;
+        vector<std::pair<string, double>> values;
+    };
+
+    struct Latency
+    {
+        double mean = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double p999 = 0;
+    };
+
+    vector<int> ParseSizes(const string& inSizes)
+    {
+        vector<int> sizes;
+        std::stringstream stream(inSizes);
+        string size;
+        while (std::getline(stream, size, ','))
+        {
+            sizes.push_back(std::stoi(size));
+        }
+        return sizes;
+    }
+
+    double Seconds(std::chrono::steady_clock::time_point inStart)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - inStart).count();
+    }
+
+    Latency GetLatency(vector<double>& ioMicroseconds)
+    {
+        Latency latency;
+        if (ioMicroseconds.empty())
+        {
+            return latency;
+        }
+        std::sort(ioMicroseconds.begin(), ioMicroseconds.end());
+        double sum = 0;
+        for (double microseconds : ioMicroseconds)
+        {
+            sum += microseconds;
+        }
+        size_t count = ioMicroseconds.size();
+        latency.mean = sum / count;
+        latency.p50 = ioMicroseconds[count / 2];
+        latency.p99 = ioMicroseconds[std::min(count - 1, count * 99 / 100)];
+        latency.p999 = ioMicroseconds[std::min(count - 1, count * 999 / 1000)];
+        return latency;
+    }
+
+    void AddLatency(LoopbackResult& ioResult, const Latency& inLatency)
+    {
+        ioResult.values.push_back({"meanUs", inLatency.mean});
+        ioResult.values.push_back({"p50Us", inLatency.p50});
+        ioResult.values.push_back({"p99Us", inLatency.p99});
+        ioResult.values.push_back({"p999Us", inLatency.p999});
+    }
+
+    void Print(const LoopbackResult& inResult)
+    {
+        std::cout << inResult.test << ":" << std::setprecision(12);
+        for (const auto& value : inResult.values)
+        {
+            std::cout << " " << value.first << "=" << value.second;
+        }
+        std::cout << std::endl;
+    }
+
+    bool WriteReport(const LoopbackBenchmarkOptions& inOptions, const vector<LoopbackResult>& inResults)
+    {
+        std::ofstream report(inOptions.reportPath);
+        report.precision(12);
+        report << "{\n  \"benchmark\": \"loopback\",\n  \"concurrency\": " << inOptions.concurrency
+            << ",\n  \"idleConnections\": " << inOptions.idleConnections << ",\n  \"results\": [";
+        for (size_t i = 0; i < inResults.size(); ++i)
+        {
+            report << (i == 0 ? "\n" : ",\n") << "    {\"test\": \"" << inResults[i].test << "\"";
+            for (const auto& value : inResults[i].values)
+            {
+                report << ", \"" << value.first << "\": " << value.second;
+            }
+            report << "}";
+        }
+        report << "\n  ]\n}\n";
+        return static_cast<bool>(report);
+    }
+
+    bool SendAll(const TCPSocketPtr& inSocket, const char* inData, int inLen)
+    {
+        while (inLen > 0)
+        {
+            int sent = inSocket->Send(inData, inLen);
+            if (sent == -WSAEWOULDBLOCK)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            if (sent <= 0)
+            {
+                return false;
+            }
+            inData += sent;
+            inLen -= sent;
+        }
+        return true;
+    }
+
+    bool ReceiveAll(const TCPSocketPtr& inSocket, char* outData, int inLen)
+    {
+        while (inLen > 0)
+        {
+            int received = inSocket->Receive(outData, inLen);
+            if (received <= 0)
+            {
+                return false;
+            }
+            outData += received;
+            inLen -= received;
+        }
+        return true;
+    }
+
+    // Echoes everything until the peer closes.
+    void RunTCPEcho(TCPSocketPtr inSocket)
+    {
+        char buffer[65536];
+        int received;
+        while ((received = inSocket->Receive(buffer, sizeof(buffer))) > 0 && SendAll(inSocket, buffer, received))
+        {
+        }
+    }
+
+    // Connects inCount clients to inListenSocket, outServers gets the accepted sides in the same order.
+    bool ConnectPairs(const TCPSocketPtr& inListenSocket, const SocketAddress& inAddress, int inCount,
+                      vector<TCPSocketPtr>& outClients, vector<TCPSocketPtr>& outServers)
+    {
+        for (int i = 0; i < inCount; ++i)
+        {
+            TCPSocketPtr client = SocketUtil::CreateTCPSocket(INET);
+            if (client->Connect(inAddress) != NO_ERROR)
+            {
+                return false;
+            }
+            SocketAddress clientAddress;
+            TCPSocketPtr server = inListenSocket->Accept(clientAddress);
+            if (!server)
+            {
+                return false;
+            }
+            client->SetNoDelay(true);
+            server->SetNoDelay(true);
+            outClients.push_back(client);
+            outServers.push_back(server);
+        }
+        return true;
+    }
+
+    TCPSocketPtr Listen(uint16_t inPort, int inBackLog)
+    {
+        TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
+        listenSocket->SetReuseAddress(true);
+        if (listenSocket->Bind(SocketAddress(INADDR_LOOPBACK, inPort)) != NO_ERROR || listenSocket->Listen(inBackLog) != NO_ERROR)
+        {
+            return nullptr;
+        }
+        return listenSocket;
+    }
+
+    bool MeasureTCPPingPong(int inMessageSize, const LoopbackBenchmarkOptions& inOptions, vector<LoopbackResult>& ioResults)
+    {
+        TCPSocketPtr listenSocket = Listen(TCP_PORT, inOptions.concurrency);
+        vector<TCPSocketPtr> clients, servers;
+        if (!listenSocket || !ConnectPairs(listenSocket, SocketAddress(INADDR_LOOPBACK, TCP_PORT), inOptions.concurrency, clients, servers))
+        {
+            std::cout << "tcp_pingpong: failed to connect" << std::endl;
+            return false;
+        }
+
+        vector<std::thread> echoes;
+        for (TCPSocketPtr& server : servers)
+        {
+            echoes.emplace_back(RunTCPEcho, std::move(server));
+        }
+
+        int roundTrips = std::max(1, inOptions.roundTrips / inOptions.concurrency);
+        vector<vector<double>> microseconds(inOptions.concurrency);
+        std::atomic<int> failedCount(0);
+        vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < inOptions.concurrency; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                //the client is closed when the thread ends, which ends its echo thread
+                TCPSocketPtr client = std::move(clients[i]);
+                vector<char> message(inMessageSize, 'x');
+                microseconds[i].reserve(roundTrips);
+                for (int trip = 0; trip < roundTrips; ++trip)
+                {
+                    auto sent = std::chrono::steady_clock::now();
+                    if (!SendAll(client, message.data(), inMessageSize) || !ReceiveAll(client, message.data(), inMessageSize))
+                    {
+                        ++failedCount;
+                        return;
+                    }
+                    microseconds[i].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = Seconds(start);
+        for (std::thread& echo : echoes)
+        {
+            echo.join();
+        }
+
+        vector<double> all;
+        for (const vector<double>& connection : microseconds)
+        {
+            all.insert(all.end(), connection.begin(), connection.end());
+        }
+        LoopbackResult result{"tcp_pingpong", {{"messageSize", inMessageSize}, {"concurrency", inOptions.concurrency},
+                                               {"roundTrips", static_cast<double>(all.size())}}};
+        AddLatency(result, GetLatency(all));
+        result.values.push_back({"roundTripsPerSecond", all.size() / seconds});
+        Print(result);
+        ioResults.push_back(result);
+        return failedCount == 0;
+    }
+
+    bool MeasureUDPPingPong(int inMessageSize, const LoopbackBenchmarkOptions& inOptions, vector<LoopbackResult>& ioResults)
+    {
+        if (inMessageSize > MAX_DATAGRAM_SIZE)
+        {
+            std::cout << "udp_pingpong: " << inMessageSize << " bytes do not fit into a datagram, skipped" << std::endl;
+            return true;
+        }
+
+        vector<UDPSocketPtr> servers;
+        for (int i = 0; i < inOptions.concurrency; ++i)
+        {
+            UDPSocketPtr server = SocketUtil::CreateUDPSocket(INET);
+            if (server->Bind(SocketAddress(INADDR_LOOPBACK, static_cast<uint16_t>(UDP_FIRST_PORT + i))) != NO_ERROR)
+            {
+                std::cout << "udp_pingpong: failed to bind" << std::endl;
+                return false;
+            }
+            servers.push_back(server);
+        }
+
+        //an empty datagram ends the echo
+        vector<std::thread> echoes;
+        for (const UDPSocketPtr& server : servers)
+        {
+            echoes.emplace_back([server]
+            {
+                vector<char> buffer(MAX_DATAGRAM_SIZE);
+                SocketAddress from;
+                int received;
+                while ((received = server->ReceiveFrom(buffer.data(), MAX_DATAGRAM_SIZE, from)) > 0)
+                {
+                    server->SendTo(buffer.data(), received, from);
+                }
+            });
+        }
+
+        int roundTrips = std::max(1, inOptions.roundTrips / inOptions.concurrency);
+        vector<vector<double>> microseconds(inOptions.concurrency);
+        std::atomic<int> failedCount(0);
+        vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < inOptions.concurrency; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                SocketAddress serverAddress(INADDR_LOOPBACK, static_cast<uint16_t>(UDP_FIRST_PORT + i));
+                UDPSocketPtr client = SocketUtil::CreateUDPSocket(INET);
+                client->Bind(SocketAddress(INADDR_LOOPBACK, 0));
+                vector<char> message(inMessageSize, 'x');
+                SocketAddress from;
+                microseconds[i].reserve(roundTrips);
+                for (int trip = 0; trip < roundTrips; ++trip)
+                {
+                    auto sent = std::chrono::steady_clock::now();
+                    if (client->SendTo(message.data(), inMessageSize, serverAddress) != inMessageSize
+                        || client->ReceiveFrom(message.data(), inMessageSize, from) != inMessageSize)
+                    {
+                        ++failedCount;
+                        break;
+                    }
+                    microseconds[i].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+                }
+                client->SendTo(message.data(), 0, serverAddress);
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = Seconds(start);
+        for (std::thread& echo : echoes)
+        {
+            echo.join();
+        }
+
+        vector<double> all;
+        for (const vector<double>& connection : microseconds)
+        {
+            all.insert(all.end(), connection.begin(), connection.end());
+        }
+        LoopbackResult result{"udp_pingpong", {{"messageSize", inMessageSize}, {"concurrency", inOptions.concurrency},
+                                               {"roundTrips", static_cast<double>(all.size())}}};
+        AddLatency(result, GetLatency(all));
+        result.values.push_back({"roundTripsPerSecond", all.size() / seconds});
+        Print(result);
+        ioResults.push_back(result);
+        return failedCount == 0;
+    }
+
+    bool MeasureTCPStream(int inMessageSize, const LoopbackBenchmarkOptions& inOptions, vector<LoopbackResult>& ioResults)
+    {
+        TCPSocketPtr listenSocket = Listen(TCP_PORT, inOptions.concurrency);
+        vector<TCPSocketPtr> clients, servers;
+        if (!listenSocket || !ConnectPairs(listenSocket, SocketAddress(INADDR_LOOPBACK, TCP_PORT), inOptions.concurrency, clients, servers))
+        {
+            std::cout << "tcp_stream: failed to connect" << std::endl;
+            return false;
+        }
+
+        long long bytesPerConnection = inOptions.streamBytes / inOptions.concurrency;
+        std::atomic<long long> receivedBytes(0);
+        vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < inOptions.concurrency; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                TCPSocketPtr server = std::move(servers[i]);
+                vector<char> buffer(std::max(inMessageSize, 65536));
+                long long total = 0;
+                int received;
+                while ((received = server->Receive(buffer.data(), static_cast<int>(buffer.size()))) > 0)
+                {
+                    total += received;
+                }
+                receivedBytes += total;
+            });
+            threads.emplace_back([&, i]
+            {
+                //closing the client ends the receiving thread
+                TCPSocketPtr client = std::move(clients[i]);
+                vector<char> message(inMessageSize, 'x');
+                for (long long sent = 0; sent < bytesPerConnection; sent += inMessageSize)
+                {
+                    if (!SendAll(client, message.data(), inMessageSize))
+                    {
+                        return;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = Seconds(start);
+
+        LoopbackResult result{"tcp_stream", {{"messageSize", inMessageSize}, {"concurrency", inOptions.concurrency},
+                                             {"bytes", static_cast<double>(receivedBytes)}, {"seconds", seconds},
+                                             {"megabytesPerSecond", receivedBytes / seconds / (1024 * 1024)}}};
+        Print(result);
+        ioResults.push_back(result);
+        long long expectedBytes = (bytesPerConnection + inMessageSize - 1) / inMessageSize * inMessageSize * inOptions.concurrency;
+        return receivedBytes == expectedBytes;
+    }
+
+    bool MeasureConnectRate(const LoopbackBenchmarkOptions& inOptions, vector<LoopbackResult>& ioResults)
+    {
+        TCPSocketPtr listenSocket = Listen(CONNECT_PORT, 1024);
+        if (!listenSocket)
+        {
+            std::cout << "connect_rate: failed to listen" << std::endl;
+            return false;
+        }
+
+        std::atomic<int> acceptedCount(0);
+        std::atomic<bool> isStopping(false);
+        std::thread acceptor([&]
+        {
+            vector<TCPSocketPtr> readSet{listenSocket};
+            vector<TCPSocketPtr> readable;
+            while (!isStopping)
+            {
+                if (SocketUtil::Select(&readSet, &readable, nullptr, nullptr, nullptr, nullptr, 100) > 0)
+                {
+                    SocketAddress address;
+                    if (listenSocket->Accept(address))
+                    {
+                        ++acceptedCount;
+                    }
+                }
+            }
+        });
+
+        int connectsPerThread = std::max(1, inOptions.connects / inOptions.concurrency);
+        std::atomic<int> connectedCount(0);
+        vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < inOptions.concurrency; ++i)
+        {
+            threads.emplace_back([&]
+            {
+                SocketAddress address(INADDR_LOOPBACK, CONNECT_PORT);
+                for (int connect = 0; connect < connectsPerThread; ++connect)
+                {
+                    TCPSocketPtr client = SocketUtil::CreateTCPSocket(INET);
+                    if (client->Connect(address) == NO_ERROR)
+                    {
+                        ++connectedCount;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = Seconds(start);
+        //the acceptor catches up with the backlog
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (acceptedCount < connectedCount && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        isStopping = true;
+        acceptor.join();
+
+        LoopbackResult result{"connect_rate", {{"concurrency", inOptions.concurrency}, {"connects", static_cast<double>(connectedCount)},
+                                               {"accepted", static_cast<double>(acceptedCount)},
+                                               {"connectsPerSecond", connectedCount / seconds}}};
+        Print(result);
+        ioResults.push_back(result);
+        return connectedCount == connectsPerThread * inOptions.concurrency && acceptedCount == connectedCount;
+    }
+
+    // Echo server loops for idle_connections, both end when inActive is closed by the client.
+    void RunSelectEcho(const vector<TCPSocketPtr>& inSockets, TCPSocketPtr inActive)
+    {
+        vector<TCPSocketPtr> readable;
+        char buffer[65536];
+        while (SocketUtil::Select(&inSockets, &readable, nullptr, nullptr, nullptr, nullptr) > 0)
+        {
+            for (const TCPSocketPtr& socket : readable)
+            {
+                int received = socket->Receive(buffer, sizeof(buffer));
+                if (socket == inActive && (received <= 0 || !SendAll(socket, buffer, received)))
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    void RunPollerEcho(const vector<TCPSocketPtr>& inSockets, TCPSocketPtr inActive)
+    {
+        SocketPoller poller;
+        for (const TCPSocketPtr& socket : inSockets)
+        {
+            socket->SetNonBlockingMode(true);
+            poller.Add(socket, POLL_READ, socket.get());
+        }
+        vector<SocketPollEvent> events;
+        char buffer[65536];
+        while (poller.Wait(events) >= 0)
+        {
+            for (const SocketPollEvent& event : events)
+            {
+                if (event.userData != inActive.get())
+                {
+                    continue;
+                }
+                //edge triggered, read until nothing is left
+                int received;
+                while ((received = inActive->Receive(buffer, sizeof(buffer))) > 0)
+                {
+                    if (!SendAll(inActive, buffer, received))
+                    {
+                        return;
+                    }
+                }
+                if (received != -WSAEWOULDBLOCK)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    bool MeasureIdleConnections(int inIdleCount, bool inUseSelect, int inMessageSize, const LoopbackBenchmarkOptions& inOptions,
+                                vector<LoopbackResult>& ioResults)
+    {
+        TCPSocketPtr listenSocket = Listen(IDLE_PORT, 1024);
+        vector<TCPSocketPtr> clients, servers;
+        if (!listenSocket || !ConnectPairs(listenSocket, SocketAddress(INADDR_LOOPBACK, IDLE_PORT), inIdleCount + 1, clients, servers))
+        {
+            std::cout << "idle_connections: failed to connect " << inIdleCount << " idle connections" << std::endl;
+            return false;
+        }
+
+        //the active connection is the last one, so select has to look at all idle ones in front of it
+        TCPSocketPtr active = servers.back();
+        std::thread server(inUseSelect ? RunSelectEcho : RunPollerEcho, std::cref(servers), active);
+
+        TCPSocketPtr client = clients.back();
+        vector<char> message(inMessageSize, 'x');
+        vector<double> microseconds;
+        microseconds.reserve(inOptions.roundTrips);
+        bool isDone = true;
+        for (int trip = 0; trip < inOptions.roundTrips && isDone; ++trip)
+        {
+            auto sent = std::chrono::steady_clock::now();
+            isDone = SendAll(client, message.data(), inMessageSize) && ReceiveAll(client, message.data(), inMessageSize);
+            microseconds.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+        }
+        //closing the active client ends the server loop
+        clients.back().reset();
+        client.reset();
+        server.join();
+
+        LoopbackResult result{inUseSelect ? "idle_connections_select" : "idle_connections_poller",
+                              {{"idleConnections", inIdleCount}, {"messageSize", inMessageSize}}};
+        AddLatency(result, GetLatency(microseconds));
+        Print(result);
+        ioResults.push_back(result);
+        return isDone;
+    }
+
+    void RaiseDescriptorLimit()
+    {
+#if !_WIN32
+        rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+#endif
+    }
+}
+
+int RunLoopbackBenchmark(const std::vector<std::string>& args)
+{
+    LoopbackBenchmarkOptions options;
+    if (args.size() > 0) options.messageSizes = ParseSizes(args[0]);
+    if (args.size() > 1) options.concurrency = std::max(1, std::stoi(args[1]));
+    if (args.size() > 2) options.idleConnections = std::stoi(args[2]);
+    if (args.size() > 3) options.reportPath = args[3];
+
+    std::cout << "loopback: " << options.messageSizes.size() << " message sizes, " << options.concurrency
+        << " connections at once, " << options.idleConnections << " idle connections" << std::endl;
+    RaiseDescriptorLimit();
+
+    vector<LoopbackResult> results;
+    bool isDone = true;
+    for (int messageSize : options.messageSizes)
+    {
+        isDone = MeasureTCPPingPong(messageSize, options, results) && isDone;
+        isDone = MeasureUDPPingPong(messageSize, options, results) && isDone;
+        isDone = MeasureTCPStream(messageSize, options, results) && isDone;
+    }
+    isDone = MeasureConnectRate(options, results) && isDone;
+
+    //select only sees descriptors below FD_SETSIZE, every connection takes two
+    int messageSize = options.messageSizes.empty() ? 64 : options.messageSizes.front();
+    bool canSelect = 2 * options.idleConnections + 16 < FD_SETSIZE;
+    for (int idleCount : {0, options.idleConnections})
+    {
+        if (canSelect)
+        {
+            isDone = MeasureIdleConnections(idleCount, true, messageSize, options, results) && isDone;
+        }
+        isDone = MeasureIdleConnections(idleCount, false, messageSize, options, results) && isDone;
+    }
+    if (!canSelect)
+    {
+        std::cout << "idle_connections: " << options.idleConnections << " connections exceed FD_SETSIZE, select skipped" << std::endl;
+    }
+
+    if (!WriteReport(options, results))
+    {
+        std::cout << "failed to write " << options.reportPath << std::endl;
+        return 1;
+    }
+    std::cout << "report: " << options.reportPath << std::endl;
+    return isDone ? 0 : 1;
+}
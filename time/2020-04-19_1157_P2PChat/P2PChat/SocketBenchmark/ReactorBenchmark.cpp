@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Cross-shard broadcast the way the reactors of ChatServer do it: every reactor thread sleeps in its own
+// SocketPoller, sends each of its messages to all other reactors as batches and is woken by PollerWakeup.
+// The inbox is MpscQueue or a std::deque under a mutex; deliveries per second are printed for 2, 4, ... up to maxThreads
+// reactors. A reactor which waits a whole second with messages in its inbox counts as a lost wakeup.
+
+namespace
+{
+    struct ReactorBenchmarkOptions
+    {
+        int maxThreads = 4;
+        int messages = 200000;
+        int batchSize = 32;
+    };
+
+    typedef vector<uint64_t> Batch;
+
+    class LockFreeInbox
+    {
+    public:
+        void Push(Batch inBatch) { mQueue.Push(std::move(inBatch)); }
+        bool TryPop(Batch& outBatch) { return mQueue.TryPop(outBatch); }
+
+    private:
+        MpscQueue<Batch> mQueue;
+    };
+
+    class LockedInbox
+    {
+    public:
+        void Push(Batch inBatch)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push_back(std::move(inBatch));
+        }
+
+        bool TryPop(Batch& outBatch)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mQueue.empty())
+            {
+                return false;
+            }
+            outBatch = std::move(mQueue.front());
+            mQueue.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex mMutex;
+        deque<Batch> mQueue;
+    };
+
+    template <typename Inbox>
+    struct Reactor
+    {
+        SocketPoller poller;
+        PollerWakeup wakeup;
+        Inbox inbox;
+        uint64_t received = 0;
+        uint64_t checksum = 0;
+    };
+
+    template <typename Inbox>
+    int Drain(Reactor<Inbox>& ioReactor)
+    {
+        int batches = 0;
+        Batch batch;
+        while (ioReactor.inbox.TryPop(batch))
+        {
+            for (uint64_t value : batch)
+            {
+                ioReactor.checksum += value;
+            }
+            ioReactor.received += batch.size();
+            ++batches;
+        }
+        return batches;
+    }
+
+    template <typename Inbox>
+    void RunReactor(vector<unique_ptr<Reactor<Inbox>>>& ioReactors, size_t inIndex,
+                    const ReactorBenchmarkOptions& inOptions, std::atomic<int>& ioLostWakeups)
+    {
+        Reactor<Inbox>& reactor = *ioReactors[inIndex];
+        uint64_t expected = static_cast<uint64_t>(ioReactors.size() - 1) * inOptions.messages;
+        int sent = 0;
+        vector<SocketPollEvent> events;
+        while (true)
+        {
+            if (sent < inOptions.messages)
+            {
+                int count = std::min(inOptions.batchSize, inOptions.messages - sent);
+                for (size_t target = 0; target < ioReactors.size(); ++target)
+                {
+                    if (target == inIndex)
+                    {
+                        continue;
+                    }
+                    Batch batch(count);
+                    for (int i = 0; i < count; ++i)
+                    {
+                        batch[i] = sent + i;
+                    }
+                    ioReactors[target]->inbox.Push(std::move(batch));
+                    ioReactors[target]->wakeup.Notify();
+                }
+                sent += count;
+            }
+
+            if (sent == inOptions.messages && reactor.received == expected)
+            {
+                return;
+            }
+            //while it has messages of its own the reactor only polls, then it sleeps until it is woken
+            int timeoutMs = sent < inOptions.messages ? 0 : 1000;
+            reactor.poller.Wait(events, timeoutMs);
+            if (!events.empty())
+            {
+                reactor.wakeup.Clear();
+            }
+            if (Drain(reactor) > 0 && events.empty() && timeoutMs > 0)
+            {
+                ++ioLostWakeups;
+            }
+        }
+    }
+
+    template <typename Inbox>
+    void Measure(const char* inName, size_t inThreads, const ReactorBenchmarkOptions& inOptions, std::atomic<int>& ioLostWakeups)
+    {
+        vector<unique_ptr<Reactor<Inbox>>> reactors;
+        for (size_t i = 0; i < inThreads; ++i)
+        {
+            reactors.emplace_back(new Reactor<Inbox>);
+            reactors.back()->wakeup.Open();
+            reactors.back()->poller.Add(reactors.back()->wakeup.GetSocket(), POLL_READ, nullptr);
+        }
+
+        vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < inThreads; ++i)
+        {
+            threads.emplace_back([&, i] { RunReactor(reactors, i, inOptions, ioLostWakeups); });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        uint64_t delivered = 0;
+        for (auto& reactor : reactors)
+        {
+            delivered += reactor->received;
+        }
+        std::cout << "  " << inName << ": " << delivered / elapsed.count() / 1e6 << " M deliveries/s" << std::endl;
+    }
+}
+
+int RunReactorBenchmark(const std::vector<std::string>& args)
+{
+    ReactorBenchmarkOptions options;
+    if (args.size() > 0) options.maxThreads = std::stoi(args[0]);
+    if (args.size() > 1) options.messages = std::stoi(args[1]);
+    if (args.size() > 2) options.batchSize = std::max(std::stoi(args[2]), 1);
+
+    SocketUtil::StaticInit();
+    std::cout << "reactors: " << options.messages << " messages per reactor to every other one in batches of "
+        << options.batchSize << ", " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    std::atomic<int> lostWakeups(0);
+    for (int threads = 2; threads <= options.maxThreads; threads *= 2)
+    {
+        std::cout << threads << " reactors" << std::endl;
+        Measure<LockFreeInbox>("MpscQueue", threads, options, lostWakeups);
+        Measure<LockedInbox>("mutex + deque", threads, options, lostWakeups);
+    }
+    std::cout << "lost wakeups: " << lostWakeups << std::endl;
+    return lostWakeups == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Throughput and CPU time of SocketRelay over loopback: a client streams through a relay thread to a sink,
+// once with splice and once copied through the pooled buffer. Then a temporary file is sent to the sink
+// with sendfile and with read + Send.
+
+namespace
+{
+    const uint16_t RELAY_PORT = 56813;
+    const uint16_t SINK_PORT = 56814;
+
+    struct RelayBenchmarkOptions
+    {
+        int megabytes = 512;
+        int chunkSize = 16384;
+    };
+
+    struct RelayRun
+    {
+        double seconds = 0;
+        double cpuSeconds = 0;
+        long long receivedBytes = 0;
+    };
+
+    TCPSocketPtr Listen(uint16_t inPort)
+    {
+        TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
+        listenSocket->SetReuseAddress(true);
+        if (listenSocket->Bind(SocketAddress(INADDR_LOOPBACK, inPort)) != NO_ERROR || listenSocket->Listen() != NO_ERROR)
+        {
+            return nullptr;
+        }
+        return listenSocket;
+    }
+
+    // Counts bytes until the peer closes.
+    void RunSink(TCPSocketPtr inSocket, long long& outReceivedBytes)
+    {
+        vector<char> buffer(SocketRelay::CHUNK_SIZE);
+        int received;
+        while ((received = inSocket->Receive(buffer.data(), buffer.size())) > 0)
+        {
+            outReceivedBytes += received;
+        }
+    }
+
+    void Print(const char* inName, const RelayRun& inRun, uint64_t inZeroCopyBytes, uint64_t inCopiedBytes)
+    {
+        std::cout << inName << ": " << inRun.receivedBytes / inRun.seconds / (1024 * 1024) << " MB/s, "
+            << inRun.cpuSeconds << " s CPU, " << inZeroCopyBytes << " bytes zero-copy, " << inCopiedBytes << " bytes copied" << std::endl;
+    }
+
+    bool MeasureForward(const char* inName, bool inIsCopyForced, const RelayBenchmarkOptions& inOptions)
+    {
+        TCPSocketPtr relayListenSocket = Listen(RELAY_PORT);
+        TCPSocketPtr sinkListenSocket = Listen(SINK_PORT);
+        if (!relayListenSocket || !sinkListenSocket)
+        {
+            std::cout << inName << ": failed to listen" << std::endl;
+            return false;
+        }
+
+        TCPSocketPtr client = SocketUtil::CreateTCPSocket(INET);
+        TCPSocketPtr relayOut = SocketUtil::CreateTCPSocket(INET);
+        SocketAddress address;
+        if (client->Connect(SocketAddress(INADDR_LOOPBACK, RELAY_PORT)) != NO_ERROR
+            || relayOut->Connect(SocketAddress(INADDR_LOOPBACK, SINK_PORT)) != NO_ERROR)
+        {
+            std::cout << inName << ": failed to connect" << std::endl;
+            return false;
+        }
+        TCPSocketPtr relayIn = relayListenSocket->Accept(address);
+        TCPSocketPtr sink = sinkListenSocket->Accept(address);
+
+        RelayRun run;
+        SocketRelay relay(inIsCopyForced);
+        auto start = std::chrono::steady_clock::now();
+        std::clock_t cpuStart = std::clock();
+
+        std::thread sinkThread(RunSink, sink, std::ref(run.receivedBytes));
+        std::thread relayThread([&]
+        {
+            //closing the outgoing side ends the sink
+            TCPSocketPtr out = std::move(relayOut);
+            while (relay.Forward(relayIn, out) > 0)
+            {
+            }
+        });
+
+        vector<char> chunk(inOptions.chunkSize, 'r');
+        long long totalBytes = static_cast<long long>(inOptions.megabytes) * 1024 * 1024;
+        for (long long sent = 0; sent < totalBytes; sent += inOptions.chunkSize)
+        {
+            if (client->Send(chunk.data(), chunk.size()) != inOptions.chunkSize)
+            {
+                break;
+            }
+        }
+        client.reset();
+        relayThread.join();
+        sinkThread.join();
+
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        Print(inName, run, relay.GetZeroCopyBytes(), relay.GetCopiedBytes());
+        long long expectedBytes = (totalBytes + inOptions.chunkSize - 1) / inOptions.chunkSize * inOptions.chunkSize;
+        return run.receivedBytes == expectedBytes && (inIsCopyForced ? relay.GetZeroCopyBytes() == 0 : relay.GetCopiedBytes() == 0);
+    }
+
+    bool MeasureSendFile(const char* inName, bool inIsCopyForced, int inFile, long long inFileLength)
+    {
+        TCPSocketPtr sinkListenSocket = Listen(SINK_PORT);
+        TCPSocketPtr out = SocketUtil::CreateTCPSocket(INET);
+        SocketAddress address;
+        if (!sinkListenSocket || out->Connect(SocketAddress(INADDR_LOOPBACK, SINK_PORT)) != NO_ERROR)
+        {
+            std::cout << inName << ": failed to connect" << std::endl;
+            return false;
+        }
+        TCPSocketPtr sink = sinkListenSocket->Accept(address);
+
+        RelayRun run;
+        SocketRelay relay(inIsCopyForced);
+        auto start = std::chrono::steady_clock::now();
+        std::clock_t cpuStart = std::clock();
+        std::thread sinkThread(RunSink, sink, std::ref(run.receivedBytes));
+
+        int64_t offset = 0;
+        while (offset < inFileLength && relay.SendFile(inFile, offset, static_cast<size_t>(inFileLength - offset), out) > 0)
+        {
+        }
+        out.reset();
+        sinkThread.join();
+
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        Print(inName, run, relay.GetZeroCopyBytes(), relay.GetCopiedBytes());
+        return run.receivedBytes == inFileLength;
+    }
+
+    bool MeasureFiles(const RelayBenchmarkOptions& inOptions)
+    {
+#if _WIN32
+        std::cout << "sendfile: skipped on Windows" << std::endl;
+        return true;
+#else
+        char path[] = "/tmp/relay_benchmark_XXXXXX";
+        int file = mkstemp(path);
+        if (file < 0)
+        {
+            std::cout << "sendfile: failed to create " << path << std::endl;
+            return false;
+        }
+        unlink(path);
+
+        vector<char> chunk(SocketRelay::CHUNK_SIZE, 'f');
+        long long fileLength = static_cast<long long>(inOptions.megabytes) * 1024 * 1024;
+        for (long long written = 0; written < fileLength; written += chunk.size())
+        {
+            if (write(file, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size()))
+            {
+                close(file);
+                return false;
+            }
+        }
+
+        bool isDone = MeasureSendFile("sendfile", false, file, fileLength);
+        isDone = MeasureSendFile("read + Send", true, file, fileLength) && isDone;
+        close(file);
+        return isDone;
+#endif
+    }
+}
+
+int RunRelayBenchmark(const std::vector<std::string>& args)
+{
+    RelayBenchmarkOptions options;
+    if (args.size() > 0) options.megabytes = std::stoi(args[0]);
+    if (args.size() > 1) options.chunkSize = std::stoi(args[1]);
+
+#if !_WIN32
+    //a relay writing to a closed sink gets the error instead of the signal
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    std::cout << "relay: " << options.megabytes << " MB in chunks of " << options.chunkSize << " bytes" << std::endl;
+
+    bool isDone = MeasureForward("splice", false, options);
+    isDone = MeasureForward("Receive + Send", true, options) && isDone;
+    isDone = MeasureFiles(options) && isDone;
+    return isDone ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Transfer over ReliableConnection on loopback through LossyTransport on both sides.
+// Every ordered message carries its index, so lost, duplicated or reordered delivery is detected.
+
+namespace
+{
+    const uint16_t SENDER_PORT = 56804;
+    const uint16_t RECEIVER_PORT = 56805;
+    const auto TRANSFER_TIMEOUT = std::chrono::seconds(60);
+
+    struct ReliableOptions
+    {
+        int messages = 2000;
+        double lossRate = 0.02;
+        int delayMs = 10;
+        int jitterMs = 2;
+        int messageSize = 512;
+    };
+
+    DatagramTransportPtr CreateTransport(uint16_t inPort, const ReliableOptions& inOptions, uint32_t inSeed)
+    {
+        UDPSocketPtr socket = SocketUtil::CreateUDPSocket(INET);
+        if (!socket || socket->Bind(SocketAddress(INADDR_LOOPBACK, inPort)) != NO_ERROR)
+        {
+            return nullptr;
+        }
+        return std::make_shared<LossyTransport>(std::make_shared<UDPTransport>(socket), inOptions.lossRate,
+                                                inOptions.delayMs, inOptions.jitterMs, inSeed);
+    }
+}
+
+int RunReliableBenchmark(const std::vector<std::string>& args)
+{
+    ReliableOptions options;
+    if (args.size() > 0) options.messages = std::stoi(args[0]);
+    if (args.size() > 1) options.lossRate = std::stod(args[1]) / 100;
+    if (args.size() > 2) options.delayMs = std::stoi(args[2]);
+    if (args.size() > 3) options.jitterMs = std::stoi(args[3]);
+
+    std::cout << "reliable: " << options.messages << " messages of " << options.messageSize << " bytes, "
+        << options.lossRate * 100 << "% loss, " << options.delayMs << "+" << options.jitterMs
+        << " ms delay each way" << std::endl;
+
+    DatagramTransportPtr senderTransport = CreateTransport(SENDER_PORT, options, 1);
+    DatagramTransportPtr receiverTransport = CreateTransport(RECEIVER_PORT, options, 2);
+    if (!senderTransport || !receiverTransport)
+    {
+        std::cout << "reliable: bind failed" << std::endl;
+        return 1;
+    }
+    ReliableConnection sender(senderTransport, SocketAddress(INADDR_LOOPBACK, RECEIVER_PORT));
+    ReliableConnection receiver(receiverTransport, SocketAddress(INADDR_LOOPBACK, SENDER_PORT));
+
+    vector<char> message(options.messageSize, 'x');
+    for (int i = 0; i < options.messages; ++i)
+    {
+        memcpy(message.data(), &i, sizeof(i));
+        sender.Send(message.data(), message.size());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int received = 0;
+    bool isInOrder = true;
+    vector<char> buffer(ReliableConnection::MAX_MESSAGE_SIZE);
+    while (received < options.messages && !sender.IsConnectionLost()
+           && std::chrono::steady_clock::now() - start < TRANSFER_TIMEOUT)
+    {
+        sender.Update();
+        receiver.Update();
+        while (receiver.Receive(buffer.data(), buffer.size()) > 0)
+        {
+            int index;
+            memcpy(&index, buffer.data(), sizeof(index));
+            isInOrder = isInOrder && index == received;
+            ++received;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "delivered " << received << "/" << options.messages << (isInOrder ? " in order" : " OUT OF ORDER")
+        << " in " << elapsed.count() << " s, " << static_cast<long>(received / elapsed.count()) << " msg/s, "
+        << sender.GetRetransmitCount() << " retransmits, rtt " << sender.GetRoundTripTimeMs() << " ms, cwnd "
+        << sender.GetCongestionWindow() << std::endl;
+
+    return received == options.messages && isInOrder ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <iostream>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Cost of turning "host:port" into addresses before a connect: getaddrinfo every time
+// against AddressResolver, which asks once and then answers from its cache.
+
+namespace
+{
+    struct ResolveOptions
+    {
+        string name = "localhost:56740";
+        int lookups = 1000;
+    };
+
+    double ToMicroseconds(std::chrono::steady_clock::duration inDuration)
+    {
+        return std::chrono::duration<double, std::micro>(inDuration).count();
+    }
+}
+
+int RunResolveBenchmark(const std::vector<std::string>& args)
+{
+    ResolveOptions options;
+    if (args.size() > 0) options.name = args[0];
+    if (args.size() > 1) options.lookups = std::stoi(args[1]);
+
+    std::cout << "resolve: " << options.name << ", " << options.lookups << " lookups" << std::endl;
+
+    vector<SocketAddress> addresses;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.lookups; ++i)
+    {
+        if (SocketAddressFactory::CreateAllFromString(options.name, addresses) != NO_ERROR)
+        {
+            std::cout << "getaddrinfo failed" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "getaddrinfo: " << ToMicroseconds(std::chrono::steady_clock::now() - start) / options.lookups
+        << " us per lookup" << std::endl;
+
+    AddressResolver resolver;
+    start = std::chrono::steady_clock::now();
+    ResolveResult result = resolver.Resolve(options.name).get();
+    std::cout << "AddressResolver first lookup: " << ToMicroseconds(std::chrono::steady_clock::now() - start)
+        << " us,";
+    for (const SocketAddress& address : result.addresses)
+    {
+        std::cout << " " << address.ToString();
+    }
+    std::cout << std::endl;
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.lookups; ++i)
+    {
+        resolver.Resolve(options.name, [&found](const ResolveResult& inResult) { found += inResult.addresses.size(); });
+    }
+    std::cout << "AddressResolver cached: " << ToMicroseconds(std::chrono::steady_clock::now() - start) * 1000
+        / options.lookups << " ns per lookup" << std::endl;
+
+    return found == result.addresses.size() * options.lookups ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Idle connection timeouts on a simulated clock: every connection schedules a timeout of 1 to 60 seconds,
+// moves it forward a few times because data arrived, some connections close and cancel it, then the clock
+// runs until all timeouts fired. TimerWheel against a std::priority_queue, which cannot remove an entry,
+// so a cancelled or moved timer leaves a stale entry behind which is skipped when it comes to the top.
+
+namespace
+{
+    typedef TimerWheel::Clock Clock;
+
+    struct TimerBenchmarkOptions
+    {
+        int maxTimers = 1000000;
+        int reschedules = 3;
+        int cancelPercent = 10;
+        int stepMs = 10;
+    };
+
+    class HeapTimers
+    {
+    public:
+        TimerId ScheduleAt(Clock::time_point inTime, TimerWheel::Callback inCallback)
+        {
+            TimerId timer = mCallbacks.size();
+            mCallbacks.push_back(std::move(inCallback));
+            mGenerations.push_back(0);
+            mHeap.push({inTime, timer, 0});
+            return timer;
+        }
+
+        void Cancel(TimerId inTimer)
+        {
+            ++mGenerations[inTimer];
+            mCallbacks[inTimer] = nullptr;
+        }
+
+        void RescheduleAt(TimerId inTimer, Clock::time_point inTime)
+        {
+            mHeap.push({inTime, inTimer, ++mGenerations[inTimer]});
+        }
+
+        size_t Advance(Clock::time_point inNow)
+        {
+            size_t firedCount = 0;
+            while (!mHeap.empty() && mHeap.top().time <= inNow)
+            {
+                Entry entry = mHeap.top();
+                mHeap.pop();
+                if (entry.generation == mGenerations[entry.timer] && mCallbacks[entry.timer])
+                {
+                    TimerWheel::Callback callback = std::move(mCallbacks[entry.timer]);
+                    mCallbacks[entry.timer] = nullptr;
+                    callback();
+                    ++firedCount;
+                }
+            }
+            return firedCount;
+        }
+
+        bool IsEmpty() const { return mHeap.empty(); }
+
+    private:
+        struct Entry
+        {
+            Clock::time_point time;
+            TimerId timer;
+            uint32_t generation;
+            bool operator>(const Entry& inOther) const { return time > inOther.time; }
+        };
+
+        std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> mHeap;
+        vector<TimerWheel::Callback> mCallbacks;
+        vector<uint32_t> mGenerations;
+    };
+
+    struct TimerResult
+    {
+        double scheduleNs = 0;
+        double rescheduleNs = 0;
+        double cancelNs = 0;
+        double fireNs = 0;
+        long firedCount = 0;
+    };
+
+    double NsPerOperation(Clock::time_point inStart, long inOperations)
+    {
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - inStart;
+        return inOperations > 0 ? elapsed.count() / inOperations : 0;
+    }
+
+    // Runs the same sequence of delays against TimerWheel or HeapTimers.
+    template <typename Timers>
+    TimerResult Measure(Timers& ioTimers, Clock::time_point inStart, int inCount, const TimerBenchmarkOptions& inOptions)
+    {
+        TimerResult result;
+        std::mt19937 random(inCount);
+        std::uniform_int_distribution<int> delays(1000, 60000);
+        long firedCount = 0;
+
+        vector<TimerId> timers(inCount);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < inCount; ++i)
+        {
+            timers[i] = ioTimers.ScheduleAt(inStart + std::chrono::milliseconds(delays(random)), [&firedCount] { ++firedCount; });
+        }
+        result.scheduleNs = NsPerOperation(start, inCount);
+
+        start = Clock::now();
+        for (int round = 0; round < inOptions.reschedules; ++round)
+        {
+            for (int i = 0; i < inCount; ++i)
+            {
+                ioTimers.RescheduleAt(timers[i], inStart + std::chrono::milliseconds(delays(random)));
+            }
+        }
+        result.rescheduleNs = NsPerOperation(start, static_cast<long>(inCount) * inOptions.reschedules);
+
+        int cancelCount = static_cast<int>(static_cast<long>(inCount) * inOptions.cancelPercent / 100);
+        start = Clock::now();
+        for (int i = 0; i < cancelCount; ++i)
+        {
+            ioTimers.Cancel(timers[i]);
+        }
+        result.cancelNs = NsPerOperation(start, cancelCount);
+
+        //the event loop wakes every stepMs until the last timeout is gone
+        start = Clock::now();
+        for (int ms = 0; ms <= 60000 + inOptions.stepMs; ms += inOptions.stepMs)
+        {
+            ioTimers.Advance(inStart + std::chrono::milliseconds(ms));
+        }
+        result.firedCount = firedCount;
+        result.fireNs = NsPerOperation(start, inCount - cancelCount);
+        return result;
+    }
+
+    void Print(const char* inName, const TimerResult& inResult)
+    {
+        std::cout << "  " << inName << ": schedule " << inResult.scheduleNs << " ns, reschedule " << inResult.rescheduleNs
+            << " ns, cancel " << inResult.cancelNs << " ns, fire " << inResult.fireNs << " ns per timer, "
+            << inResult.firedCount << " fired" << std::endl;
+    }
+}
+
+int RunTimerBenchmark(const std::vector<std::string>& args)
+{
+    TimerBenchmarkOptions options;
+    if (args.size() > 0) options.maxTimers = std::stoi(args[0]);
+    if (args.size() > 1) options.reschedules = std::stoi(args[1]);
+    if (args.size() > 2) options.cancelPercent = std::stoi(args[2]);
+
+    std::cout << "timers: up to " << options.maxTimers << " timeouts, " << options.reschedules << " reschedules each, "
+        << options.cancelPercent << "% cancelled, advanced every " << options.stepMs << " ms" << std::endl;
+
+    bool isDone = true;
+    for (int count = 1000; count <= options.maxTimers; count *= 10)
+    {
+        std::cout << count << " timers" << std::endl;
+        Clock::time_point start = Clock::now();
+
+        TimerWheel wheel(std::chrono::milliseconds(1), start);
+        TimerResult wheelResult = Measure(wheel, start, count, options);
+        Print("TimerWheel", wheelResult);
+
+        HeapTimers heap;
+        TimerResult heapResult = Measure(heap, start, count, options);
+        Print("priority_queue", heapResult);
+
+        long expectedCount = count - static_cast<long>(count) * options.cancelPercent / 100;
+        isDone = isDone && wheelResult.firedCount == expectedCount && heapResult.firedCount == expectedCount
+            && wheel.GetCount() == 0 && heap.IsEmpty();
+    }
+    return isDone ? 0 : 1;
+}
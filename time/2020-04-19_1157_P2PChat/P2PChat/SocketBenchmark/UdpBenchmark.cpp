@@ -0,0 +1,198 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+// Loopback packets per second: one thread sends datagrams as fast as it can, another one counts them.
+// Datagrams dropped by a full receive buffer are reported as lost, so the threads need separate cores.
+
+namespace
+{
+    const uint16_t UDP_PORT = 56803;
+    const size_t GRO_SLOT_SIZE = 65536;
+    const auto IDLE_TIMEOUT = std::chrono::milliseconds(300);
+
+    enum UdpMode
+    {
+        UDP_SINGLE,
+        UDP_BATCH,
+        UDP_OFFLOAD
+    };
+
+    struct UdpOptions
+    {
+        int datagrams = 1000000;
+        int datagramSize = 64;
+        int batchSize = 64;
+    };
+
+    struct UdpResult
+    {
+        double sendSeconds = 0;
+        // from the first to the last received datagram
+        double receiveSeconds = 0;
+        long received = 0;
+    };
+
+    long CountDatagrams(const DatagramBatch& inBatch)
+    {
+        long count = 0;
+        for (size_t i = 0; i < inBatch.GetCount(); ++i)
+        {
+            size_t segmentSize = inBatch.GetSegmentSize(i);
+            count += segmentSize ? static_cast<long>((inBatch.GetLength(i) + segmentSize - 1) / segmentSize) : 1;
+        }
+        return count;
+    }
+
+    void RunReceiver(const UDPSocketPtr& inSocket, UdpMode inMode, const UdpOptions& inOptions,
+                     const std::atomic<bool>& inIsSenderDone, UdpResult& outResult)
+    {
+        DatagramBatch batch(inOptions.batchSize, inMode == UDP_OFFLOAD ? GRO_SLOT_SIZE : inOptions.datagramSize);
+        vector<char> datagram(inOptions.datagramSize);
+        auto firstReceive = std::chrono::steady_clock::now();
+        auto lastReceive = firstReceive;
+
+        while (outResult.received < inOptions.datagrams)
+        {
+            long received = 0;
+            if (inMode == UDP_SINGLE)
+            {
+                SocketAddress fromAddress;
+                received = inSocket->ReceiveFrom(datagram.data(), inOptions.datagramSize, fromAddress) > 0 ? 1 : 0;
+            }
+            else if (inSocket->ReceiveBatch(batch) > 0)
+            {
+                received = CountDatagrams(batch);
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (received > 0)
+            {
+                if (outResult.received == 0)
+                {
+                    firstReceive = now;
+                }
+                outResult.received += received;
+                lastReceive = now;
+            }
+            else if (inIsSenderDone && now - lastReceive > IDLE_TIMEOUT)
+            {
+                break;
+            }
+        }
+
+        std::chrono::duration<double> elapsed = lastReceive - firstReceive;
+        outResult.receiveSeconds = elapsed.count();
+    }
+
+    double RunSender(const UDPSocketPtr& inSocket, UdpMode inMode, const UdpOptions& inOptions)
+    {
+        SocketAddress toAddress(INADDR_LOOPBACK, UDP_PORT);
+        string datagram(inOptions.datagramSize, 'x');
+
+        DatagramBatch batch(inOptions.batchSize, inOptions.datagramSize);
+        while (batch.Add(datagram.data(), datagram.size(), toAddress))
+        {
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int sent = 0; sent < inOptions.datagrams;)
+        {
+            if (inMode == UDP_SINGLE)
+            {
+                if (inSocket->SendTo(datagram.data(), inOptions.datagramSize, toAddress) > 0)
+                {
+                    ++sent;
+                }
+                continue;
+            }
+
+            size_t count = std::min<size_t>(batch.GetCapacity(), inOptions.datagrams - sent);
+            batch.Clear();
+            while (batch.GetCount() < count)
+            {
+                batch.Commit(datagram.size(), toAddress);
+            }
+            for (size_t first = 0; first < count;)
+            {
+                int result = inSocket->SendBatch(batch, first);
+                if (result < 0)
+                {
+                    break;
+                }
+                first += result;
+                sent += result;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    bool RunUdp(UdpMode inMode, const UdpOptions& inOptions, UdpResult& outResult)
+    {
+        UDPSocketPtr receiver = SocketUtil::CreateUDPSocket(INET);
+        UDPSocketPtr sender = SocketUtil::CreateUDPSocket(INET);
+        if (!receiver || !sender || receiver->Bind(SocketAddress(INADDR_LOOPBACK, UDP_PORT)) != NO_ERROR)
+        {
+            return false;
+        }
+        receiver->SetNonBlockingMode(true);
+
+        if (inMode == UDP_OFFLOAD
+            && (sender->EnableSegmentationOffload() != NO_ERROR || receiver->EnableReceiveOffload() != NO_ERROR))
+        {
+            return false;
+        }
+
+        std::atomic<bool> isSenderDone(false);
+        std::thread receiverThread([&] { RunReceiver(receiver, inMode, inOptions, isSenderDone, outResult); });
+
+        outResult.sendSeconds = RunSender(sender, inMode, inOptions);
+        isSenderDone = true;
+        receiverThread.join();
+        return true;
+    }
+
+    void PrintResult(const char* inName, const UdpOptions& inOptions, const UdpResult& inResult)
+    {
+        double lostPercent = 100.0 * (inOptions.datagrams - inResult.received) / inOptions.datagrams;
+        double receivedPerSecond = inResult.received / std::max(inResult.receiveSeconds, 1e-9);
+        std::cout << inName << ": " << static_cast<long>(inOptions.datagrams / inResult.sendSeconds) << " sent pps, "
+            << static_cast<long>(receivedPerSecond) << " received pps, " << lostPercent << "% lost" << std::endl;
+    }
+}
+
+int RunUdpBenchmark(const std::vector<std::string>& args)
+{
+    UdpOptions options;
+    if (args.size() > 0) options.datagrams = std::stoi(args[0]);
+    if (args.size() > 1) options.datagramSize = std::stoi(args[1]);
+    if (args.size() > 2) options.batchSize = std::stoi(args[2]);
+
+    std::cout << "udp: " << options.datagrams << " datagrams, " << options.datagramSize << " bytes, batch "
+        << options.batchSize << std::endl;
+
+    const std::pair<UdpMode, const char*> modes[] = {
+        {UDP_SINGLE, "SendTo/ReceiveFrom"},
+        {UDP_BATCH, "sendmmsg/recvmmsg"},
+        {UDP_OFFLOAD, "sendmmsg/recvmmsg + GSO/GRO"},
+    };
+    for (const auto& mode : modes)
+    {
+        UdpResult result;
+        if (RunUdp(mode.first, options, result))
+        {
+            PrintResult(mode.second, options, result);
+        }
+        else
+        {
+            std::cout << mode.second << ": not supported" << std::endl;
+        }
+    }
+
+    return 0;
+}
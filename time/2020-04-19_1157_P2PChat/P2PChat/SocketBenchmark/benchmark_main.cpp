@@ -0,0 +1,45 @@
+#include <functional>
+#include <iostream>
+#include <map>
+
+#include "SocketWrapperLib/SocketWrapperShared.h"
+#include "Benchmarks.h"
+
+int main(int argc, char* argv[])
+{
+    const std::map<std::string, std::function<int(const std::vector<std::string>&)>> benchmarks = {
+        {"accept", RunAcceptBenchmark},
+        {"address", RunAddressBenchmark},
+        {"buffers", RunBufferBenchmark},
+        {"connect", RunConnectBenchmark},
+        {"connections", RunConnectionBenchmark},
+        {"echo", RunEchoBenchmark},
+        {"errors", RunErrorBenchmark},
+        {"local", RunLocalBenchmark},
+        {"loopback", RunLoopbackBenchmark},
+        {"timers", RunTimerBenchmark},
+        {"udp", RunUdpBenchmark},
+        {"reactors", RunReactorBenchmark},
+        {"relay", RunRelayBenchmark},
+        {"reliable", RunReliableBenchmark},
+        {"resolve", RunResolveBenchmark},
+    };
+
+    auto benchmark = argc > 1 ? benchmarks.find(argv[1]) : benchmarks.end();
+    if (benchmark == benchmarks.end())
+    {
+        std::cout << "Usage: SocketBenchmark <benchmark> [args...]" << std::endl;
+        std::cout << "Benchmarks:";
+        for (const auto& b : benchmarks)
+        {
+            std::cout << " " << b.first;
+        }
+        std::cout << std::endl;
+        return 1;
+    }
+
+    SocketUtil::StaticInit();
+    int result = benchmark->second(std::vector<std::string>(argv + 2, argv + argc));
+    SocketUtil::CleanUp();
+    return result;
+}
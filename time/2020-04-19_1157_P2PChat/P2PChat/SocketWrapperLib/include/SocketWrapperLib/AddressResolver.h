@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "SocketWrapperShared.h"
+
+struct ResolveResult
+{
+    // NO_ERROR or the getaddrinfo error
+    int error;
+    vector<SocketAddress> addresses;
+};
+
+typedef std::function<void(const ResolveResult&)> ResolveCallback;
+
+// Resolves "host:port" strings with SocketAddressFactory::CreateAllFromString on a few worker threads,
+// so the blocking system resolver never stalls the caller.
+// Results are cached: addresses for inTimeToLive, names which do not exist for inNegativeTimeToLive,
+// temporary failures are not cached. getaddrinfo does not tell the TTL of the records, so both are fixed.
+// Concurrent requests for the same name share one lookup.
+// Callbacks run on a worker thread, or before Resolve returns when the result is cached.
+class AddressResolver
+{
+public:
+    AddressResolver(size_t inThreadCount = 2,
+                    std::chrono::seconds inTimeToLive = std::chrono::seconds(60),
+                    std::chrono::seconds inNegativeTimeToLive = std::chrono::seconds(5));
+    // Waits for running lookups, requests still queued get EAI_AGAIN.
+    ~AddressResolver();
+
+    void Resolve(const string& inString, ResolveCallback inCallback);
+    std::future<ResolveResult> Resolve(const string& inString);
+    // Cache lookup only. Returns false when the name has to be resolved.
+    bool TryGetCached(const string& inString, ResolveResult& outResult);
+    void ClearCache();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct CacheEntry
+    {
+        ResolveResult result;
+        Clock::time_point expiryTime;
+    };
+
+    bool FindCached(const string& inString, ResolveResult& outResult);
+    void RunWorker();
+
+    std::chrono::seconds mTimeToLive;
+    std::chrono::seconds mNegativeTimeToLive;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    unordered_map<string, CacheEntry> mCache;
+    // callbacks of names which are queued or being resolved
+    unordered_map<string, vector<ResolveCallback>> mWaiting;
+    deque<string> mQueue;
+    bool mIsStopping;
+    vector<std::thread> mThreads;
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+
+#include "SocketWrapperShared.h"
+
+class BufferPool;
+
+// One fixed-size buffer of a BufferPool. Header and data each start on their own cache line,
+// so buffers used by different threads never share one. Reference counted through PooledBufferPtr.
+class PooledBuffer
+{
+public:
+    char* GetData() { return mData; }
+    const char* GetData() const { return mData; }
+    size_t GetCapacity() const { return mCapacity; }
+    // Bytes in use from the start of the data.
+    size_t GetLength() const { return mLength; }
+    void SetLength(size_t inLength) { mLength = static_cast<uint32_t>(inLength); }
+    BufferPool& GetPool() const { return *mPool; }
+
+private:
+    friend class BufferPool;
+    friend class PooledBufferPtr;
+
+    PooledBuffer(BufferPool* inPool, char* inData, size_t inCapacity);
+
+    BufferPool* mPool;
+    char* mData;
+    uint32_t mCapacity;
+    uint32_t mLength;
+    std::atomic<uint32_t> mReferenceCount;
+    PooledBuffer* mNextFree;
+};
+
+// Shared ownership of a PooledBuffer without a separate control block: copies share the buffer,
+// the last one gives it back to the pool. Copying is an atomic increment, so a received message can
+// be handed to many recipients without copying its bytes.
+class PooledBufferPtr
+{
+public:
+    PooledBufferPtr(): mBuffer(nullptr) {}
+    PooledBufferPtr(const PooledBufferPtr& inOther);
+    PooledBufferPtr(PooledBufferPtr&& inOther) noexcept: mBuffer(inOther.mBuffer) { inOther.mBuffer = nullptr; }
+    ~PooledBufferPtr() { Reset(); }
+    PooledBufferPtr& operator=(PooledBufferPtr inOther) noexcept;
+
+    void Reset();
+    PooledBuffer* Get() const { return mBuffer; }
+    PooledBuffer* operator->() const { return mBuffer; }
+    PooledBuffer& operator*() const { return *mBuffer; }
+    explicit operator bool() const { return mBuffer != nullptr; }
+    uint32_t GetUseCount() const { return mBuffer ? mBuffer->mReferenceCount.load(std::memory_order_relaxed) : 0; }
+
+private:
+    friend class BufferPool;
+
+    explicit PooledBufferPtr(PooledBuffer* inBuffer): mBuffer(inBuffer) {}
+
+    PooledBuffer* mBuffer;
+};
+
+// Slab allocator for receive buffers of one size. Buffers are carved out of slabs of inBuffersPerSlab
+// and never freed before the pool; every thread keeps up to inThreadCacheSize free buffers and trades
+// them with the shared free list in batches, so Acquire and the last release take no lock and allocate
+// nothing once the pool is warm. A buffer may be released on another thread than the one which acquired it.
+// The pool has to outlive its buffers; GetDefault lives until the process ends.
+class BufferPool
+{
+public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    explicit BufferPool(size_t inBufferSize = 2048, size_t inBuffersPerSlab = 256, size_t inThreadCacheSize = 64);
+    ~BufferPool();
+
+    PooledBufferPtr Acquire();
+
+    size_t GetBufferSize() const { return mBufferSize; }
+    size_t GetSlabCount() const;
+    // Buffers handed out and not yet returned.
+    size_t GetUsedCount() const { return mUsedCount.load(std::memory_order_relaxed); }
+
+    // 2 KB buffers for everything which has no pool of its own.
+    static BufferPool& GetDefault();
+
+private:
+    friend class PooledBufferPtr;
+    friend class BufferPoolThreadCaches;
+    struct ThreadCache;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    void Release(PooledBuffer* inBuffer);
+    void AllocateSlab();
+    ThreadCache& GetThreadCache();
+    // moves up to inCount buffers from the shared list into ioCache, allocating a slab when it is empty
+    void Refill(ThreadCache& ioCache, size_t inCount);
+    void Drain(ThreadCache& ioCache, size_t inCount);
+    // the shared free list, under mMutex
+    PooledBuffer* PopShared();
+    void PushShared(PooledBuffer* inBuffer);
+
+    size_t mBufferSize;
+    size_t mBuffersPerSlab;
+    size_t mThreadCacheSize;
+    size_t mStride;
+    uint64_t mId;
+    mutable std::mutex mMutex;
+    vector<void*> mSlabs;
+    PooledBuffer* mFreeList;
+    std::atomic<size_t> mUsedCount;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "SocketWrapperShared.h"
+
+struct ConnectionPoolOptions
+{
+    size_t maxIdlePerEndpoint = 8;
+    int idleTimeoutMs = 60000;
+    ConnectOptions connect;
+};
+
+// Connected sockets kept per "host:port", so a request skips name resolution and the TCP handshake.
+// Acquire hands out the most recently released idle connection which passes TCPSocket::IsIdleConnectionAlive,
+// or connects a new one (AddressResolver, then TCPConnector). Release gives it back for the next request.
+// Prewarm asks a background thread to keep connections ready, it refills them as they are taken
+// and closes idle ones which timed out or were closed by the peer.
+class ConnectionPool
+{
+public:
+    ConnectionPool(const ConnectionPoolOptions& inOptions = ConnectionPoolOptions());
+    // Waits for a connect of the background thread in progress.
+    ~ConnectionPool();
+
+    // Returns nullptr and the getaddrinfo or socket error when no connection could be made.
+    TCPSocketPtr Acquire(const string& inEndpoint, int* outError = nullptr);
+    // Only connections between two requests should come back, with nothing left to read.
+    void Release(const string& inEndpoint, TCPSocketPtr inSocket);
+    void Prewarm(const string& inEndpoint, size_t inIdleCount);
+    size_t GetIdleCount(const string& inEndpoint);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct IdleConnection
+    {
+        TCPSocketPtr socket;
+        Clock::time_point idleSince;
+    };
+
+    struct Endpoint
+    {
+        deque<IdleConnection> idle;
+        size_t warmCount = 0;
+    };
+
+    TCPSocketPtr Connect(const string& inEndpoint, int* outError);
+    TCPSocketPtr TakeIdle(Endpoint& ioEndpoint, Clock::time_point inNow);
+    void CloseStale(Clock::time_point inNow);
+    void RunMaintenance();
+
+    ConnectionPoolOptions mOptions;
+    AddressResolver mResolver;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    unordered_map<string, Endpoint> mEndpoints;
+    bool mIsStopping;
+    std::thread mMaintenanceThread;
+};
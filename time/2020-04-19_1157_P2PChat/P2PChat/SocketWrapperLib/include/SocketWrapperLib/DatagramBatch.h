@@ -0,0 +1,50 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
+
+// Preallocated storage for many datagrams, so UDPSocket::SendBatch and ReceiveBatch
+// move them with one system call and no allocations.
+// Every entry has a slot of inMaxDatagramSize bytes in one arena.
+class DatagramBatch
+{
+public:
+    DatagramBatch(size_t inCapacity, size_t inMaxDatagramSize = 1500);
+
+    size_t GetCapacity() const { return mAddresses.size(); }
+    size_t GetCount() const { return mCount; }
+    size_t GetMaxDatagramSize() const { return mMaxDatagramSize; }
+    void Clear() { mCount = 0; }
+
+    // Copies the datagram into the next slot. Returns false when the batch is full or the datagram is too big.
+    bool Add(const void* inData, size_t inLength, const SocketAddress& inToAddress);
+    // Slot for filling in place, the entry is added by Commit.
+    char* GetNextSlot();
+    bool Commit(size_t inLength, const SocketAddress& inToAddress);
+
+    const char* GetData(size_t inIndex) const { return &mArena[inIndex * mMaxDatagramSize]; }
+    size_t GetLength(size_t inIndex) const { return mLengths[inIndex]; }
+    const SocketAddress& GetAddress(size_t inIndex) const { return mAddresses[inIndex]; }
+    // Not 0 when the kernel joined several datagrams into the entry (UDPSocket::EnableReceiveOffload):
+    // they are GetSegmentSize bytes each, the last one may be shorter.
+    size_t GetSegmentSize(size_t inIndex) const { return mSegmentSizes[inIndex]; }
+
+private:
+    friend class UDPSocket;
+
+    vector<char> mArena;
+    vector<size_t> mLengths;
+    vector<SocketAddress> mAddresses;
+    vector<size_t> mSegmentSizes;
+    size_t mMaxDatagramSize;
+    size_t mCount;
+
+#ifdef __linux__
+    // system call descriptors, reused by every call
+    mutable vector<mmsghdr> mHeaders;
+    mutable vector<iovec> mBuffers;
+    mutable vector<char> mControl;
+#endif
+};
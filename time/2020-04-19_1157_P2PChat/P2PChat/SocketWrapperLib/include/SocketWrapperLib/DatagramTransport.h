@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <random>
+
+#include "SocketWrapperShared.h"
+
+// Where ReliableConnection sends and receives its datagrams.
+// ReceiveFrom returns 0 when nothing is queued, like a non-blocking UDPSocket.
+class DatagramTransport
+{
+public:
+    virtual ~DatagramTransport() {}
+    virtual int SendTo(const void* inData, int inLength, const SocketAddress& inToAddress) = 0;
+    virtual int ReceiveFrom(void* inBuffer, int inMaxLength, SocketAddress& outFromAddress) = 0;
+};
+
+typedef shared_ptr<DatagramTransport> DatagramTransportPtr;
+
+class UDPTransport : public DatagramTransport
+{
+public:
+    // Switches the socket to non-blocking mode.
+    UDPTransport(UDPSocketPtr inSocket);
+    int SendTo(const void* inData, int inLength, const SocketAddress& inToAddress) override;
+    int ReceiveFrom(void* inBuffer, int inMaxLength, SocketAddress& outFromAddress) override;
+
+private:
+    UDPSocketPtr mSocket;
+};
+
+// Drops and delays outgoing datagrams of another transport to reproduce a bad network on loopback.
+// Jitter reorders datagrams. Delayed datagrams are passed on by the next SendTo or ReceiveFrom call.
+class LossyTransport : public DatagramTransport
+{
+public:
+    LossyTransport(DatagramTransportPtr inTransport, double inLossRate, int inDelayMs, int inJitterMs = 0,
+                   uint32_t inSeed = 1);
+    int SendTo(const void* inData, int inLength, const SocketAddress& inToAddress) override;
+    int ReceiveFrom(void* inBuffer, int inMaxLength, SocketAddress& outFromAddress) override;
+
+    uint64_t GetDroppedCount() const { return mDroppedCount; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct DelayedDatagram
+    {
+        Clock::time_point dueTime;
+        vector<char> data;
+        SocketAddress toAddress;
+
+        bool operator>(const DelayedDatagram& inOther) const { return dueTime > inOther.dueTime; }
+    };
+
+    void SendDueDatagrams();
+
+    DatagramTransportPtr mTransport;
+    double mLossRate;
+    int mDelayMs;
+    int mJitterMs;
+    std::mt19937 mRandom;
+    std::priority_queue<DelayedDatagram, vector<DelayedDatagram>, std::greater<DelayedDatagram>> mDelayed;
+    uint64_t mDroppedCount;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+enum LocalSocketType
+{
+    LOCAL_STREAM = SOCK_STREAM,
+    // connected like a stream, but every Send arrives as one message and a Receive never merges messages
+    LOCAL_SEQPACKET = SOCK_SEQPACKET
+};
+
+// AF_UNIX socket for processes on the same host, the data never passes the TCP/IP stack.
+// It is a TCPSocket for everything connected sockets have in common: Send, Receive, SendV, ReceiveV,
+// Listen, SetNonBlockingMode, SocketUtil::Select, SocketPoller and AsyncSocket take it as a TCPSocketPtr.
+// The TCP options of TCPSocket do not apply. Not supported on Windows.
+class LocalSocket : public TCPSocket
+{
+public:
+    // inPath is a file system path, the file stays after the socket is closed and has to be removed
+    // before the next Bind. On Linux a leading '@' names the socket in the abstract namespace instead,
+    // which needs no file and disappears with the last socket.
+    int Bind(const string& inPath);
+    int Connect(const string& inPath);
+    shared_ptr<LocalSocket> Accept();
+
+    // Sends the data and duplicates of the descriptors as one message (SCM_RIGHTS), inLen has to be at least 1.
+    int32_t SendWithDescriptors(const void* inData, size_t inLen, const int* inDescriptors, size_t inCount);
+    // Like Receive; descriptors which came with the data are appended to outDescriptors and belong to the caller.
+    int32_t ReceiveWithDescriptors(void* outBuffer, size_t inLen, vector<int>& outDescriptors);
+
+    LocalSocketType GetType() const { return mType; }
+
+private:
+    friend class SocketUtil;
+
+    LocalSocket(SOCKET inSocket, LocalSocketType inType);
+
+    LocalSocketType mType;
+};
+
+typedef shared_ptr<LocalSocket> LocalSocketPtr;
@@ -0,0 +1,135 @@
+#pragma once
+#include <string_view>
+#include <type_traits>
+
+#include "SocketWrapperShared.h"
+
+// Binary message writer. Bytes go to one growable arena which Clear keeps,
+// so a stream reused for every message stops allocating once it fits the largest one.
+// Numbers written by Write are little endian, integers can also be written as varints (zigzag for signed ones).
+// Bits are packed from the lowest bit of a byte, the next byte write starts on a new byte.
+class MemoryOutputStream
+{
+public:
+    MemoryOutputStream(size_t inInitialCapacity = 256);
+
+    const char* GetBufferPtr() const { return mArena.data(); }
+    size_t GetLength() const { return mLength; }
+    SendBuffer GetSendBuffer() const { return {mArena.data(), mLength}; }
+    void Clear();
+
+    void WriteBytes(const void* inData, size_t inLength);
+    template <typename T> void Write(T inValue);
+    void WriteVarUInt(uint64_t inValue);
+    void WriteVarInt(int64_t inValue);
+    // Varint length and the bytes, without a terminating zero.
+    void WriteString(std::string_view inValue);
+    void WriteBits(uint64_t inValue, int inBitCount);
+
+private:
+    void Reserve(size_t inLength);
+
+    vector<char> mArena;
+    size_t mLength;
+    // bits used in the last byte, 0 when the stream is byte aligned
+    int mBitOffset;
+};
+
+// Bounds checked reader of received bytes, the counterpart of MemoryOutputStream.
+// Nothing is copied out for strings: ReadString returns a view into the stream buffer,
+// valid until the buffer is received into again.
+// A read past the end returns false and fails the stream, so a message may be parsed
+// without checking every read and then dropped when IsValid is false.
+class MemoryInputStream
+{
+public:
+    // View over bytes the caller keeps alive.
+    MemoryInputStream(const void* inData, size_t inLength);
+    // Owns inCapacity bytes for UDPSocket::ReceiveFrom and TCPSocket::Receive.
+    explicit MemoryInputStream(size_t inCapacity);
+    MemoryInputStream(const MemoryInputStream&) = delete;
+    MemoryInputStream& operator=(const MemoryInputStream&) = delete;
+
+    size_t GetLength() const { return mLength; }
+    size_t GetRemainingLength() const { return mLength - mPosition; }
+    size_t GetCapacity() const { return mOwnedBuffer.size(); }
+    bool IsValid() const { return mIsValid; }
+    // Starts reading again from the beginning, over the first inLength bytes of an owned buffer.
+    void Reset(size_t inLength);
+
+    bool ReadBytes(void* outData, size_t inLength);
+    template <typename T> bool Read(T& outValue);
+    bool ReadVarUInt(uint64_t& outValue);
+    bool ReadVarInt(int64_t& outValue);
+    bool ReadString(std::string_view& outValue);
+    bool ReadBits(uint64_t& outValue, int inBitCount);
+
+private:
+    friend class UDPSocket;
+    friend class TCPSocket;
+
+    char* GetReceiveBuffer() { return mOwnedBuffer.data(); }
+    const char* Advance(size_t inLength);
+    bool Fail();
+
+    vector<char> mOwnedBuffer;
+    const char* mData;
+    size_t mLength;
+    size_t mPosition;
+    // bits read from the byte before mPosition, 0 when the stream is byte aligned
+    int mBitOffset;
+    bool mIsValid;
+};
+
+template <typename T>
+void MemoryOutputStream::Write(T inValue)
+{
+    static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8, "Write takes numbers, see WriteBytes and WriteString");
+
+    uint64_t bits;
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t> raw;
+        memcpy(&raw, &inValue, sizeof(raw));
+        bits = raw;
+    }
+    else
+    {
+        bits = static_cast<uint64_t>(inValue);
+    }
+
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        bytes[i] = static_cast<char>(bits >> (8 * i));
+    }
+    WriteBytes(bytes, sizeof(T));
+}
+
+template <typename T>
+bool MemoryInputStream::Read(T& outValue)
+{
+    static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8, "Read takes numbers, see ReadBytes and ReadString");
+
+    const char* bytes = Advance(sizeof(T));
+    if (!bytes)
+    {
+        return false;
+    }
+    uint64_t bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        bits |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+    }
+
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t> raw = static_cast<decltype(raw)>(bits);
+        memcpy(&outValue, &raw, sizeof(raw));
+    }
+    else
+    {
+        outValue = static_cast<T>(bits);
+    }
+    return true;
+}
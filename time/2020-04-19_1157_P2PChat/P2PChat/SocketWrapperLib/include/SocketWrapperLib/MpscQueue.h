@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+
+#include "SocketWrapperShared.h"
+
+// Unbounded lock-free queue for many producer threads and one consumer thread, e.g. work handed to an
+// event loop by other loops. Push is one atomic exchange and never waits for the consumer or other producers,
+// so two loops pushing into each other cannot deadlock. Every Push allocates a node; producers which hand
+// over many values push them as one batch (e.g. a vector) to keep that off the per-value path.
+// T has to be default constructible and movable. The consumer is expected to sleep in a poller and to be
+// woken by the producers, see PollerWakeup.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue(): mHead(new Node), mTail(mHead.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue()
+    {
+        while (mTail)
+        {
+            Node* next = mTail->next.load(std::memory_order_relaxed);
+            delete mTail;
+            mTail = next;
+        }
+    }
+
+    // Any thread.
+    void Push(T inValue)
+    {
+        Node* node = new Node;
+        node->value = std::move(inValue);
+        //the producers are ordered by the exchange, the link makes the node visible to the consumer
+        Node* previous = mHead.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Only the consumer thread. Returns false when the queue is empty, or when a producer is between
+    // the exchange and the link; its value is popped once the producer has woken the consumer.
+    bool TryPop(T& outValue)
+    {
+        Node* next = mTail->next.load(std::memory_order_acquire);
+        if (!next)
+        {
+            return false;
+        }
+        //the popped node stays as the new stub, its value has been moved out
+        outValue = std::move(next->value);
+        delete mTail;
+        mTail = next;
+        return true;
+    }
+
+private:
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    //producers and the consumer write to different cache lines
+    alignas(64) std::atomic<Node*> mHead;
+    alignas(64) Node* mTail;
+};
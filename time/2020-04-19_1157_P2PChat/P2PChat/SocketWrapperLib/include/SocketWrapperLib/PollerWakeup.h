@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+
+#include "SocketWrapperShared.h"
+
+// Wakes a thread which waits in SocketPoller::Wait or SocketUtil::Select from other threads.
+// The waiting thread registers GetSocket for POLL_READ and calls Clear when it becomes readable,
+// before it looks for the work that was handed to it. Notifications are coalesced: until Clear only
+// the first Notify writes a byte, so a busy producer costs one atomic exchange per notification.
+// A socketpair on Linux, a connected loopback TCP pair on Windows.
+class PollerWakeup
+{
+public:
+    PollerWakeup();
+
+    // Returns NO_ERROR or negative error.
+    int Open();
+    // Any thread.
+    void Notify();
+    // Only the waiting thread; reads the pending bytes until WSAEWOULDBLOCK, as the edge triggered poller expects.
+    void Clear();
+
+    const TCPSocketPtr& GetSocket() const { return mReadSocket; }
+
+private:
+    PollerWakeup(const PollerWakeup&) = delete;
+    PollerWakeup& operator=(const PollerWakeup&) = delete;
+
+    TCPSocketPtr mReadSocket;
+    TCPSocketPtr mWriteSocket;
+    std::atomic<bool> mIsPending;
+};
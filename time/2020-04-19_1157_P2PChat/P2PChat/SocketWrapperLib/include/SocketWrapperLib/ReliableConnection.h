@@ -0,0 +1,118 @@
+#pragma once
+#include <chrono>
+#include <map>
+#include <set>
+
+#include "SocketWrapperShared.h"
+
+enum ReliableChannel
+{
+    CHANNEL_RELIABLE_ORDERED,
+    CHANNEL_RELIABLE_UNORDERED,
+    CHANNEL_UNRELIABLE
+};
+
+// Message connection to one peer over datagrams, without the head-of-line blocking of TCP
+// for the unordered and unreliable channels.
+// Reliable messages get a sequence number and stay in flight until the peer acknowledges them.
+// Acks carry the cumulative sequence and selective ranges above it, a packet is retransmitted
+// when three later packets are acknowledged or when the retransmission timeout (RFC 6298) expires.
+// The number of packets in flight is limited by a NewReno like congestion window.
+// Nothing happens in the background: Update should be called every few milliseconds.
+class ReliableConnection
+{
+public:
+    static constexpr size_t MAX_MESSAGE_SIZE = 1200;
+
+    ReliableConnection(DatagramTransportPtr inTransport, const SocketAddress& inRemoteAddress);
+
+    // Returns NO_ERROR, -WSAEMSGSIZE for too big messages or -WSAECONNRESET when the peer is lost.
+    int Send(const void* inData, size_t inLen, ReliableChannel inChannel = CHANNEL_RELIABLE_ORDERED);
+    // Returns the size of the next delivered message or -WSAEWOULDBLOCK when there is nothing to deliver.
+    int Receive(void* outBuffer, size_t inMaxLength, ReliableChannel* outChannel = nullptr);
+    // Reads the transport, retransmits lost packets, sends new packets and acks.
+    int Update();
+
+    bool IsConnectionLost() const { return mIsConnectionLost; }
+    bool HasUnacknowledgedData() const { return !mSendQueue.empty() || !mInFlight.empty(); }
+    double GetRoundTripTimeMs() const { return mSmoothedRttMs; }
+    double GetCongestionWindow() const { return mCongestionWindow; }
+    uint64_t GetRetransmitCount() const { return mRetransmitCount; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // serial number arithmetic, keys of one container are always within half of the range
+    struct SequenceLess
+    {
+        bool operator()(uint32_t inLeft, uint32_t inRight) const
+        {
+            return static_cast<int32_t>(inLeft - inRight) < 0;
+        }
+    };
+
+    struct OutgoingMessage
+    {
+        ReliableChannel channel;
+        uint32_t orderIndex;
+        vector<char> data;
+    };
+
+    struct SentPacket
+    {
+        vector<char> packet;
+        Clock::time_point sentTime;
+        int transmitCount;
+        bool isFastRetransmitted;
+    };
+
+    struct DeliveredMessage
+    {
+        ReliableChannel channel;
+        vector<char> data;
+    };
+
+    void ReceivePackets(Clock::time_point inNow);
+    void ProcessData(const char* inPacket, size_t inSize);
+    void ProcessAck(const char* inPacket, size_t inSize, Clock::time_point inNow);
+    void AcknowledgePacket(std::map<uint32_t, SentPacket, SequenceLess>::iterator inPacket);
+    void DetectLosses(Clock::time_point inNow);
+    void Retransmit(SentPacket& ioPacket, Clock::time_point inNow);
+    void EnterRecovery();
+    void SendPending(Clock::time_point inNow);
+    void SendAck();
+    void Transmit(const vector<char>& inPacket);
+    Clock::duration GetRetransmitTimeout() const;
+
+    DatagramTransportPtr mTransport;
+    SocketAddress mRemoteAddress;
+    bool mIsConnectionLost;
+
+    // sender
+    deque<OutgoingMessage> mSendQueue;
+    std::map<uint32_t, SentPacket, SequenceLess> mInFlight;
+    uint32_t mNextSequence;
+    uint32_t mNextOrderIndex;
+    uint32_t mLargestAcked;
+    bool mHasAck;
+    double mSmoothedRttMs;
+    double mRttVarianceMs;
+    int mBackoff;
+    Clock::time_point mTimerStart;
+    double mCongestionWindow;
+    double mSlowStartThreshold;
+    bool mIsInRecovery;
+    uint32_t mRecoverySequence;
+    uint64_t mRetransmitCount;
+
+    // receiver
+    uint32_t mReceiveCumulative;
+    uint32_t mLatestReceived;
+    std::set<uint32_t, SequenceLess> mReceivedAbove;
+    uint32_t mNextDeliverOrder;
+    std::map<uint32_t, vector<char>, SequenceLess> mOrderedBuffer;
+    deque<DeliveredMessage> mDelivered;
+    bool mIsAckPending;
+};
+
+typedef shared_ptr<ReliableConnection> ReliableConnectionPtr;
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "SocketWrapperShared.h"
+
+struct ShardedListenerOptions
+{
+    // 0 opens one listen socket per hardware thread
+    size_t shardCount = 0;
+    int backLog = 1024;
+    // TCP_DEFER_ACCEPT, 0 hands out connections before their first data
+    int deferAcceptSeconds = 0;
+};
+
+// Listens on one address with a SO_REUSEPORT socket per shard. The kernel spreads new connections
+// over the sockets by a hash of the addresses, so every shard has its own accept queue and accept loop
+// and no lock or thundering herd is shared between them. Where SO_REUSEPORT is missing one shard is opened.
+// Either Start runs an accept loop per shard, or a server polls GetListenSocket(shard) in its own threads.
+class ShardedListener
+{
+public:
+    // Called on the thread of the shard which accepted the connection, the socket is in blocking mode.
+    typedef std::function<void(size_t inShard, TCPSocketPtr inSocket, const SocketAddress& inAddress)> AcceptCallback;
+
+    ShardedListener(const ShardedListenerOptions& inOptions = ShardedListenerOptions());
+    ~ShardedListener();
+
+    // Opens the non-blocking listen sockets on a fixed port.
+    // Returns NO_ERROR or the error of the first socket which failed, then no socket stays open.
+    int Open(const SocketAddress& inAddress);
+    void Start(AcceptCallback inCallback);
+    // Waits for the accept loops to return.
+    void Stop();
+
+    size_t GetShardCount() const { return mListenSockets.size(); }
+    const TCPSocketPtr& GetListenSocket(size_t inShard) const { return mListenSockets[inShard]; }
+    // connections accepted by the loop of the shard since Start
+    uint64_t GetAcceptCount(size_t inShard) const { return mAcceptCounts[inShard]; }
+
+private:
+    ShardedListener(const ShardedListener&) = delete;
+    ShardedListener& operator=(const ShardedListener&) = delete;
+
+    TCPSocketPtr OpenShard(const SocketAddress& inAddress, bool inShouldReusePort, int* outError);
+    void RunAcceptLoop(size_t inShard);
+
+    ShardedListenerOptions mOptions;
+    vector<TCPSocketPtr> mListenSockets;
+    unique_ptr<std::atomic<uint64_t>[]> mAcceptCounts;
+    AcceptCallback mCallback;
+    std::atomic<bool> mIsStopping;
+    vector<std::thread> mThreads;
+};
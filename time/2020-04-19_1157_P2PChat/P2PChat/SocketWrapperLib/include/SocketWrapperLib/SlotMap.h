@@ -0,0 +1,123 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+// generation << 32 | slot index, 0 is never a valid handle
+typedef uint64_t SlotHandle;
+
+// Table of values addressed by generation-tagged handles, e.g. the connections of a server.
+// Add, Remove and Find are O(1) and the values lie densely in one vector, so iterating all of them
+// (a broadcast) touches no pointers. Remove moves the last value into the hole, so references and
+// iterators are invalidated by Add and Remove, handles are not: the handle of a removed value never
+// finds the value which reuses its slot, lists of handles may keep stale entries and skip them.
+// GetKey gives an address which stays the same for a slot, for the user data of a SocketPoller.
+// Not thread safe.
+template <typename T>
+class SlotMap
+{
+public:
+    SlotMap(): mFreeSlot(NIL) {}
+
+    SlotHandle Add(T inValue)
+    {
+        uint32_t index;
+        if (mFreeSlot != NIL)
+        {
+            index = mFreeSlot;
+            mFreeSlot = mSlots[index].nextFree;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(mSlots.size());
+            mSlots.push_back({index, 1, NIL, NIL});
+        }
+        Slot& slot = mSlots[index];
+        slot.valueIndex = static_cast<uint32_t>(mValues.size());
+        mValues.push_back(std::move(inValue));
+        mValueSlots.push_back(index);
+        return MakeHandle(slot);
+    }
+
+    // False when the handle was removed already.
+    bool Remove(SlotHandle inHandle)
+    {
+        Slot* slot = FindSlot(inHandle);
+        if (!slot)
+        {
+            return false;
+        }
+        uint32_t last = static_cast<uint32_t>(mValues.size() - 1);
+        if (slot->valueIndex != last)
+        {
+            mValues[slot->valueIndex] = std::move(mValues[last]);
+            mValueSlots[slot->valueIndex] = mValueSlots[last];
+            mSlots[mValueSlots[last]].valueIndex = slot->valueIndex;
+        }
+        mValues.pop_back();
+        mValueSlots.pop_back();
+
+        //a new generation for the next value in the slot, 0 stays reserved for the invalid handle
+        slot->generation = slot->generation == UINT32_MAX ? 1 : slot->generation + 1;
+        slot->valueIndex = NIL;
+        slot->nextFree = mFreeSlot;
+        mFreeSlot = slot->index;
+        return true;
+    }
+
+    T* Find(SlotHandle inHandle)
+    {
+        Slot* slot = FindSlot(inHandle);
+        return slot ? &mValues[slot->valueIndex] : nullptr;
+    }
+
+    const T* Find(SlotHandle inHandle) const { return const_cast<SlotMap*>(this)->Find(inHandle); }
+
+    // The address of the slot of a valid handle, it is reused by later values of the slot.
+    void* GetKey(SlotHandle inHandle) { return FindSlot(inHandle); }
+    // The handle of the value which is in the slot of inKey now, 0 when the slot is free.
+    SlotHandle GetHandle(const void* inKey) const
+    {
+        const Slot* slot = static_cast<const Slot*>(inKey);
+        return slot->valueIndex == NIL ? 0 : MakeHandle(*slot);
+    }
+
+    size_t GetCount() const { return mValues.size(); }
+    typename vector<T>::iterator begin() { return mValues.begin(); }
+    typename vector<T>::iterator end() { return mValues.end(); }
+    typename vector<T>::const_iterator begin() const { return mValues.begin(); }
+    typename vector<T>::const_iterator end() const { return mValues.end(); }
+
+private:
+    static constexpr uint32_t NIL = 0xffffffff;
+
+    struct Slot
+    {
+        uint32_t index;
+        uint32_t generation;
+        // in mValues, NIL while the slot is free
+        uint32_t valueIndex;
+        uint32_t nextFree;
+    };
+
+    static SlotHandle MakeHandle(const Slot& inSlot)
+    {
+        return static_cast<SlotHandle>(inSlot.generation) << 32 | inSlot.index;
+    }
+
+    Slot* FindSlot(SlotHandle inHandle)
+    {
+        uint32_t index = static_cast<uint32_t>(inHandle);
+        if (index >= mSlots.size())
+        {
+            return nullptr;
+        }
+        Slot& slot = mSlots[index];
+        return slot.valueIndex != NIL && slot.generation == static_cast<uint32_t>(inHandle >> 32) ? &slot : nullptr;
+    }
+
+    //a deque, so the slots keep their addresses when it grows
+    deque<Slot> mSlots;
+    vector<T> mValues;
+    // the slot of every value
+    vector<uint32_t> mValueSlots;
+    uint32_t mFreeSlot;
+};
@@ -1,33 +1,46 @@
 #pragma once
 #include "SocketWrapperShared.h"
 
+// IPv4 or IPv6 address with a port, stored in sockaddr_storage so any address
+// returned by accept, recvfrom or getaddrinfo fits.
 class SocketAddress
 {
 public:
     //SocketAddress(string ipv4str, uint16_t port);
     SocketAddress(uint32_t inAddress, uint16_t inPort);
+    SocketAddress(const in6_addr& inAddress, uint16_t inPort, uint32_t inScopeId = 0);
+    // Copies as many bytes as the family of inSockAddr has.
     SocketAddress(const sockaddr& inSockAddr);
     SocketAddress();
     bool operator==(const SocketAddress& inOther) const;
+    bool operator!=(const SocketAddress& inOther) const { return !(*this == inOther); }
     size_t GetHash() const;
     uint32_t GetSize() const;
+    int GetFamily() const { return mSockAddr.ss_family; }
+    uint16_t GetPort() const;
+    // "1.2.3.4:56" or "[::1]:56".
     string ToString() const;
+    // For system calls the wrapper does not cover, GetSize bytes long.
+    sockaddr* GetSockAddr() { return reinterpret_cast<sockaddr*>(&mSockAddr); }
+    const sockaddr* GetSockAddr() const { return reinterpret_cast<const sockaddr*>(&mSockAddr); }
 
 private:
     friend class UDPSocket;
     friend class TCPSocket;
-    sockaddr mSockAddr;
+    sockaddr_storage mSockAddr;
 
 #if _WIN32
     uint32_t& GetIP4Ref();
     const uint32_t& GetIP4Ref() const;
 #else
- uint32_t&    GetIP4Ref()     { return GetAsSockAddrIn()->sin_addr.s_addr; }
- const uint32_t&   GetIP4Ref()   const { return GetAsSockAddrIn()->sin_addr.s_addr; }
+    uint32_t& GetIP4Ref() { return GetAsSockAddrIn()->sin_addr.s_addr; }
+    const uint32_t& GetIP4Ref() const { return GetAsSockAddrIn()->sin_addr.s_addr; }
 #endif
 
     sockaddr_in* GetAsSockAddrIn();
     const sockaddr_in* GetAsSockAddrIn() const;
+    sockaddr_in6* GetAsSockAddrIn6();
+    const sockaddr_in6* GetAsSockAddrIn6() const;
 };
 
 typedef shared_ptr<SocketAddress> SocketAddressPtr;
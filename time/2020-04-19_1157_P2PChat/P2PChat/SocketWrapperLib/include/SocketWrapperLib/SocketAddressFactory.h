@@ -6,4 +6,8 @@ class SocketAddressFactory
 public:
 
     static SocketAddressPtr CreateIPv4FromString(const string& inString);
+    // Every address of "host:port" or "[ipv6]:port" in getaddrinfo order (RFC 6724 preference first).
+    // Blocks on the system resolver, see AddressResolver. Returns NO_ERROR or the getaddrinfo error.
+    static int CreateAllFromString(const string& inString, vector<SocketAddress>& outAddresses,
+                                   int inFamily = AF_UNSPEC);
 };
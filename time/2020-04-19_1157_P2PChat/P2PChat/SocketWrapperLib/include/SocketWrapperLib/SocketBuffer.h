@@ -0,0 +1,18 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+// Pieces of one message for scatter-gather I/O, so a header and a payload can be sent without joining them.
+struct SendBuffer
+{
+    const void* data;
+    size_t length;
+};
+
+struct ReceiveBuffer
+{
+    void* data;
+    size_t length;
+};
+
+// Buffers beyond this count are left for the next call, like bytes of a short send.
+const size_t MAX_SOCKET_BUFFERS = 64;
@@ -0,0 +1,330 @@
+#pragma once
+// Needs C++20, so SocketWrapperShared.h does not include it.
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <list>
+#include <optional>
+#include <utility>
+
+#include "SocketWrapperShared.h"
+
+template <typename T>
+class SocketTask;
+
+class SocketTaskPromiseBase
+{
+public:
+    // resumes the coroutine which awaited the task, if there is one
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> inHandle) noexcept
+        {
+            std::coroutine_handle<> continuation = inHandle.promise().mContinuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { mException = std::current_exception(); }
+
+    std::coroutine_handle<> mContinuation;
+    std::exception_ptr mException;
+};
+
+template <typename T>
+class SocketTaskPromise : public SocketTaskPromiseBase
+{
+public:
+    SocketTask<T> get_return_object();
+    void return_value(T inValue) { mValue = std::move(inValue); }
+
+    T TakeResult()
+    {
+        if (mException)
+        {
+            std::rethrow_exception(mException);
+        }
+        return std::move(*mValue);
+    }
+
+private:
+    std::optional<T> mValue;
+};
+
+template <>
+class SocketTaskPromise<void> : public SocketTaskPromiseBase
+{
+public:
+    SocketTask<void> get_return_object();
+    void return_void() {}
+
+    void TakeResult()
+    {
+        if (mException)
+        {
+            std::rethrow_exception(mException);
+        }
+    }
+};
+
+// Coroutine which returns T. It starts when it is awaited or given to SocketScheduler::Spawn,
+// the awaiting coroutine continues when it returns, and an exception is rethrown there.
+// The coroutine frame belongs to the task and is destroyed with it.
+template <typename T = void>
+class SocketTask
+{
+public:
+    typedef SocketTaskPromise<T> promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    struct Awaiter
+    {
+        bool await_ready() const noexcept { return !mHandle || mHandle.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> inAwaiting) noexcept
+        {
+            mHandle.promise().mContinuation = inAwaiting;
+            return mHandle;
+        }
+        T await_resume() { return mHandle.promise().TakeResult(); }
+
+        Handle mHandle;
+    };
+
+    explicit SocketTask(Handle inHandle): mHandle(inHandle) {}
+    SocketTask(SocketTask&& inOther) noexcept: mHandle(std::exchange(inOther.mHandle, nullptr)) {}
+    SocketTask& operator=(SocketTask&& inOther) noexcept
+    {
+        if (this != &inOther)
+        {
+            if (mHandle)
+            {
+                mHandle.destroy();
+            }
+            mHandle = std::exchange(inOther.mHandle, nullptr);
+        }
+        return *this;
+    }
+    ~SocketTask()
+    {
+        if (mHandle)
+        {
+            mHandle.destroy();
+        }
+    }
+
+    bool IsDone() const { return !mHandle || mHandle.done(); }
+    Awaiter operator co_await() const noexcept { return Awaiter{mHandle}; }
+
+private:
+    SocketTask(const SocketTask&) = delete;
+    SocketTask& operator=(const SocketTask&) = delete;
+
+    Handle mHandle;
+};
+
+template <typename T>
+SocketTask<T> SocketTaskPromise<T>::get_return_object()
+{
+    return SocketTask<T>(SocketTask<T>::Handle::from_promise(*this));
+}
+
+inline SocketTask<void> SocketTaskPromise<void>::get_return_object()
+{
+    return SocketTask<void>(SocketTask<void>::Handle::from_promise(*this));
+}
+
+// An operation of an AsyncSocket which waits in the scheduler until the socket is ready.
+class SocketOperation
+{
+public:
+    // Tries the operation again, false while the socket is not ready.
+    virtual bool TryComplete() = 0;
+
+    std::coroutine_handle<> mContinuation;
+
+protected:
+    ~SocketOperation() {}
+};
+
+// the coroutines waiting for a socket, at a stable address for the poller
+struct SocketWaiters
+{
+    TCPSocketPtr socket;
+    SocketOperation* reader = nullptr;
+    SocketOperation* writer = nullptr;
+};
+
+// Runs coroutines on one thread: a coroutine waiting for a socket or a timer is suspended
+// and resumed by Run when the SocketPoller reports the socket ready or the time has come.
+// Sessions are written as straight-line code and thousands of them share the thread.
+// The scheduler has to outlive its AsyncSockets; unfinished tasks are destroyed with it.
+class SocketScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct SleepOperation
+    {
+        bool await_ready() const noexcept { return mMilliseconds <= 0; }
+        void await_suspend(std::coroutine_handle<> inAwaiting);
+        void await_resume() const noexcept {}
+
+        SocketScheduler& mScheduler;
+        int mMilliseconds;
+    };
+
+    SocketScheduler();
+    ~SocketScheduler();
+
+    // The scheduler keeps the task until it returns, an exception is logged.
+    void Spawn(SocketTask<void> inTask);
+    // Resumes coroutines until all spawned tasks returned or Stop was called.
+    // Returns NO_ERROR or the error of the poller.
+    int Run();
+    void Stop() { mIsStopping = true; }
+
+    SleepOperation Sleep(int inMilliseconds) { return SleepOperation{*this, inMilliseconds}; }
+    size_t GetTaskCount() const { return mSpawned.size(); }
+    // how often Run waited in the poller
+    long GetPollCount() const { return mPollCount; }
+    // Deadlines and heartbeats of the sessions, the callbacks run in Run on the thread of the scheduler.
+    TimerWheel& GetTimers() { return mTimers; }
+
+private:
+    friend class AsyncSocket;
+    struct SpawnedTask;
+
+    SocketScheduler(const SocketScheduler&) = delete;
+    SocketScheduler& operator=(const SocketScheduler&) = delete;
+
+    static SpawnedTask RunSpawned(SocketTask<void> inTask);
+
+    int Register(SocketWaiters& inWaiters);
+    void Unregister(SocketWaiters& inWaiters);
+    void UpdateInterest(SocketWaiters& inWaiters);
+    int GetPollTimeout(Clock::time_point inNow) const;
+    void ResumeReady();
+
+    SocketPoller mPoller;
+    std::list<std::coroutine_handle<>> mSpawned;
+    deque<std::coroutine_handle<>> mReady;
+    TimerWheel mTimers;
+    long mPollCount;
+    bool mIsStopping;
+};
+
+// Non-blocking TCPSocket whose operations are awaited in a coroutine run by a SocketScheduler:
+//     int received = co_await socket.Receive(buffer, sizeof(buffer));
+// An operation which can finish at once does not suspend.
+// Only one Receive or Accept and one Send or Connect may wait at the same time.
+class AsyncSocket
+{
+public:
+    class ReceiveOperation : public SocketOperation
+    {
+    public:
+        ReceiveOperation(AsyncSocket& inSocket, void* outBuffer, size_t inLength):
+            mSocket(inSocket), mBuffer(outBuffer), mLength(inLength), mResult(0) {}
+
+        bool TryComplete() override;
+        bool await_ready() { return TryComplete(); }
+        void await_suspend(std::coroutine_handle<> inAwaiting) { mSocket.Wait(*this, inAwaiting, false); }
+        // bytes received, 0 when the peer closed or negative error
+        int32_t await_resume() const { return mResult; }
+
+    private:
+        AsyncSocket& mSocket;
+        void* mBuffer;
+        size_t mLength;
+        int32_t mResult;
+    };
+
+    class SendOperation : public SocketOperation
+    {
+    public:
+        SendOperation(AsyncSocket& inSocket, const void* inData, size_t inLength):
+            mSocket(inSocket), mData(static_cast<const char*>(inData)), mLength(inLength), mSent(0), mResult(0) {}
+
+        bool TryComplete() override;
+        bool await_ready() { return TryComplete(); }
+        void await_suspend(std::coroutine_handle<> inAwaiting) { mSocket.Wait(*this, inAwaiting, true); }
+        // all bytes or negative error
+        int32_t await_resume() const { return mResult; }
+
+    private:
+        AsyncSocket& mSocket;
+        const char* mData;
+        size_t mLength;
+        size_t mSent;
+        int32_t mResult;
+    };
+
+    class AcceptOperation : public SocketOperation
+    {
+    public:
+        explicit AcceptOperation(AsyncSocket& inSocket): mSocket(inSocket), mError(NO_ERROR) {}
+
+        bool TryComplete() override;
+        bool await_ready() { return TryComplete(); }
+        void await_suspend(std::coroutine_handle<> inAwaiting) { mSocket.Wait(*this, inAwaiting, false); }
+        // an empty AsyncSocket on failure, GetAddress and GetError tell more
+        AsyncSocket await_resume();
+
+        const SocketAddress& GetAddress() const { return mAddress; }
+        int GetError() const { return mError; }
+
+    private:
+        AsyncSocket& mSocket;
+        TCPSocketPtr mAccepted;
+        SocketAddress mAddress;
+        int mError;
+    };
+
+    class ConnectOperation : public SocketOperation
+    {
+    public:
+        ConnectOperation(AsyncSocket& inSocket, const SocketAddress& inAddress):
+            mSocket(inSocket), mAddress(inAddress), mResult(NO_ERROR) {}
+
+        bool TryComplete() override;
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> inAwaiting) { mSocket.Wait(*this, inAwaiting, true); }
+        // NO_ERROR or negative error
+        int await_resume() const { return mResult; }
+
+    private:
+        AsyncSocket& mSocket;
+        SocketAddress mAddress;
+        int mResult;
+    };
+
+    AsyncSocket(): mScheduler(nullptr) {}
+    // Switches the socket to non-blocking mode and registers it with the scheduler.
+    AsyncSocket(SocketScheduler& inScheduler, TCPSocketPtr inSocket);
+    AsyncSocket(AsyncSocket&& inOther) noexcept = default;
+    AsyncSocket& operator=(AsyncSocket&& inOther) noexcept;
+    ~AsyncSocket();
+
+    explicit operator bool() const { return mWaiters && mWaiters->socket; }
+    const TCPSocketPtr& GetSocket() const { return mWaiters->socket; }
+
+    ReceiveOperation Receive(void* outBuffer, size_t inLength) { return ReceiveOperation(*this, outBuffer, inLength); }
+    SendOperation Send(const void* inData, size_t inLength) { return SendOperation(*this, inData, inLength); }
+    AcceptOperation Accept() { return AcceptOperation(*this); }
+    ConnectOperation Connect(const SocketAddress& inAddress) { return ConnectOperation(*this, inAddress); }
+
+private:
+    AsyncSocket(const AsyncSocket&) = delete;
+    AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+    void Wait(SocketOperation& inOperation, std::coroutine_handle<> inAwaiting, bool inIsWrite);
+    void Close();
+
+    SocketScheduler* mScheduler;
+    unique_ptr<SocketWaiters> mWaiters;
+};
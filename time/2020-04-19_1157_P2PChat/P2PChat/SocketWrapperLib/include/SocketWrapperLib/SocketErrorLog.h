@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "SocketWrapperShared.h"
+
+struct SocketError
+{
+    // the description given to SocketUtil::ReportError, a string literal
+    const char* operation;
+    int error;
+    std::chrono::system_clock::time_point time;
+};
+
+typedef std::function<void(const SocketError&)> SocketErrorCallBack;
+
+// The latest errors reported by SocketUtil::ReportError in a fixed ring.
+// Add neither locks nor allocates, so threads reporting at the same time do not wait for each other.
+class SocketErrorLog
+{
+public:
+    static constexpr size_t CAPACITY = 256;
+
+    SocketErrorLog();
+
+    void Add(const char* inOperation, int inError);
+    // The errors still in the ring, oldest first. An entry overwritten while it is copied is left out.
+    void GetRecent(vector<SocketError>& outErrors) const;
+    // all errors added so far, also those which dropped out of the ring
+    uint64_t GetTotalCount() const { return mNextIndex.load(std::memory_order_relaxed); }
+
+private:
+    SocketErrorLog(const SocketErrorLog&) = delete;
+    SocketErrorLog& operator=(const SocketErrorLog&) = delete;
+
+    struct Slot
+    {
+        // index + 1 of the entry, 0 while it is written
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char*> operation;
+        std::atomic<int> error;
+        std::atomic<int64_t> time;
+    };
+
+    Slot mSlots[CAPACITY];
+    std::atomic<uint64_t> mNextIndex;
+};
+
+// Sends the errors reported on the current thread to inCallBack while it exists, instead of
+// the process-wide callback of SocketUtil::SetErrorCallBack. Scopes nest; the callback is not copied
+// and has to outlive the scope. A server or connection keeps its callback and opens a scope in every
+// method which uses sockets, so its errors reach its own logger on whatever thread it runs.
+class SocketErrorScope
+{
+public:
+    explicit SocketErrorScope(const SocketErrorCallBack& inCallBack);
+    ~SocketErrorScope();
+
+    // The callback of the innermost scope of this thread, or nullptr.
+    static const SocketErrorCallBack* GetCurrentCallBack();
+
+private:
+    SocketErrorScope(const SocketErrorScope&) = delete;
+    SocketErrorScope& operator=(const SocketErrorScope&) = delete;
+
+    const SocketErrorCallBack* mPrevious;
+};
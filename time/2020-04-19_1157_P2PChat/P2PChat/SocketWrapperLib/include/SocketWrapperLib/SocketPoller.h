@@ -0,0 +1,62 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+enum SocketPollInterest
+{
+    POLL_READ = 1,
+    POLL_WRITE = 2
+};
+
+struct SocketPollEvent
+{
+    void* userData;
+    bool isReadable;
+    bool isWritable;
+    bool isClosed; // hang up or error, the socket should be read to get the reason
+};
+
+// Readiness notification for many sockets.
+// Sockets are registered once and Wait returns only the ready ones with their user data.
+// On Linux it is edge triggered epoll: after an event the socket should be read (or written)
+// until WSAEWOULDBLOCK, otherwise the event is not reported again.
+// On other platforms select is used as a fallback; it is level triggered and limited by FD_SETSIZE.
+class SocketPoller
+{
+public:
+    SocketPoller();
+    ~SocketPoller();
+
+    // -WSAEMFILE when the select fallback has no room for the socket: FD_SETSIZE sockets on Windows,
+    // a descriptor of FD_SETSIZE or more elsewhere.
+    int Add(const TCPSocketPtr& inSocket, int inInterest, void* inUserData);
+    int Modify(const TCPSocketPtr& inSocket, int inInterest, void* inUserData);
+    int Remove(const TCPSocketPtr& inSocket);
+
+    // inTimeoutMs < 0 waits infinitely. Returns the number of events or negative error.
+    int Wait(vector<SocketPollEvent>& outEvents, int inTimeoutMs = -1);
+
+private:
+    SocketPoller(const SocketPoller&) = delete;
+    SocketPoller& operator=(const SocketPoller&) = delete;
+
+#ifdef __linux__
+    int Control(int inOperation, SOCKET inSocket, int inInterest, void* inUserData);
+
+    int mEpoll;
+    vector<epoll_event> mReadyEvents;
+#else
+    struct Registration
+    {
+        int interest;
+        void* userData;
+    };
+
+    unordered_map<SOCKET, Registration> mRegistrations;
+#endif
+};
+
+typedef shared_ptr<SocketPoller> SocketPollerPtr;
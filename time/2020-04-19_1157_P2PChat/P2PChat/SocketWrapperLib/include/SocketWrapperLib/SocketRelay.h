@@ -0,0 +1,57 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+// Forwards bytes to a TCPSocket without looking at them, for proxies and file serving.
+// On Linux socket to socket goes through a pipe with splice and a file goes out with sendfile,
+// the payload never enters user space. Elsewhere, or when the kernel refuses (e.g. for a socket type
+// splice does not handle), the bytes are copied through a 64 KB BufferPool buffer which is taken
+// only while it holds data, so idle relays cost no memory.
+// One relay per direction: bytes the target did not take yet stay in the relay for the next call.
+// Like Send, writing to a peer which closed raises SIGPIPE on Linux unless the process ignores it.
+class SocketRelay
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    // inIsCopyForced skips splice and sendfile, e.g. to compare both paths.
+    explicit SocketRelay(bool inIsCopyForced = false);
+    ~SocketRelay();
+
+    // Moves the bytes available on inFrom, up to inMaxLength at a time, to inTo until inFrom has nothing more
+    // or inTo would block. Returns the bytes written to inTo, 0 when inFrom was closed and nothing is left
+    // in the relay, or negative error; -WSAEWOULDBLOCK when nothing moved on non-blocking sockets.
+    int32_t Forward(const TCPSocketPtr& inFrom, const TCPSocketPtr& inTo, size_t inMaxLength = CHUNK_SIZE);
+    // Sends inLength bytes of the open file inFile from ioOffset on, ioOffset advances by what was sent.
+    // Returns the bytes sent or negative error, the file position of inFile is not used.
+    int64_t SendFile(int inFile, int64_t& ioOffset, size_t inLength, const TCPSocketPtr& inTo);
+
+    // Bytes read from the source but not yet taken by the target.
+    size_t GetPendingLength() const { return mPendingLength; }
+    bool IsZeroCopy() const { return !mIsCopying; }
+    // Totals of both paths, to check that a proxy really stays out of user space.
+    uint64_t GetZeroCopyBytes() const { return mZeroCopyBytes; }
+    uint64_t GetCopiedBytes() const { return mCopiedBytes; }
+
+private:
+    SocketRelay(const SocketRelay&) = delete;
+    SocketRelay& operator=(const SocketRelay&) = delete;
+
+    bool OpenPipe();
+    int FillPipe(const TCPSocketPtr& inFrom, size_t inMaxLength);
+    int DrainPipe(const TCPSocketPtr& inTo);
+    int FillBuffer(const TCPSocketPtr& inFrom, size_t inMaxLength);
+    int DrainBuffer(const TCPSocketPtr& inTo);
+    int64_t CopyFile(int inFile, int64_t& ioOffset, size_t inLength, const TCPSocketPtr& inTo);
+    void ReleaseBuffer();
+
+    bool mIsCopying;
+    bool mIsFileCopying;
+    int mPipe[2];
+    PooledBufferPtr mBuffer;
+    size_t mBufferOffset;
+    size_t mPendingLength;
+    uint64_t mZeroCopyBytes;
+    uint64_t mCopiedBytes;
+};
+
+typedef shared_ptr<SocketRelay> SocketRelayPtr;
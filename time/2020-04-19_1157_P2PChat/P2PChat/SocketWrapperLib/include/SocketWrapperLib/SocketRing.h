@@ -0,0 +1,108 @@
+#pragma once
+#include "SocketWrapperShared.h"
+
+enum SocketCompletionType
+{
+    COMPLETION_ACCEPT,
+    COMPLETION_RECEIVE,
+    COMPLETION_SEND
+};
+
+struct SocketCompletion
+{
+    SocketCompletionType type;
+    void* userData;
+    // bytes transferred or negative error; 0 for receive means the peer closed the connection
+    int result;
+    // accept: the new connection
+    TCPSocketPtr acceptedSocket;
+    // receive: the received bytes, valid until the next Wait
+    const char* data;
+    // the operation is finished and will not complete again; multishot accept/receive should be rearmed
+    bool isFinal;
+};
+
+// Completion based socket I/O on top of Linux io_uring.
+// Accept and Receive are multishot: one request keeps producing completions until it fails,
+// the socket is closed or Cancel is called. Receive picks buffers from a ring registered in the kernel,
+// so no memory is pinned per connection. Requests are only queued until Submit or Wait,
+// so many sends are passed to the kernel with one system call.
+// Requires kernel 6.0+. Create returns nullptr when it is not available (and always on Windows),
+// then SocketUtil::Select or SocketPoller should be used instead.
+class SocketRing
+{
+public:
+    static bool IsSupported();
+    static shared_ptr<SocketRing> Create(uint32_t inQueueDepth = 4096, uint32_t inBufferCount = 4096,
+                                         uint32_t inBufferSize = 2048);
+    ~SocketRing();
+
+    int Accept(const TCPSocketPtr& inListenSocket, void* inUserData);
+    int Receive(const TCPSocketPtr& inSocket, void* inUserData);
+    // inData must stay alive until the send completion. Stream sockets may complete with a short count.
+    int Send(const TCPSocketPtr& inSocket, const void* inData, size_t inLen, void* inUserData);
+    // Cancels every pending operation on the socket, each of them completes with -ECANCELED.
+    int Cancel(const TCPSocketPtr& inSocket);
+
+    int Submit();
+    // inTimeoutMs < 0 waits infinitely. Returns the number of completions or negative error.
+    int Wait(vector<SocketCompletion>& outCompletions, int inTimeoutMs = -1);
+
+private:
+    struct Operation
+    {
+        SocketCompletionType type;
+        void* userData;
+        TCPSocketPtr socket;
+    };
+
+    SocketRing();
+    SocketRing(const SocketRing&) = delete;
+    SocketRing& operator=(const SocketRing&) = delete;
+
+    bool Init(uint32_t inQueueDepth, uint32_t inBufferCount, uint32_t inBufferSize);
+    struct io_uring_sqe* GetSubmissionEntry();
+    uint32_t AddOperation(SocketCompletionType inType, const TCPSocketPtr& inSocket, void* inUserData);
+    void PrepareReceive(uint32_t inOperation);
+    void RecycleBuffers();
+    int Enter(uint32_t inToSubmit, uint32_t inMinComplete, int inTimeoutMs);
+
+    int mRing;
+
+    // submission queue shared with the kernel
+    void* mSubmissionMap;
+    size_t mSubmissionMapSize;
+    uint32_t* mSubmissionHead;
+    uint32_t* mSubmissionTail;
+    uint32_t mSubmissionMask;
+    uint32_t* mSubmissionArray;
+    struct io_uring_sqe* mSubmissionEntries;
+    size_t mSubmissionEntriesSize;
+    uint32_t mLocalTail;
+    uint32_t mToSubmit;
+
+    // completion queue shared with the kernel
+    void* mCompletionMap;
+    size_t mCompletionMapSize;
+    uint32_t* mCompletionHead;
+    uint32_t* mCompletionTail;
+    uint32_t mCompletionMask;
+    struct io_uring_cqe* mCompletionEntries;
+
+    // provided buffers for multishot receive
+    struct io_uring_buf_ring* mBufferRing;
+    size_t mBufferRingSize;
+    uint32_t mBufferCount;
+    uint32_t mBufferSize;
+    vector<char> mBuffers;
+    vector<uint16_t> mUsedBuffers;
+
+    vector<Operation> mOperations;
+    vector<uint32_t> mFreeOperations;
+    // receives stopped by -ENOBUFS, they are restarted after the buffers are recycled
+    vector<uint32_t> mStarvedReceives;
+    // starved receives removed by Cancel, they complete with -ECANCELED on the next Wait
+    vector<uint32_t> mCancelledReceives;
+};
+
+typedef shared_ptr<SocketRing> SocketRingPtr;
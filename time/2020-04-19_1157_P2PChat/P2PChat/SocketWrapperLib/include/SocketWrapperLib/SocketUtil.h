@@ -16,24 +16,53 @@ public:
     static bool StaticInit();
     static void CleanUp();
 
-    static void SetErrorCallBack(std::function<void(std::string)> errorCallback);
+    // Process-wide fallback for threads without a SocketErrorScope. Set it once at start up,
+    // it is read without a lock. Like a scope it gets the plain record, reporting does not allocate.
+    static void SetErrorCallBack(SocketErrorCallBack errorCallback);
+    // inOperationDesc has to be a string literal, SocketErrorLog keeps the pointer.
+    // Adds the current error to GetErrorLog and passes it to the callback of the thread;
+    // GetLastError still returns it afterwards.
     static void ReportError(const char* inOperationDesc);
     static int GetLastError();
+    static const SocketErrorLog& GetErrorLog();
 
     static int Select(const vector<TCPSocketPtr>* inReadSet,
                       vector<TCPSocketPtr>* outReadSet,
                       const vector<TCPSocketPtr>* inWriteSet,
                       vector<TCPSocketPtr>* outWriteSet,
                       const vector<TCPSocketPtr>* inExceptSet,
-                      vector<TCPSocketPtr>* outExceptSet);
+                      vector<TCPSocketPtr>* outExceptSet,
+                      int inTimeoutMs = -1);
+
+    // poll, WSAPoll on Windows, for waits on a few sockets: unlike select there is no FD_SETSIZE limit on
+    // the descriptors. An interrupted wait goes on with the time left, inTimeoutMs < 0 waits infinitely.
+    // Returns the number of ready entries, 0 after the timeout, or negative error.
+    static int Poll(pollfd* ioPollFds, size_t inCount, int inTimeoutMs);
+    // The sockets of inSockets which are ready for inInterest (SocketPollInterest), failed or closed go to outReady.
+    static int Poll(const vector<TCPSocketPtr>& inSockets, int inInterest, vector<TCPSocketPtr>& outReady,
+                    int inTimeoutMs = -1);
+
+    // setsockopt and getsockopt for int options, the option setters of the sockets use them.
+    // inOperationDesc names the setter in the error report. GetOption returns the value or negative error.
+    static int SetOption(SOCKET inSocket, int inLevel, int inName, int inValue, const char* inOperationDesc);
+    static int GetOption(SOCKET inSocket, int inLevel, int inName, const char* inOperationDesc);
 
     static UDPSocketPtr CreateUDPSocket(SocketAddressFamily inFamily);
     static TCPSocketPtr CreateTCPSocket(SocketAddressFamily inFamily);
+    static LocalSocketPtr CreateLocalSocket(LocalSocketType inType = LOCAL_STREAM);
+    // Two connected local sockets (socketpair), e.g. for a child process or another thread.
+    static int CreateLocalSocketPair(LocalSocketPtr& outFirst, LocalSocketPtr& outSecond,
+                                     LocalSocketType inType = LOCAL_STREAM);
+
+    // Pins the calling thread to one CPU, e.g. an event loop per core next to the interrupts of its queue.
+    // Returns NO_ERROR or negative error, -WSAEOPNOTSUPP where the platform has no thread affinity.
+    static int SetCurrentThreadAffinity(size_t inCpu);
 
 private:
 
     inline static fd_set* FillSetFromVector(fd_set& outSet, const vector<TCPSocketPtr>* inSockets, int& ioNaxNfds);
     inline static void FillVectorFromSet(vector<TCPSocketPtr>* outSockets, const vector<TCPSocketPtr>* inSockets,
                                          const fd_set& inSet);
-    static std::function<void(std::string)> m_errorCallBack;
+    static SocketErrorCallBack m_errorCallBack;
+    static SocketErrorLog m_errorLog;
 };
@@ -3,6 +3,10 @@
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
+//select takes this many sockets in SocketUtil::Select and the SocketPoller fallback, instead of 64
+#ifndef FD_SETSIZE
+#define FD_SETSIZE 1024
+#endif
 
 #include "Windows.h"
 #include "WinSock2.h"
@@ -13,8 +17,11 @@ typedef int socklen_t;
 #else
  #include <sys/socket.h>
  #include <netinet/in.h>
+ #include <netinet/tcp.h>
+ #include <arpa/inet.h>
  #include <sys/types.h>
  #include <netdb.h>
+ #include <poll.h>
  #include <errno.h>
  #include <fcntl.h>
  #include <unistd.h>
@@ -24,10 +31,16 @@ typedef int socklen_t;
  const int INVALID_SOCKET = -1;
  const int WSAECONNRESET = ECONNRESET;
  const int WSAEWOULDBLOCK = EAGAIN;
+ const int WSAEMSGSIZE = EMSGSIZE;
+ const int WSAETIMEDOUT = ETIMEDOUT;
+ const int WSAEINVAL = EINVAL;
+ const int WSAEOPNOTSUPP = EOPNOTSUPP;
+ const int WSAEMFILE = EMFILE;
  const int SOCKET_ERROR = -1;
 #endif
 
 
+#include "algorithm"
 #include "memory"
 
 #include "vector"
@@ -38,6 +51,8 @@ typedef int socklen_t;
 #include "deque"
 #include "unordered_set"
 #include "cassert"
+#include "cstring"
+#include "cstdarg"
 
 using std::shared_ptr;
 using std::unique_ptr;
@@ -50,8 +65,27 @@ using std::string;
 using std::unordered_set;
 
 #include "StringUtils.h"
+#include "SocketErrorLog.h"
 #include "SocketAddress.h"
 #include "SocketAddressFactory.h"
+#include "AddressResolver.h"
+#include "SocketBuffer.h"
+#include "BufferPool.h"
+#include "MemoryStream.h"
+#include "DatagramBatch.h"
 #include "UDPSocket.h"
+#include "DatagramTransport.h"
+#include "ReliableConnection.h"
 #include "TCPSocket.h"
+#include "LocalSocket.h"
+#include "TCPConnector.h"
+#include "ConnectionPool.h"
+#include "ShardedListener.h"
 #include "SocketUtil.h"
+#include "SocketPoller.h"
+#include "SocketRing.h"
+#include "SocketRelay.h"
+#include "TimerWheel.h"
+#include "MpscQueue.h"
+#include "PollerWakeup.h"
+#include "SlotMap.h"
@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+
+#include "SocketWrapperShared.h"
+
+struct ConnectOptions
+{
+    // how long one address may take before it counts as failed
+    int attemptTimeoutMs = 3000;
+    // Connection Attempt Delay of RFC 8305: the next address is tried when the previous one
+    // has not connected within this time, without giving up on it
+    int attemptDelayMs = 250;
+    int totalTimeoutMs = 10000;
+};
+
+// Connects to the first of several addresses of one host which answers (happy eyeballs, RFC 8305).
+// Address families are interleaved, a new attempt starts every attemptDelayMs or as soon as one fails,
+// the first connected socket wins and the other attempts are closed.
+// Sockets are non-blocking, so Update may be called from a loop that does other work, or Connect waits for the result.
+class TCPConnector
+{
+public:
+    TCPConnector(const vector<SocketAddress>& inAddresses, const ConnectOptions& inOptions = ConnectOptions());
+
+    // Starts due attempts and waits up to inWaitMs for one to finish.
+    // Returns the connected socket, which stays non-blocking, once. Returns nullptr while connecting and after failure.
+    TCPSocketPtr Update(int inWaitMs);
+    bool IsFinished() const { return mIsFinished; }
+    // Error of the last failed attempt, -WSAETIMEDOUT when time ran out.
+    int GetError() const { return mError; }
+
+    // Blocks until one address connected or all failed, the socket is returned in blocking mode.
+    static TCPSocketPtr Connect(const vector<SocketAddress>& inAddresses,
+                                const ConnectOptions& inOptions = ConnectOptions(), int* outError = nullptr);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Attempt
+    {
+        TCPSocketPtr socket;
+        Clock::time_point deadline;
+    };
+
+    TCPSocketPtr StartAttempts(Clock::time_point inNow);
+    TCPSocketPtr Finish(TCPSocketPtr inSocket, int inError);
+
+    vector<SocketAddress> mAddresses;
+    ConnectOptions mOptions;
+    size_t mNextAddress;
+    vector<Attempt> mAttempts;
+    Clock::time_point mNextAttemptTime;
+    Clock::time_point mDeadline;
+    int mError;
+    bool mIsFinished;
+};
@@ -6,18 +6,70 @@ class TCPSocket
 public:
     ~TCPSocket();
     int Connect(const SocketAddress& inAddress);
+    // Gives up with -WSAETIMEDOUT after inTimeoutMs, a negative timeout is -WSAEINVAL. The blocking mode of the socket is kept.
+    int Connect(const SocketAddress& inAddress, int inTimeoutMs);
+    // Connect for non-blocking sockets: NO_ERROR when connected at once, -WSAEWOULDBLOCK while connecting.
+    // The socket becomes writable when the attempt is over and GetConnectResult tells how it ended.
+    int StartConnect(const SocketAddress& inAddress);
+    int GetConnectResult();
     int Bind(const SocketAddress& inToAddress);
     int Listen(int inBackLog = 32);
     shared_ptr<TCPSocket> Accept(SocketAddress& inFromAddress);
     int32_t Send(const void* inData, size_t inLen);
     int32_t Receive(void* inBuffer, size_t inLen);
+    int32_t SendV(const SendBuffer* inBuffers, size_t inCount);
+    int32_t ReceiveV(const ReceiveBuffer* inBuffers, size_t inCount);
+    int32_t Send(const MemoryOutputStream& inMOS);
+    // Receives into a stream created with a capacity and resets it to the bytes that arrived,
+    // message boundaries are up to the caller.
+    int32_t Receive(MemoryInputStream& inMIS);
+    // Receives into the free space of a pooled buffer, behind the bytes it already holds, and grows its length.
+    int32_t Receive(PooledBuffer& ioBuffer);
+
+    // MSG_ZEROCOPY, Linux only. The kernel sends directly from the pages of the buffers,
+    // inOwner keeps them alive until the completion is read by ProcessZeroCopyCompletions.
+    // Small sends and sockets without EnableZeroCopy fall back to SendV.
+    int EnableZeroCopy();
+    int32_t SendZeroCopy(const SendBuffer* inBuffers, size_t inCount, shared_ptr<const void> inOwner);
+    // Reads notifications from the error queue (the socket is readable with an error then).
+    // Returns the number of zero-copy sends still in flight or negative error.
+    int ProcessZeroCopyCompletions();
     int SetNonBlockingMode(bool inShouldBeNonBlocking);
+
+    // Socket options. An option the platform does not have returns -WSAEOPNOTSUPP.
+    int SetNoDelay(bool inIsEnabled);
+    // Lets a restarted server bind its port while old connections are in TIME_WAIT. Set before Bind.
+    int SetReuseAddress(bool inIsEnabled);
+    // Linux and BSD: listen sockets bound to the same address share the incoming connections. Set before Bind.
+    int SetReusePort(bool inIsEnabled);
+    int SetSendBufferSize(int inSize);
+    int SetReceiveBufferSize(int inSize);
+    // The sizes the kernel uses, Linux doubles the requested value for its bookkeeping.
+    int GetSendBufferSize();
+    int GetReceiveBufferSize();
+    // Probes a connection idle for inIdleSeconds every inIntervalSeconds and drops it after inProbeCount
+    // unanswered probes, 0 keeps the system default.
+    int SetKeepAlive(bool inIsEnabled, int inIdleSeconds = 0, int inIntervalSeconds = 0, int inProbeCount = 0);
+    // Linux: a listen socket hands out a connection only when its first data arrived, or after inSeconds.
+    int SetDeferAccept(int inSeconds);
+
+    // For an idle connection: false when the peer closed or reset it, or sent data nobody asked for.
+    bool IsIdleConnectionAlive();
 private:
     friend class SocketUtil;
+    friend class LocalSocket;
+    friend class SocketPoller;
+    friend class SocketRing;
+    friend class SocketRelay;
+    friend class PollerWakeup;
 
     TCPSocket(SOCKET inSocket);
 
     SOCKET mSocket;
+    bool mIsNonBlocking;
+    bool mIsZeroCopyEnabled;
+    uint32_t mZeroCopySendCount;
+    deque<std::pair<uint32_t, shared_ptr<const void>>> mZeroCopyOwners;
 };
 
 typedef shared_ptr<TCPSocket> TCPSocketPtr;
@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <functional>
+
+#include "SocketWrapperShared.h"
+
+// 0 is never a valid timer
+typedef uint64_t TimerId;
+
+// Hierarchical timing wheel for the timeouts of an event loop: idle connections, heartbeats,
+// retransmits and connect deadlines. Schedule, Cancel and Reschedule are O(1) and do not allocate
+// once the node storage has grown, so millions of pending timers are cheap. Timers fire in Advance with
+// a resolution of one tick, never early. The loop waits at most GetTimeoutMs in SocketUtil::Select
+// or SocketPoller::Wait:
+//     int result = poller.Wait(events, wheel.GetTimeoutMs());
+//     ...
+//     wheel.Advance();
+// Not thread safe, callbacks run in Advance and may schedule and cancel timers.
+class TimerWheel
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void()> Callback;
+
+    explicit TimerWheel(Clock::duration inTick = std::chrono::milliseconds(1), Clock::time_point inNow = Clock::now());
+
+    TimerId Schedule(Clock::duration inDelay, Callback inCallback) { return ScheduleAt(Clock::now() + inDelay, std::move(inCallback)); }
+    TimerId ScheduleAt(Clock::time_point inTime, Callback inCallback);
+    // False when the timer already fired or was cancelled.
+    bool Cancel(TimerId inTimer);
+    // Moves a pending timer, e.g. the idle timeout of a connection which received data.
+    bool Reschedule(TimerId inTimer, Clock::duration inDelay) { return RescheduleAt(inTimer, Clock::now() + inDelay); }
+    bool RescheduleAt(TimerId inTimer, Clock::time_point inTime);
+
+    // Fires the timers due at inNow. Returns how many fired.
+    size_t Advance(Clock::time_point inNow = Clock::now());
+    // Milliseconds until Advance has work, -1 without timers. A timer far away may wake the loop earlier
+    // to move it to a finer level of the wheel.
+    int GetTimeoutMs(Clock::time_point inNow = Clock::now()) const;
+    size_t GetCount() const { return mCount; }
+
+private:
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int SLOTS_PER_LEVEL = 1 << LEVEL_BITS;
+    static constexpr int LEVELS = 6;
+    static constexpr uint32_t NIL = 0xffffffff;
+
+    struct Node
+    {
+        uint64_t expiry;
+        uint32_t previous;
+        uint32_t next;
+        uint32_t generation;
+        // level * SLOTS_PER_LEVEL + slot, or NIL while the node is free or firing
+        uint32_t bucket;
+        Callback callback;
+    };
+
+    uint64_t ToTick(Clock::time_point inTime) const;
+    Node* Find(TimerId inTimer);
+    // links into the slot of the expiry, but not before inEarliestTick
+    void Link(uint32_t inIndex, uint64_t inEarliestTick);
+    void Unlink(uint32_t inIndex);
+    void Release(uint32_t inIndex);
+    // the next tick at which a slot has to be fired or cascaded, or UINT64_MAX
+    uint64_t GetNextEventTick() const;
+    size_t ProcessTick();
+
+    Clock::time_point mStart;
+    Clock::duration mTick;
+    uint64_t mCurrentTick;
+    vector<Node> mNodes;
+    uint32_t mFreeList;
+    size_t mCount;
+    uint32_t mHeads[LEVELS * SLOTS_PER_LEVEL];
+    // one bit per non-empty slot
+    uint64_t mOccupied[LEVELS];
+};
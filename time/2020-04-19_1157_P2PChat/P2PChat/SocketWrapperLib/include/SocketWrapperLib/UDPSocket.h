@@ -11,19 +11,40 @@ public:
     int SendTo(const void* inToSend, int inLength, const SocketAddress& inToAddress);
     int ReceiveFrom(void* inToReceive, int inMaxLength, SocketAddress& outFromAddress);
 
-    /*
-    int SendTo( const MemoryOutputStream& inMOS, const SocketAddress& inToAddress );
-    int ReceiveFrom( MemoryInputStream& inMIS, SocketAddress& outFromAddress );
-    */
+    // Sends entries from inFirst on. Returns the number of datagrams sent or negative error.
+    int SendBatch(const DatagramBatch& inBatch, size_t inFirst = 0);
+    // Replaces the content of the batch. Returns the number of entries received, 0 if there is nothing to read.
+    int ReceiveBatch(DatagramBatch& outBatch);
+
+    // UDP GSO, Linux only: SendBatch passes runs of equal sized datagrams to the same address
+    // as one large buffer which is split into datagrams below the socket layer.
+    int EnableSegmentationOffload();
+    // UDP GRO, Linux only: ReceiveBatch may get several datagrams of one sender in one entry,
+    // see DatagramBatch::GetSegmentSize. The batch slots should be 64 KB then.
+    int EnableReceiveOffload();
+
+    int SendTo(const MemoryOutputStream& inMOS, const SocketAddress& inToAddress);
+    // Receives into a stream created with a capacity and resets it to the datagram.
+    int ReceiveFrom(MemoryInputStream& inMIS, SocketAddress& outFromAddress);
 
     int SetNonBlockingMode(bool inShouldBeNonBlocking);
 
+    // Socket options, as on TCPSocket. With SetReusePort several sockets bound to the same address
+    // share the incoming datagrams by a hash of the sender.
+    int SetReuseAddress(bool inIsEnabled);
+    int SetReusePort(bool inIsEnabled);
+    int SetSendBufferSize(int inSize);
+    int SetReceiveBufferSize(int inSize);
+    int GetSendBufferSize();
+    int GetReceiveBufferSize();
+
 private:
     friend class SocketUtil;
 
     UDPSocket(SOCKET inSocket);
 
     SOCKET mSocket;
+    bool mIsSegmentationOffloadEnabled;
 };
 
 typedef shared_ptr<UDPSocket> UDPSocketPtr;
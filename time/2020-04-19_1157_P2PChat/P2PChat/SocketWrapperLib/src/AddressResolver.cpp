@@ -0,0 +1,150 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    //the name or its addresses do not exist, asking again soon gives the same answer
+    bool IsNegativeAnswer(int inError)
+    {
+#ifdef EAI_NODATA
+        if (inError == EAI_NODATA)
+        {
+            return true;
+        }
+#endif
+        return inError == EAI_NONAME;
+    }
+}
+
+AddressResolver::AddressResolver(size_t inThreadCount, std::chrono::seconds inTimeToLive,
+                                 std::chrono::seconds inNegativeTimeToLive):
+    mTimeToLive(inTimeToLive),
+    mNegativeTimeToLive(inNegativeTimeToLive),
+    mIsStopping(false)
+{
+    for (size_t i = 0; i < std::max<size_t>(inThreadCount, 1); ++i)
+    {
+        mThreads.emplace_back(&AddressResolver::RunWorker, this);
+    }
+}
+
+AddressResolver::~AddressResolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mCondition.notify_all();
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+
+    ResolveResult result{EAI_AGAIN, {}};
+    for (auto& waiting : mWaiting)
+    {
+        for (ResolveCallback& callback : waiting.second)
+        {
+            callback(result);
+        }
+    }
+}
+
+void AddressResolver::Resolve(const string& inString, ResolveCallback inCallback)
+{
+    ResolveResult result;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!FindCached(inString, result))
+        {
+            vector<ResolveCallback>& callbacks = mWaiting[inString];
+            callbacks.push_back(std::move(inCallback));
+            if (callbacks.size() == 1)
+            {
+                mQueue.push_back(inString);
+                mCondition.notify_one();
+            }
+            return;
+        }
+    }
+    inCallback(result);
+}
+
+std::future<ResolveResult> AddressResolver::Resolve(const string& inString)
+{
+    auto promise = std::make_shared<std::promise<ResolveResult>>();
+    std::future<ResolveResult> future = promise->get_future();
+    Resolve(inString, [promise](const ResolveResult& inResult) { promise->set_value(inResult); });
+    return future;
+}
+
+bool AddressResolver::TryGetCached(const string& inString, ResolveResult& outResult)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return FindCached(inString, outResult);
+}
+
+void AddressResolver::ClearCache()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCache.clear();
+}
+
+bool AddressResolver::FindCached(const string& inString, ResolveResult& outResult)
+{
+    auto entry = mCache.find(inString);
+    if (entry == mCache.end())
+    {
+        return false;
+    }
+    if (entry->second.expiryTime <= Clock::now())
+    {
+        mCache.erase(entry);
+        return false;
+    }
+    outResult = entry->second.result;
+    return true;
+}
+
+void AddressResolver::RunWorker()
+{
+    while (true)
+    {
+        string name;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mIsStopping || !mQueue.empty(); });
+            if (mIsStopping)
+            {
+                return;
+            }
+            name = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        ResolveResult result;
+        result.error = SocketAddressFactory::CreateAllFromString(name, result.addresses);
+
+        vector<ResolveCallback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (result.error == NO_ERROR)
+            {
+                mCache[name] = {result, Clock::now() + mTimeToLive};
+            }
+            else if (IsNegativeAnswer(result.error))
+            {
+                mCache[name] = {result, Clock::now() + mNegativeTimeToLive};
+            }
+            auto waiting = mWaiting.find(name);
+            callbacks = std::move(waiting->second);
+            mWaiting.erase(waiting);
+        }
+
+        for (ResolveCallback& callback : callbacks)
+        {
+            callback(result);
+        }
+    }
+}
@@ -0,0 +1,285 @@
+#include "SocketWrapperShared.h"
+
+#include <new>
+
+namespace
+{
+    size_t RoundUpToCacheLine(size_t inSize)
+    {
+        return (inSize + BufferPool::CACHE_LINE_SIZE - 1) / BufferPool::CACHE_LINE_SIZE * BufferPool::CACHE_LINE_SIZE;
+    }
+
+    // Ids of the pools which are alive. A thread cache remembers the id, so it does not touch
+    // a destroyed pool or a new pool at the same address. Never destroyed, threads may end after main.
+    struct PoolRegistry
+    {
+        std::mutex mutex;
+        unordered_set<uint64_t> livePools;
+        uint64_t nextId = 1;
+    };
+
+    PoolRegistry& GetRegistry()
+    {
+        static PoolRegistry* registry = new PoolRegistry;
+        return *registry;
+    }
+}
+
+struct BufferPool::ThreadCache
+{
+    BufferPool* pool;
+    uint64_t poolId;
+    vector<PooledBuffer*> buffers;
+};
+
+// The caches of one thread, one per live pool it used. Buffers go back to their pools when the thread ends.
+class BufferPoolThreadCaches
+{
+public:
+    ~BufferPoolThreadCaches()
+    {
+        sIsDestroyed = true;
+        //the registry lock keeps the pools from being destroyed meanwhile
+        PoolRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (BufferPool::ThreadCache& cache : mCaches)
+        {
+            if (registry.livePools.count(cache.poolId) > 0)
+            {
+                cache.pool->Drain(cache, cache.buffers.size());
+            }
+        }
+    }
+
+    BufferPool::ThreadCache& Get(BufferPool* inPool, uint64_t inPoolId, size_t inCapacity)
+    {
+        if (mLast && mLast->pool == inPool && mLast->poolId == inPoolId)
+        {
+            return *mLast;
+        }
+        for (BufferPool::ThreadCache& cache : mCaches)
+        {
+            if (cache.pool == inPool && cache.poolId == inPoolId)
+            {
+                mLast = &cache;
+                return cache;
+            }
+        }
+        mLast = FindDestroyed();
+        if (!mLast)
+        {
+            //deque, so the caches do not move when another pool is added
+            mCaches.push_back({});
+            mLast = &mCaches.back();
+        }
+        mLast->pool = inPool;
+        mLast->poolId = inPoolId;
+        mLast->buffers.clear();
+        mLast->buffers.reserve(inCapacity + 1);
+        return *mLast;
+    }
+
+    // Buffers released by destructors of static objects after the caches of the thread are gone
+    // go straight to the shared list.
+    static bool IsDestroyed() { return sIsDestroyed; }
+
+private:
+    // A cache of a pool which is gone, taken over by the next pool, so a thread which outlives
+    // many short-lived pools keeps one cache per live pool. Its buffers went with the slabs of the pool.
+    BufferPool::ThreadCache* FindDestroyed()
+    {
+        PoolRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (BufferPool::ThreadCache& cache : mCaches)
+        {
+            if (registry.livePools.count(cache.poolId) == 0)
+            {
+                return &cache;
+            }
+        }
+        return nullptr;
+    }
+
+    static thread_local bool sIsDestroyed;
+
+    deque<BufferPool::ThreadCache> mCaches;
+    BufferPool::ThreadCache* mLast = nullptr;
+};
+
+thread_local bool BufferPoolThreadCaches::sIsDestroyed = false;
+
+namespace
+{
+    thread_local BufferPoolThreadCaches tThreadCaches;
+}
+
+PooledBuffer::PooledBuffer(BufferPool* inPool, char* inData, size_t inCapacity):
+    mPool(inPool),
+    mData(inData),
+    mCapacity(static_cast<uint32_t>(inCapacity)),
+    mLength(0),
+    mReferenceCount(0),
+    mNextFree(nullptr)
+{
+}
+
+PooledBufferPtr::PooledBufferPtr(const PooledBufferPtr& inOther): mBuffer(inOther.mBuffer)
+{
+    if (mBuffer)
+    {
+        mBuffer->mReferenceCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PooledBufferPtr& PooledBufferPtr::operator=(PooledBufferPtr inOther) noexcept
+{
+    std::swap(mBuffer, inOther.mBuffer);
+    return *this;
+}
+
+void PooledBufferPtr::Reset()
+{
+    //acquire-release, so the next owner sees every write of the previous ones
+    if (mBuffer && mBuffer->mReferenceCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        mBuffer->mPool->Release(mBuffer);
+    }
+    mBuffer = nullptr;
+}
+
+BufferPool::BufferPool(size_t inBufferSize, size_t inBuffersPerSlab, size_t inThreadCacheSize):
+    mBufferSize(inBufferSize),
+    mBuffersPerSlab(std::max<size_t>(inBuffersPerSlab, 1)),
+    mThreadCacheSize(inThreadCacheSize),
+    mStride(RoundUpToCacheLine(sizeof(PooledBuffer)) + RoundUpToCacheLine(inBufferSize)),
+    mFreeList(nullptr),
+    mUsedCount(0)
+{
+    PoolRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    mId = registry.nextId++;
+    registry.livePools.insert(mId);
+}
+
+BufferPool::~BufferPool()
+{
+    {
+        PoolRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.livePools.erase(mId);
+    }
+    for (void* slab : mSlabs)
+    {
+        ::operator delete(slab, std::align_val_t(CACHE_LINE_SIZE));
+    }
+}
+
+BufferPool& BufferPool::GetDefault()
+{
+    //never destroyed, buffers and thread caches may be released after main
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+size_t BufferPool::GetSlabCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSlabs.size();
+}
+
+PooledBufferPtr BufferPool::Acquire()
+{
+    PooledBuffer* buffer;
+    if (BufferPoolThreadCaches::IsDestroyed())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        buffer = PopShared();
+    }
+    else
+    {
+        ThreadCache& cache = GetThreadCache();
+        if (cache.buffers.empty())
+        {
+            Refill(cache, std::max<size_t>(mThreadCacheSize / 2, 1));
+        }
+        buffer = cache.buffers.back();
+        cache.buffers.pop_back();
+    }
+
+    buffer->mReferenceCount.store(1, std::memory_order_relaxed);
+    buffer->mLength = 0;
+    mUsedCount.fetch_add(1, std::memory_order_relaxed);
+    return PooledBufferPtr(buffer);
+}
+
+void BufferPool::Release(PooledBuffer* inBuffer)
+{
+    mUsedCount.fetch_sub(1, std::memory_order_relaxed);
+    if (BufferPoolThreadCaches::IsDestroyed())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        PushShared(inBuffer);
+        return;
+    }
+    ThreadCache& cache = GetThreadCache();
+    cache.buffers.push_back(inBuffer);
+    //a thread which only releases, e.g. the last recipient of a broadcast, hands half back
+    if (cache.buffers.size() > mThreadCacheSize)
+    {
+        Drain(cache, std::max<size_t>(mThreadCacheSize / 2, 1));
+    }
+}
+
+BufferPool::ThreadCache& BufferPool::GetThreadCache()
+{
+    return tThreadCaches.Get(this, mId, mThreadCacheSize);
+}
+
+void BufferPool::AllocateSlab()
+{
+    char* slab = static_cast<char*>(::operator new(mStride * mBuffersPerSlab, std::align_val_t(CACHE_LINE_SIZE)));
+    mSlabs.push_back(slab);
+    size_t headerSize = RoundUpToCacheLine(sizeof(PooledBuffer));
+    //in reverse, so the first buffers handed out are at the start of the slab
+    for (size_t i = mBuffersPerSlab; i-- > 0;)
+    {
+        char* header = slab + i * mStride;
+        PushShared(new (header) PooledBuffer(this, header + headerSize, mBufferSize));
+    }
+}
+
+void BufferPool::Refill(ThreadCache& ioCache, size_t inCount)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (size_t i = 0; i < inCount; ++i)
+    {
+        ioCache.buffers.push_back(PopShared());
+    }
+}
+
+void BufferPool::Drain(ThreadCache& ioCache, size_t inCount)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (size_t i = 0; i < inCount && !ioCache.buffers.empty(); ++i)
+    {
+        PushShared(ioCache.buffers.back());
+        ioCache.buffers.pop_back();
+    }
+}
+
+PooledBuffer* BufferPool::PopShared()
+{
+    if (!mFreeList)
+    {
+        AllocateSlab();
+    }
+    PooledBuffer* buffer = mFreeList;
+    mFreeList = buffer->mNextFree;
+    return buffer;
+}
+
+void BufferPool::PushShared(PooledBuffer* inBuffer)
+{
+    inBuffer->mNextFree = mFreeList;
+    mFreeList = inBuffer;
+}
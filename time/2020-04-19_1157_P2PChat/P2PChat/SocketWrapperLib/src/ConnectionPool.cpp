@@ -0,0 +1,153 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    const auto MAINTENANCE_INTERVAL = std::chrono::seconds(1);
+}
+
+ConnectionPool::ConnectionPool(const ConnectionPoolOptions& inOptions):
+    mOptions(inOptions),
+    mResolver(1),
+    mIsStopping(false)
+{
+    mMaintenanceThread = std::thread(&ConnectionPool::RunMaintenance, this);
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mCondition.notify_all();
+    mMaintenanceThread.join();
+}
+
+TCPSocketPtr ConnectionPool::Acquire(const string& inEndpoint, int* outError)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Endpoint& endpoint = mEndpoints[inEndpoint];
+        TCPSocketPtr socket = TakeIdle(endpoint, Clock::now());
+        if (endpoint.idle.size() < endpoint.warmCount)
+        {
+            mCondition.notify_one();
+        }
+        if (socket)
+        {
+            if (outError)
+            {
+                *outError = NO_ERROR;
+            }
+            return socket;
+        }
+    }
+    return Connect(inEndpoint, outError);
+}
+
+void ConnectionPool::Release(const string& inEndpoint, TCPSocketPtr inSocket)
+{
+    if (!inSocket)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    Endpoint& endpoint = mEndpoints[inEndpoint];
+    if (endpoint.idle.size() < std::max(mOptions.maxIdlePerEndpoint, endpoint.warmCount))
+    {
+        endpoint.idle.push_back({inSocket, Clock::now()});
+    }
+}
+
+void ConnectionPool::Prewarm(const string& inEndpoint, size_t inIdleCount)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEndpoints[inEndpoint].warmCount = inIdleCount;
+    }
+    mCondition.notify_one();
+}
+
+size_t ConnectionPool::GetIdleCount(const string& inEndpoint)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto endpoint = mEndpoints.find(inEndpoint);
+    return endpoint != mEndpoints.end() ? endpoint->second.idle.size() : 0;
+}
+
+TCPSocketPtr ConnectionPool::Connect(const string& inEndpoint, int* outError)
+{
+    ResolveResult resolved = mResolver.Resolve(inEndpoint).get();
+    if (resolved.error != NO_ERROR)
+    {
+        if (outError)
+        {
+            *outError = resolved.error;
+        }
+        return nullptr;
+    }
+    return TCPConnector::Connect(resolved.addresses, mOptions.connect, outError);
+}
+
+TCPSocketPtr ConnectionPool::TakeIdle(Endpoint& ioEndpoint, Clock::time_point inNow)
+{
+    //the most recently used connection first, the oldest ones time out at the front
+    while (!ioEndpoint.idle.empty())
+    {
+        IdleConnection connection = std::move(ioEndpoint.idle.back());
+        ioEndpoint.idle.pop_back();
+        if (inNow - connection.idleSince < std::chrono::milliseconds(mOptions.idleTimeoutMs)
+            && connection.socket->IsIdleConnectionAlive())
+        {
+            return connection.socket;
+        }
+    }
+    return nullptr;
+}
+
+void ConnectionPool::CloseStale(Clock::time_point inNow)
+{
+    for (auto& endpoint : mEndpoints)
+    {
+        deque<IdleConnection>& idle = endpoint.second.idle;
+        idle.erase(std::remove_if(idle.begin(), idle.end(), [&](const IdleConnection& inConnection)
+        {
+            return inNow - inConnection.idleSince >= std::chrono::milliseconds(mOptions.idleTimeoutMs)
+                || !inConnection.socket->IsIdleConnectionAlive();
+        }), idle.end());
+    }
+}
+
+void ConnectionPool::RunMaintenance()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    bool hasConnectFailed = false;
+    while (!mIsStopping)
+    {
+        CloseStale(Clock::now());
+
+        auto endpoint = std::find_if(mEndpoints.begin(), mEndpoints.end(), [](const auto& inEndpoint)
+        {
+            return inEndpoint.second.idle.size() < inEndpoint.second.warmCount;
+        });
+        //an endpoint which cannot be reached is tried again on the next interval, not in a loop
+        if (endpoint == mEndpoints.end() || hasConnectFailed)
+        {
+            hasConnectFailed = false;
+            mCondition.wait_for(lock, MAINTENANCE_INTERVAL);
+            continue;
+        }
+
+        string name = endpoint->first;
+        lock.unlock();
+        TCPSocketPtr socket = Connect(name, nullptr);
+        lock.lock();
+        if (socket)
+        {
+            mEndpoints[name].idle.push_back({socket, Clock::now()});
+        }
+        hasConnectFailed = !socket;
+    }
+}
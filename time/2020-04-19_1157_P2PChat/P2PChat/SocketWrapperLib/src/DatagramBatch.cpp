@@ -0,0 +1,53 @@
+#include "SocketWrapperShared.h"
+
+#ifdef __linux__
+namespace
+{
+    //UDP_SEGMENT is uint16_t when sent, UDP_GRO is int when received
+    const size_t CONTROL_SIZE = CMSG_SPACE(sizeof(int));
+}
+#endif
+
+DatagramBatch::DatagramBatch(size_t inCapacity, size_t inMaxDatagramSize):
+    mArena(inCapacity * inMaxDatagramSize),
+    mLengths(inCapacity),
+    mAddresses(inCapacity),
+    mSegmentSizes(inCapacity),
+    mMaxDatagramSize(inMaxDatagramSize),
+    mCount(0)
+#ifdef __linux__
+    , mHeaders(inCapacity),
+    mBuffers(inCapacity),
+    mControl(inCapacity * CONTROL_SIZE)
+#endif
+{
+}
+
+bool DatagramBatch::Add(const void* inData, size_t inLength, const SocketAddress& inToAddress)
+{
+    char* slot = GetNextSlot();
+    if (!slot || inLength > mMaxDatagramSize)
+    {
+        return false;
+    }
+    memcpy(slot, inData, inLength);
+    return Commit(inLength, inToAddress);
+}
+
+char* DatagramBatch::GetNextSlot()
+{
+    return mCount < GetCapacity() ? &mArena[mCount * mMaxDatagramSize] : nullptr;
+}
+
+bool DatagramBatch::Commit(size_t inLength, const SocketAddress& inToAddress)
+{
+    if (mCount >= GetCapacity() || inLength > mMaxDatagramSize)
+    {
+        return false;
+    }
+    mLengths[mCount] = inLength;
+    mAddresses[mCount] = inToAddress;
+    mSegmentSizes[mCount] = 0;
+    ++mCount;
+    return true;
+}
@@ -0,0 +1,67 @@
+#include "SocketWrapperShared.h"
+
+UDPTransport::UDPTransport(UDPSocketPtr inSocket): mSocket(inSocket)
+{
+    mSocket->SetNonBlockingMode(true);
+}
+
+int UDPTransport::SendTo(const void* inData, int inLength, const SocketAddress& inToAddress)
+{
+    return mSocket->SendTo(inData, inLength, inToAddress);
+}
+
+int UDPTransport::ReceiveFrom(void* inBuffer, int inMaxLength, SocketAddress& outFromAddress)
+{
+    return mSocket->ReceiveFrom(inBuffer, inMaxLength, outFromAddress);
+}
+
+LossyTransport::LossyTransport(DatagramTransportPtr inTransport, double inLossRate, int inDelayMs, int inJitterMs,
+                               uint32_t inSeed):
+    mTransport(inTransport),
+    mLossRate(inLossRate),
+    mDelayMs(inDelayMs),
+    mJitterMs(inJitterMs),
+    mRandom(inSeed),
+    mDroppedCount(0)
+{
+}
+
+int LossyTransport::SendTo(const void* inData, int inLength, const SocketAddress& inToAddress)
+{
+    SendDueDatagrams();
+
+    //a lost datagram looks sent to the caller
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(mRandom) < mLossRate)
+    {
+        ++mDroppedCount;
+        return inLength;
+    }
+
+    int delayMs = mDelayMs + (mJitterMs > 0 ? std::uniform_int_distribution<int>(0, mJitterMs)(mRandom) : 0);
+    if (delayMs <= 0)
+    {
+        return mTransport->SendTo(inData, inLength, inToAddress);
+    }
+
+    const char* data = static_cast<const char*>(inData);
+    mDelayed.push({Clock::now() + std::chrono::milliseconds(delayMs), vector<char>(data, data + inLength),
+                   inToAddress});
+    return inLength;
+}
+
+int LossyTransport::ReceiveFrom(void* inBuffer, int inMaxLength, SocketAddress& outFromAddress)
+{
+    SendDueDatagrams();
+    return mTransport->ReceiveFrom(inBuffer, inMaxLength, outFromAddress);
+}
+
+void LossyTransport::SendDueDatagrams()
+{
+    auto now = Clock::now();
+    while (!mDelayed.empty() && mDelayed.top().dueTime <= now)
+    {
+        const DelayedDatagram& datagram = mDelayed.top();
+        mTransport->SendTo(datagram.data.data(), static_cast<int>(datagram.data.size()), datagram.toAddress);
+        mDelayed.pop();
+    }
+}
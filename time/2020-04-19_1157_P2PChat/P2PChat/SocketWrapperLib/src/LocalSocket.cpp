@@ -0,0 +1,177 @@
+#include "SocketWrapperShared.h"
+
+#if !_WIN32
+#include <sys/un.h>
+
+namespace
+{
+    //descriptors one ReceiveWithDescriptors takes, the kernel closes the ones which do not fit
+    const size_t MAX_RECEIVED_DESCRIPTORS = 16;
+
+    bool FillAddress(const string& inPath, sockaddr_un& outAddress, socklen_t& outLength)
+    {
+        std::memset(&outAddress, 0, sizeof(outAddress));
+        outAddress.sun_family = AF_UNIX;
+        if (inPath.empty() || inPath.size() >= sizeof(outAddress.sun_path))
+        {
+            errno = EINVAL;
+            return false;
+        }
+
+        std::memcpy(outAddress.sun_path, inPath.data(), inPath.size());
+        //an abstract name starts with a zero byte and has exactly the given length, a path is terminated
+        bool isAbstract = inPath[0] == '@';
+        if (isAbstract)
+        {
+            outAddress.sun_path[0] = '\0';
+        }
+        outLength = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + inPath.size() + (isAbstract ? 0 : 1));
+        return true;
+    }
+}
+
+int LocalSocket::Bind(const string& inPath)
+{
+    sockaddr_un address;
+    socklen_t length;
+    if (!FillAddress(inPath, address, length) || bind(mSocket, reinterpret_cast<sockaddr*>(&address), length) < 0)
+    {
+        SocketUtil::ReportError("LocalSocket::Bind");
+        return -SocketUtil::GetLastError();
+    }
+    return NO_ERROR;
+}
+
+int LocalSocket::Connect(const string& inPath)
+{
+    sockaddr_un address;
+    socklen_t length;
+    if (!FillAddress(inPath, address, length) || connect(mSocket, reinterpret_cast<sockaddr*>(&address), length) < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        //a non-blocking connect to a full backlog is retried later
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("LocalSocket::Connect");
+        }
+        return -error;
+    }
+    return NO_ERROR;
+}
+
+LocalSocketPtr LocalSocket::Accept()
+{
+    SOCKET newSocket = accept(mSocket, nullptr, nullptr);
+    if (newSocket == INVALID_SOCKET)
+    {
+        if (SocketUtil::GetLastError() != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("LocalSocket::Accept");
+        }
+        return nullptr;
+    }
+    return LocalSocketPtr(new LocalSocket(newSocket, mType));
+}
+
+int32_t LocalSocket::SendWithDescriptors(const void* inData, size_t inLen, const int* inDescriptors, size_t inCount)
+{
+    iovec buffer{const_cast<void*>(inData), inLen};
+    msghdr message{};
+    message.msg_iov = &buffer;
+    message.msg_iovlen = 1;
+
+    vector<char> control(CMSG_SPACE(sizeof(int) * inCount));
+    if (inCount > 0)
+    {
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * inCount);
+        std::memcpy(CMSG_DATA(header), inDescriptors, sizeof(int) * inCount);
+    }
+
+    ssize_t bytesSentCount = sendmsg(mSocket, &message, MSG_NOSIGNAL);
+    if (bytesSentCount < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("LocalSocket::SendWithDescriptors");
+        }
+        return -error;
+    }
+    return static_cast<int32_t>(bytesSentCount);
+}
+
+int32_t LocalSocket::ReceiveWithDescriptors(void* outBuffer, size_t inLen, vector<int>& outDescriptors)
+{
+    iovec buffer{outBuffer, inLen};
+    msghdr message{};
+    message.msg_iov = &buffer;
+    message.msg_iovlen = 1;
+    char control[CMSG_SPACE(sizeof(int) * MAX_RECEIVED_DESCRIPTORS)];
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t bytesReceivedCount = recvmsg(mSocket, &message, MSG_CMSG_CLOEXEC);
+    if (bytesReceivedCount < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("LocalSocket::ReceiveWithDescriptors");
+        }
+        return -error;
+    }
+
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+        {
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const unsigned char* data = CMSG_DATA(header);
+            for (size_t i = 0; i < count; ++i)
+            {
+                int descriptor;
+                std::memcpy(&descriptor, data + i * sizeof(int), sizeof(int));
+                outDescriptors.push_back(descriptor);
+            }
+        }
+    }
+    return static_cast<int32_t>(bytesReceivedCount);
+}
+
+#else
+
+int LocalSocket::Bind(const string& inPath)
+{
+    return -WSAEOPNOTSUPP;
+}
+
+int LocalSocket::Connect(const string& inPath)
+{
+    return -WSAEOPNOTSUPP;
+}
+
+LocalSocketPtr LocalSocket::Accept()
+{
+    return nullptr;
+}
+
+int32_t LocalSocket::SendWithDescriptors(const void* inData, size_t inLen, const int* inDescriptors, size_t inCount)
+{
+    return -WSAEOPNOTSUPP;
+}
+
+int32_t LocalSocket::ReceiveWithDescriptors(void* outBuffer, size_t inLen, vector<int>& outDescriptors)
+{
+    return -WSAEOPNOTSUPP;
+}
+
+#endif
+
+LocalSocket::LocalSocket(SOCKET inSocket, LocalSocketType inType): TCPSocket(inSocket), mType(inType)
+{
+}
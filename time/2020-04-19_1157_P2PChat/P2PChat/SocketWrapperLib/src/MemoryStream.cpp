@@ -0,0 +1,210 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    const size_t MAX_VARINT_SIZE = 10;
+}
+
+MemoryOutputStream::MemoryOutputStream(size_t inInitialCapacity):
+    mArena(std::max<size_t>(inInitialCapacity, 1)),
+    mLength(0),
+    mBitOffset(0)
+{
+}
+
+void MemoryOutputStream::Clear()
+{
+    mLength = 0;
+    mBitOffset = 0;
+}
+
+void MemoryOutputStream::Reserve(size_t inLength)
+{
+    if (mLength + inLength > mArena.size())
+    {
+        mArena.resize(std::max(mArena.size() * 2, mLength + inLength));
+    }
+}
+
+void MemoryOutputStream::WriteBytes(const void* inData, size_t inLength)
+{
+    Reserve(inLength);
+    //data() and not &mArena[mLength]: a full arena has no element at mLength for an empty write
+    memcpy(mArena.data() + mLength, inData, inLength);
+    mLength += inLength;
+    mBitOffset = 0;
+}
+
+void MemoryOutputStream::WriteVarUInt(uint64_t inValue)
+{
+    char bytes[MAX_VARINT_SIZE];
+    size_t length = 0;
+    while (inValue >= 0x80)
+    {
+        bytes[length++] = static_cast<char>(inValue | 0x80);
+        inValue >>= 7;
+    }
+    bytes[length++] = static_cast<char>(inValue);
+    WriteBytes(bytes, length);
+}
+
+void MemoryOutputStream::WriteVarInt(int64_t inValue)
+{
+    //zigzag keeps small negative numbers short: 0, -1, 1, -2 become 0, 1, 2, 3
+    WriteVarUInt((static_cast<uint64_t>(inValue) << 1) ^ static_cast<uint64_t>(inValue >> 63));
+}
+
+void MemoryOutputStream::WriteString(std::string_view inValue)
+{
+    WriteVarUInt(inValue.size());
+    WriteBytes(inValue.data(), inValue.size());
+}
+
+void MemoryOutputStream::WriteBits(uint64_t inValue, int inBitCount)
+{
+    while (inBitCount > 0)
+    {
+        if (mBitOffset == 0)
+        {
+            Reserve(1);
+            mArena[mLength++] = 0;
+        }
+        int count = std::min(8 - mBitOffset, inBitCount);
+        uint8_t bits = static_cast<uint8_t>(inValue & ((1u << count) - 1));
+        mArena[mLength - 1] = static_cast<char>(static_cast<uint8_t>(mArena[mLength - 1]) | (bits << mBitOffset));
+
+        mBitOffset = (mBitOffset + count) % 8;
+        inValue >>= count;
+        inBitCount -= count;
+    }
+}
+
+MemoryInputStream::MemoryInputStream(const void* inData, size_t inLength):
+    mData(static_cast<const char*>(inData)),
+    mLength(inLength),
+    mPosition(0),
+    mBitOffset(0),
+    mIsValid(true)
+{
+}
+
+MemoryInputStream::MemoryInputStream(size_t inCapacity):
+    mOwnedBuffer(inCapacity),
+    mData(mOwnedBuffer.data()),
+    mLength(0),
+    mPosition(0),
+    mBitOffset(0),
+    mIsValid(true)
+{
+}
+
+void MemoryInputStream::Reset(size_t inLength)
+{
+    if (!mOwnedBuffer.empty())
+    {
+        mLength = std::min(inLength, mOwnedBuffer.size());
+    }
+    mPosition = 0;
+    mBitOffset = 0;
+    mIsValid = true;
+}
+
+bool MemoryInputStream::Fail()
+{
+    mIsValid = false;
+    return false;
+}
+
+const char* MemoryInputStream::Advance(size_t inLength)
+{
+    if (!mIsValid || inLength > mLength - mPosition)
+    {
+        Fail();
+        return nullptr;
+    }
+    const char* data = mData + mPosition;
+    mPosition += inLength;
+    mBitOffset = 0;
+    return data;
+}
+
+bool MemoryInputStream::ReadBytes(void* outData, size_t inLength)
+{
+    const char* data = Advance(inLength);
+    if (!data)
+    {
+        return false;
+    }
+    memcpy(outData, data, inLength);
+    return true;
+}
+
+bool MemoryInputStream::ReadVarUInt(uint64_t& outValue)
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        uint8_t byte;
+        if (!Read(byte))
+        {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            outValue = value;
+            return true;
+        }
+    }
+    //more than 10 bytes is not a varint we wrote
+    return Fail();
+}
+
+bool MemoryInputStream::ReadVarInt(int64_t& outValue)
+{
+    uint64_t value;
+    if (!ReadVarUInt(value))
+    {
+        return false;
+    }
+    outValue = static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    return true;
+}
+
+bool MemoryInputStream::ReadString(std::string_view& outValue)
+{
+    uint64_t length;
+    if (!ReadVarUInt(length) || length > GetRemainingLength())
+    {
+        return Fail();
+    }
+    outValue = std::string_view(Advance(static_cast<size_t>(length)), static_cast<size_t>(length));
+    return true;
+}
+
+bool MemoryInputStream::ReadBits(uint64_t& outValue, int inBitCount)
+{
+    uint64_t value = 0;
+    int readCount = 0;
+    while (readCount < inBitCount)
+    {
+        if (mBitOffset == 0)
+        {
+            if (!mIsValid || mPosition == mLength)
+            {
+                return Fail();
+            }
+            ++mPosition;
+        }
+        int count = std::min(8 - mBitOffset, inBitCount - readCount);
+        uint64_t bits = (static_cast<uint8_t>(mData[mPosition - 1]) >> mBitOffset) & ((1u << count) - 1);
+        value |= bits << readCount;
+
+        mBitOffset = (mBitOffset + count) % 8;
+        readCount += count;
+    }
+    outValue = value;
+    return true;
+}
@@ -0,0 +1,81 @@
+#include "SocketWrapperShared.h"
+
+PollerWakeup::PollerWakeup():
+    mIsPending(false)
+{
+}
+
+int PollerWakeup::Open()
+{
+#if _WIN32
+    //no socketpair, a listen socket on an ephemeral loopback port connects the pair once
+    TCPSocketPtr listenSocket = SocketUtil::CreateTCPSocket(INET);
+    if (!listenSocket)
+    {
+        return -SocketUtil::GetLastError();
+    }
+    int result = listenSocket->Bind(SocketAddress(INADDR_LOOPBACK, 0));
+    if (result != NO_ERROR || (result = listenSocket->Listen(1)) != NO_ERROR)
+    {
+        return result;
+    }
+    sockaddr_storage boundAddress;
+    socklen_t boundLength = sizeof(boundAddress);
+    if (getsockname(listenSocket->mSocket, reinterpret_cast<sockaddr*>(&boundAddress), &boundLength) < 0)
+    {
+        SocketUtil::ReportError("PollerWakeup::Open");
+        return -SocketUtil::GetLastError();
+    }
+    TCPSocketPtr writeSocket = SocketUtil::CreateTCPSocket(INET);
+    if (!writeSocket)
+    {
+        return -SocketUtil::GetLastError();
+    }
+    if ((result = writeSocket->Connect(SocketAddress(reinterpret_cast<const sockaddr&>(boundAddress)))) != NO_ERROR)
+    {
+        return result;
+    }
+    SocketAddress fromAddress;
+    TCPSocketPtr readSocket = listenSocket->Accept(fromAddress);
+    if (!readSocket)
+    {
+        return -SocketUtil::GetLastError();
+    }
+    writeSocket->SetNoDelay(true);
+#else
+    LocalSocketPtr readSocket, writeSocket;
+    int result = SocketUtil::CreateLocalSocketPair(readSocket, writeSocket);
+    if (result != NO_ERROR)
+    {
+        return result;
+    }
+#endif
+    //a wakeup never blocks the notifying thread, the reader drains until WSAEWOULDBLOCK
+    readSocket->SetNonBlockingMode(true);
+    writeSocket->SetNonBlockingMode(true);
+    mReadSocket = readSocket;
+    mWriteSocket = writeSocket;
+    return NO_ERROR;
+}
+
+void PollerWakeup::Notify()
+{
+    //the exchange orders the work handed over before it against the Clear of the waiting thread:
+    //either it sees true set after that Clear, then a byte is on its way, or it writes one
+    if (!mIsPending.exchange(true, std::memory_order_acq_rel))
+    {
+        char byte = 1;
+        mWriteSocket->Send(&byte, 1);
+    }
+}
+
+void PollerWakeup::Clear()
+{
+    //bytes first, then the flag: reset before reading, a Notify in between would set the flag again
+    //and its byte would be read here, the next Notify would then see the flag and write none
+    char bytes[64];
+    while (mReadSocket->Receive(bytes, sizeof(bytes)) > 0)
+    {
+    }
+    mIsPending.exchange(false, std::memory_order_acq_rel);
+}
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <cmath>
+
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    enum PacketType
+    {
+        PACKET_DATA = 1,
+        PACKET_ACK = 2
+    };
+
+    // type, channel, sequence, order index
+    const size_t DATA_HEADER_SIZE = 1 + 1 + 4 + 4;
+    // type, cumulative sequence, sequence that triggered the ack, range count
+    const size_t ACK_HEADER_SIZE = 1 + 4 + 4 + 1;
+    const size_t MAX_SACK_RANGES = 16;
+    const size_t MAX_PACKET_SIZE = DATA_HEADER_SIZE + ReliableConnection::MAX_MESSAGE_SIZE;
+
+    const uint32_t PACKET_THRESHOLD = 3;
+    const int MAX_TRANSMITS = 10;
+    const int MAX_BACKOFF = 64;
+    const double INITIAL_RTT_MS = 100;
+    const double MIN_RTO_MS = 20;
+    const double MAX_RTO_MS = 2000;
+    const double INITIAL_WINDOW = 10;
+    const double MIN_WINDOW = 2;
+
+    void WriteUInt32(char* outData, uint32_t inValue)
+    {
+        uint32_t value = htonl(inValue);
+        memcpy(outData, &value, sizeof(value));
+    }
+
+    uint32_t ReadUInt32(const char* inData)
+    {
+        uint32_t value;
+        memcpy(&value, inData, sizeof(value));
+        return ntohl(value);
+    }
+}
+
+ReliableConnection::ReliableConnection(DatagramTransportPtr inTransport, const SocketAddress& inRemoteAddress):
+    mTransport(inTransport),
+    mRemoteAddress(inRemoteAddress),
+    mIsConnectionLost(false),
+    mNextSequence(0),
+    mNextOrderIndex(0),
+    mLargestAcked(0),
+    mHasAck(false),
+    mSmoothedRttMs(INITIAL_RTT_MS),
+    mRttVarianceMs(INITIAL_RTT_MS / 2),
+    mBackoff(1),
+    mCongestionWindow(INITIAL_WINDOW),
+    mSlowStartThreshold(1e9),
+    mIsInRecovery(false),
+    mRecoverySequence(0),
+    mRetransmitCount(0),
+    mReceiveCumulative(0),
+    mLatestReceived(0),
+    mNextDeliverOrder(0),
+    mIsAckPending(false)
+{
+}
+
+int ReliableConnection::Send(const void* inData, size_t inLen, ReliableChannel inChannel)
+{
+    if (mIsConnectionLost)
+    {
+        return -WSAECONNRESET;
+    }
+    if (inLen > MAX_MESSAGE_SIZE)
+    {
+        return -WSAEMSGSIZE;
+    }
+
+    const char* data = static_cast<const char*>(inData);
+    if (inChannel == CHANNEL_UNRELIABLE)
+    {
+        vector<char> packet(DATA_HEADER_SIZE + inLen, 0);
+        packet[0] = PACKET_DATA;
+        packet[1] = static_cast<char>(inChannel);
+        std::copy(data, data + inLen, packet.begin() + DATA_HEADER_SIZE);
+        Transmit(packet);
+        return NO_ERROR;
+    }
+
+    uint32_t orderIndex = inChannel == CHANNEL_RELIABLE_ORDERED ? mNextOrderIndex++ : 0;
+    mSendQueue.push_back({inChannel, orderIndex, vector<char>(data, data + inLen)});
+    SendPending(Clock::now());
+    return NO_ERROR;
+}
+
+int ReliableConnection::Receive(void* outBuffer, size_t inMaxLength, ReliableChannel* outChannel)
+{
+    if (mDelivered.empty())
+    {
+        return -WSAEWOULDBLOCK;
+    }
+
+    DeliveredMessage& message = mDelivered.front();
+    if (message.data.size() > inMaxLength)
+    {
+        return -WSAEMSGSIZE;
+    }
+
+    std::copy(message.data.begin(), message.data.end(), static_cast<char*>(outBuffer));
+    if (outChannel)
+    {
+        *outChannel = message.channel;
+    }
+    int size = static_cast<int>(message.data.size());
+    mDelivered.pop_front();
+    return size;
+}
+
+int ReliableConnection::Update()
+{
+    auto now = Clock::now();
+    ReceivePackets(now);
+    DetectLosses(now);
+    SendPending(now);
+    SendAck();
+    return mIsConnectionLost ? -WSAECONNRESET : NO_ERROR;
+}
+
+void ReliableConnection::ReceivePackets(Clock::time_point inNow)
+{
+    char packet[MAX_PACKET_SIZE];
+    while (true)
+    {
+        SocketAddress fromAddress;
+        int size = mTransport->ReceiveFrom(packet, sizeof(packet), fromAddress);
+        if (size <= 0)
+        {
+            return;
+        }
+        if (!(fromAddress == mRemoteAddress))
+        {
+            continue;
+        }
+
+        if (packet[0] == PACKET_DATA && static_cast<size_t>(size) >= DATA_HEADER_SIZE)
+        {
+            ProcessData(packet, size);
+        }
+        else if (packet[0] == PACKET_ACK && static_cast<size_t>(size) >= ACK_HEADER_SIZE)
+        {
+            ProcessAck(packet, size, inNow);
+        }
+    }
+}
+
+void ReliableConnection::ProcessData(const char* inPacket, size_t inSize)
+{
+    ReliableChannel channel = static_cast<ReliableChannel>(inPacket[1]);
+    vector<char> data(inPacket + DATA_HEADER_SIZE, inPacket + inSize);
+    if (channel == CHANNEL_UNRELIABLE)
+    {
+        mDelivered.push_back({channel, std::move(data)});
+        return;
+    }
+
+    //duplicates are acknowledged again, the previous ack may have been lost
+    mIsAckPending = true;
+    uint32_t sequence = ReadUInt32(inPacket + 2);
+    mLatestReceived = sequence;
+    if (SequenceLess()(sequence, mReceiveCumulative) || !mReceivedAbove.insert(sequence).second)
+    {
+        return;
+    }
+    while (!mReceivedAbove.empty() && *mReceivedAbove.begin() == mReceiveCumulative)
+    {
+        mReceivedAbove.erase(mReceivedAbove.begin());
+        ++mReceiveCumulative;
+    }
+
+    if (channel == CHANNEL_RELIABLE_UNORDERED)
+    {
+        mDelivered.push_back({channel, std::move(data)});
+        return;
+    }
+
+    mOrderedBuffer.emplace(ReadUInt32(inPacket + 6), std::move(data));
+    for (auto it = mOrderedBuffer.begin(); it != mOrderedBuffer.end() && it->first == mNextDeliverOrder;
+         it = mOrderedBuffer.erase(it))
+    {
+        mDelivered.push_back({channel, std::move(it->second)});
+        ++mNextDeliverOrder;
+    }
+}
+
+void ReliableConnection::ProcessAck(const char* inPacket, size_t inSize, Clock::time_point inNow)
+{
+    uint32_t cumulative = ReadUInt32(inPacket + 1);
+    size_t rangeCount = std::min<size_t>(static_cast<uint8_t>(inPacket[9]), (inSize - ACK_HEADER_SIZE) / 8);
+
+    //only the packet that triggered the ack gives an rtt sample, older ones may have waited for a lost ack,
+    //and by Karn's rule a retransmitted packet does not tell which copy arrived
+    auto latest = mInFlight.find(ReadUInt32(inPacket + 5));
+    if (latest != mInFlight.end() && latest->second.transmitCount == 1)
+    {
+        double sampleMs = std::chrono::duration<double, std::milli>(inNow - latest->second.sentTime).count();
+        mRttVarianceMs = 0.75 * mRttVarianceMs + 0.25 * std::abs(mSmoothedRttMs - sampleMs);
+        mSmoothedRttMs = 0.875 * mSmoothedRttMs + 0.125 * sampleMs;
+    }
+
+    size_t inFlightBefore = mInFlight.size();
+    while (!mInFlight.empty() && SequenceLess()(mInFlight.begin()->first, cumulative))
+    {
+        AcknowledgePacket(mInFlight.begin());
+    }
+    for (size_t i = 0; i < rangeCount; ++i)
+    {
+        uint32_t first = ReadUInt32(inPacket + ACK_HEADER_SIZE + i * 8);
+        uint32_t end = ReadUInt32(inPacket + ACK_HEADER_SIZE + i * 8 + 4);
+        auto it = mInFlight.lower_bound(first);
+        while (it != mInFlight.end() && SequenceLess()(it->first, end))
+        {
+            auto next = std::next(it);
+            AcknowledgePacket(it);
+            it = next;
+        }
+    }
+
+    if (mInFlight.size() != inFlightBefore)
+    {
+        mBackoff = 1;
+        mTimerStart = inNow;
+    }
+    if (mIsInRecovery && !SequenceLess()(cumulative, mRecoverySequence))
+    {
+        mIsInRecovery = false;
+    }
+}
+
+void ReliableConnection::AcknowledgePacket(std::map<uint32_t, SentPacket, SequenceLess>::iterator inPacket)
+{
+    if (!mHasAck || SequenceLess()(mLargestAcked, inPacket->first))
+    {
+        mLargestAcked = inPacket->first;
+        mHasAck = true;
+    }
+
+    if (!mIsInRecovery)
+    {
+        mCongestionWindow += mCongestionWindow < mSlowStartThreshold ? 1.0 : 1.0 / mCongestionWindow;
+    }
+    mInFlight.erase(inPacket);
+}
+
+void ReliableConnection::DetectLosses(Clock::time_point inNow)
+{
+    if (mInFlight.empty())
+    {
+        return;
+    }
+
+    for (auto& entry : mInFlight)
+    {
+        if (!mHasAck || !SequenceLess()(entry.first + PACKET_THRESHOLD - 1, mLargestAcked))
+        {
+            break;
+        }
+        if (!entry.second.isFastRetransmitted)
+        {
+            entry.second.isFastRetransmitted = true;
+            EnterRecovery();
+            Retransmit(entry.second, inNow);
+        }
+    }
+
+    //one timer for the oldest unacknowledged packet, restarted by every ack of new data
+    if (inNow - mTimerStart < GetRetransmitTimeout() * mBackoff)
+    {
+        return;
+    }
+    Retransmit(mInFlight.begin()->second, inNow);
+
+    //holes whose fast retransmit was lost too are retransmitted again by the next acks
+    for (auto& entry : mInFlight)
+    {
+        entry.second.isFastRetransmitted = false;
+    }
+    mSlowStartThreshold = std::max(mInFlight.size() / 2.0, MIN_WINDOW);
+    mCongestionWindow = 1;
+    mIsInRecovery = false;
+    mBackoff = std::min(mBackoff * 2, MAX_BACKOFF);
+    mTimerStart = inNow;
+}
+
+void ReliableConnection::Retransmit(SentPacket& ioPacket, Clock::time_point inNow)
+{
+    Transmit(ioPacket.packet);
+    ioPacket.sentTime = inNow;
+    ++mRetransmitCount;
+    if (++ioPacket.transmitCount > MAX_TRANSMITS)
+    {
+        mIsConnectionLost = true;
+    }
+}
+
+void ReliableConnection::EnterRecovery()
+{
+    //one window reduction per loss event, until everything sent before it is acknowledged
+    if (mIsInRecovery)
+    {
+        return;
+    }
+    mSlowStartThreshold = std::max(mCongestionWindow / 2, MIN_WINDOW);
+    mCongestionWindow = mSlowStartThreshold;
+    mIsInRecovery = true;
+    mRecoverySequence = mNextSequence;
+}
+
+void ReliableConnection::SendPending(Clock::time_point inNow)
+{
+    while (!mSendQueue.empty() && mInFlight.size() < static_cast<size_t>(mCongestionWindow))
+    {
+        OutgoingMessage& message = mSendQueue.front();
+        vector<char> packet(DATA_HEADER_SIZE + message.data.size());
+        packet[0] = PACKET_DATA;
+        packet[1] = static_cast<char>(message.channel);
+        WriteUInt32(&packet[2], mNextSequence);
+        WriteUInt32(&packet[6], message.orderIndex);
+        std::copy(message.data.begin(), message.data.end(), packet.begin() + DATA_HEADER_SIZE);
+        mSendQueue.pop_front();
+
+        if (mInFlight.empty())
+        {
+            mTimerStart = inNow;
+        }
+        Transmit(packet);
+        mInFlight.emplace(mNextSequence++, SentPacket{std::move(packet), inNow, 1, false});
+    }
+}
+
+void ReliableConnection::SendAck()
+{
+    if (!mIsAckPending)
+    {
+        return;
+    }
+    mIsAckPending = false;
+
+    char packet[ACK_HEADER_SIZE + MAX_SACK_RANGES * 8];
+    packet[0] = PACKET_ACK;
+    WriteUInt32(packet + 1, mReceiveCumulative);
+    WriteUInt32(packet + 5, mLatestReceived);
+
+    //received sequences above the cumulative one, as [first, end) ranges from the lowest
+    size_t rangeCount = 0;
+    for (auto it = mReceivedAbove.begin(); it != mReceivedAbove.end() && rangeCount < MAX_SACK_RANGES; ++rangeCount)
+    {
+        uint32_t first = *it;
+        uint32_t end = first;
+        while (it != mReceivedAbove.end() && *it == end)
+        {
+            ++end;
+            ++it;
+        }
+        WriteUInt32(packet + ACK_HEADER_SIZE + rangeCount * 8, first);
+        WriteUInt32(packet + ACK_HEADER_SIZE + rangeCount * 8 + 4, end);
+    }
+    packet[9] = static_cast<char>(rangeCount);
+
+    mTransport->SendTo(packet, static_cast<int>(ACK_HEADER_SIZE + rangeCount * 8), mRemoteAddress);
+}
+
+void ReliableConnection::Transmit(const vector<char>& inPacket)
+{
+    mTransport->SendTo(inPacket.data(), static_cast<int>(inPacket.size()), mRemoteAddress);
+}
+
+ReliableConnection::Clock::duration ReliableConnection::GetRetransmitTimeout() const
+{
+    double timeoutMs = std::min(std::max(mSmoothedRttMs + 4 * mRttVarianceMs, MIN_RTO_MS), MAX_RTO_MS);
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(timeoutMs));
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    //how long an accept loop waits before it checks for Stop
+    const int STOP_CHECK_INTERVAL_MS = 100;
+}
+
+ShardedListener::ShardedListener(const ShardedListenerOptions& inOptions):
+    mOptions(inOptions),
+    mIsStopping(false)
+{
+    if (mOptions.shardCount == 0)
+    {
+        mOptions.shardCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+ShardedListener::~ShardedListener()
+{
+    Stop();
+}
+
+int ShardedListener::Open(const SocketAddress& inAddress)
+{
+    int error = NO_ERROR;
+    bool shouldReusePort = mOptions.shardCount > 1;
+    TCPSocketPtr first = OpenShard(inAddress, shouldReusePort, &error);
+    if (!first && error == -WSAEOPNOTSUPP)
+    {
+        //without SO_REUSEPORT the other sockets could not bind, one takes all connections
+        shouldReusePort = false;
+        first = OpenShard(inAddress, false, &error);
+    }
+    if (!first)
+    {
+        return error;
+    }
+
+    vector<TCPSocketPtr> sockets{first};
+    while (shouldReusePort && sockets.size() < mOptions.shardCount)
+    {
+        TCPSocketPtr socket = OpenShard(inAddress, true, &error);
+        if (!socket)
+        {
+            return error;
+        }
+        sockets.push_back(socket);
+    }
+
+    mListenSockets = std::move(sockets);
+    mAcceptCounts.reset(new std::atomic<uint64_t>[mListenSockets.size()]());
+    return NO_ERROR;
+}
+
+TCPSocketPtr ShardedListener::OpenShard(const SocketAddress& inAddress, bool inShouldReusePort, int* outError)
+{
+    TCPSocketPtr socket = SocketUtil::CreateTCPSocket(static_cast<SocketAddressFamily>(inAddress.GetFamily()));
+    if (!socket)
+    {
+        *outError = -SocketUtil::GetLastError();
+        return nullptr;
+    }
+
+    int result = socket->SetReuseAddress(true);
+    if (result == NO_ERROR && inShouldReusePort)
+    {
+        result = socket->SetReusePort(true);
+    }
+    if (result == NO_ERROR && mOptions.deferAcceptSeconds > 0)
+    {
+        //only an optimization, platforms without it accept early
+        socket->SetDeferAccept(mOptions.deferAcceptSeconds);
+    }
+    if (result == NO_ERROR)
+    {
+        result = socket->Bind(inAddress);
+    }
+    if (result == NO_ERROR)
+    {
+        result = socket->Listen(mOptions.backLog);
+    }
+    if (result == NO_ERROR)
+    {
+        result = socket->SetNonBlockingMode(true);
+    }
+
+    *outError = result;
+    return result == NO_ERROR ? socket : nullptr;
+}
+
+void ShardedListener::Start(AcceptCallback inCallback)
+{
+    Stop();
+    mCallback = std::move(inCallback);
+    mIsStopping = false;
+    for (size_t shard = 0; shard < mListenSockets.size(); ++shard)
+    {
+        mThreads.emplace_back(&ShardedListener::RunAcceptLoop, this, shard);
+    }
+}
+
+void ShardedListener::Stop()
+{
+    mIsStopping = true;
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+    mThreads.clear();
+}
+
+void ShardedListener::RunAcceptLoop(size_t inShard)
+{
+    const TCPSocketPtr& listenSocket = mListenSockets[inShard];
+    const vector<TCPSocketPtr> readSet{listenSocket};
+    vector<TCPSocketPtr> readable;
+    while (!mIsStopping)
+    {
+        if (SocketUtil::Select(&readSet, &readable, nullptr, nullptr, nullptr, nullptr, STOP_CHECK_INTERVAL_MS) <= 0)
+        {
+            continue;
+        }
+
+        //the whole backlog, a connection reset before it was accepted only ends the round early
+        SocketAddress address;
+        while (TCPSocketPtr socket = listenSocket->Accept(address))
+        {
+            socket->SetNonBlockingMode(false);
+            ++mAcceptCounts[inShard];
+            mCallback(inShard, socket, address);
+        }
+    }
+}
@@ -1,7 +1,24 @@
 #include "SocketWrapperShared.h"
+#if _WIN32
 #include <comdef.h>
+#endif
 #include <sstream>
 
+namespace
+{
+    //murmur3 finalizer: every input bit flips about half of the output bits,
+    //so addresses differing only in the port or the last octet land in different buckets
+    uint64_t Mix(uint64_t inValue)
+    {
+        inValue ^= inValue >> 33;
+        inValue *= 0xff51afd7ed558ccdULL;
+        inValue ^= inValue >> 33;
+        inValue *= 0xc4ceb9fe1a85ec53ULL;
+        inValue ^= inValue >> 33;
+        return inValue;
+    }
+}
+
 //SocketAddress::SocketAddress(string ipv4str, uint16_t port)
 //{
 //    sockaddr_in addr{0};
@@ -13,42 +30,90 @@
 
 SocketAddress::SocketAddress(uint32_t inAddress, uint16_t inPort)
 {
+    memset(&mSockAddr, 0, sizeof(mSockAddr));
     GetAsSockAddrIn()->sin_family = AF_INET;
-    GetIP4Ref() = htonl(inAddress);
+    GetAsSockAddrIn()->sin_addr.s_addr = htonl(inAddress);
     GetAsSockAddrIn()->sin_port = htons(inPort);
 }
 
+SocketAddress::SocketAddress(const in6_addr& inAddress, uint16_t inPort, uint32_t inScopeId)
+{
+    memset(&mSockAddr, 0, sizeof(mSockAddr));
+    GetAsSockAddrIn6()->sin6_family = AF_INET6;
+    GetAsSockAddrIn6()->sin6_addr = inAddress;
+    GetAsSockAddrIn6()->sin6_port = htons(inPort);
+    GetAsSockAddrIn6()->sin6_scope_id = inScopeId;
+}
+
 SocketAddress::SocketAddress(const sockaddr& inSockAddr)
 {
-    memcpy(&mSockAddr, &inSockAddr, sizeof(sockaddr));
+    memset(&mSockAddr, 0, sizeof(mSockAddr));
+    size_t size = inSockAddr.sa_family == AF_INET6 ? sizeof(sockaddr_in6)
+        : inSockAddr.sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr);
+    memcpy(&mSockAddr, &inSockAddr, size);
 }
 
-SocketAddress::SocketAddress()
+SocketAddress::SocketAddress(): SocketAddress(INADDR_ANY, 0)
 {
-    GetAsSockAddrIn()->sin_family = AF_INET;
-    GetIP4Ref() = INADDR_ANY;
-    GetAsSockAddrIn()->sin_port = 0;
 }
 
 bool SocketAddress::operator==(const SocketAddress& inOther) const
 {
-    return (mSockAddr.sa_family == AF_INET &&
-            GetAsSockAddrIn()->sin_port == inOther.GetAsSockAddrIn()->sin_port) &&
-        (GetIP4Ref() == inOther.GetIP4Ref());
+    if (GetFamily() != inOther.GetFamily())
+    {
+        return false;
+    }
+    if (GetFamily() == AF_INET6)
+    {
+        return GetAsSockAddrIn6()->sin6_port == inOther.GetAsSockAddrIn6()->sin6_port
+            && memcmp(&GetAsSockAddrIn6()->sin6_addr, &inOther.GetAsSockAddrIn6()->sin6_addr, sizeof(in6_addr)) == 0
+            && GetAsSockAddrIn6()->sin6_scope_id == inOther.GetAsSockAddrIn6()->sin6_scope_id;
+    }
+    if (GetFamily() == AF_INET)
+    {
+        return GetAsSockAddrIn()->sin_port == inOther.GetAsSockAddrIn()->sin_port
+            && GetIP4Ref() == inOther.GetIP4Ref();
+    }
+    return memcmp(&mSockAddr, &inOther.mSockAddr, GetSize()) == 0;
 }
 
 size_t SocketAddress::GetHash() const
 {
-    return (GetIP4Ref()) |
-        ((static_cast<uint32_t>(GetAsSockAddrIn()->sin_port)) << 13) |
-        mSockAddr.sa_family;
+    if (GetFamily() == AF_INET6)
+    {
+        const sockaddr_in6* address = GetAsSockAddrIn6();
+        uint64_t parts[2];
+        memcpy(parts, &address->sin6_addr, sizeof(parts));
+        uint64_t hash = Mix(parts[0]);
+        hash = Mix(hash ^ parts[1]);
+        return static_cast<size_t>(Mix(hash ^ address->sin6_port ^ (static_cast<uint64_t>(address->sin6_scope_id) << 16)));
+    }
+
+    const sockaddr_in* address = GetAsSockAddrIn();
+    return static_cast<size_t>(Mix((static_cast<uint64_t>(GetIP4Ref()) << 32)
+                                   | (static_cast<uint64_t>(address->sin_port) << 16)
+                                   | static_cast<uint16_t>(GetFamily())));
 }
 
 uint32_t SocketAddress::GetSize() const
 {
-    return sizeof(sockaddr);
+    switch (GetFamily())
+    {
+    case AF_INET:
+        return sizeof(sockaddr_in);
+    case AF_INET6:
+        return sizeof(sockaddr_in6);
+    default:
+        return sizeof(sockaddr_storage);
+    }
+}
+
+uint16_t SocketAddress::GetPort() const
+{
+    return ntohs(GetFamily() == AF_INET6 ? GetAsSockAddrIn6()->sin6_port : GetAsSockAddrIn()->sin_port);
 }
 
+#if _WIN32
 uint32_t& SocketAddress::GetIP4Ref()
 {
     return *reinterpret_cast<uint32_t*>(&GetAsSockAddrIn()->sin_addr.S_un.S_addr);
@@ -58,6 +123,7 @@ const uint32_t& SocketAddress::GetIP4Ref() const
 {
     return *reinterpret_cast<const uint32_t*>(&GetAsSockAddrIn()->sin_addr.S_un.S_addr);
 }
+#endif
 
 sockaddr_in* SocketAddress::GetAsSockAddrIn()
 {
@@ -69,24 +135,36 @@ const sockaddr_in* SocketAddress::GetAsSockAddrIn() const
     return reinterpret_cast<const sockaddr_in*>(&mSockAddr);
 }
 
+sockaddr_in6* SocketAddress::GetAsSockAddrIn6()
+{
+    return reinterpret_cast<sockaddr_in6*>(&mSockAddr);
+}
+
+const sockaddr_in6* SocketAddress::GetAsSockAddrIn6() const
+{
+    return reinterpret_cast<const sockaddr_in6*>(&mSockAddr);
+}
+
 string SocketAddress::ToString() const
 {
-#if _WIN32
-    const sockaddr_in* s = GetAsSockAddrIn();
-    char str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &s->sin_addr, str, INET_ADDRSTRLEN);
+    char host[INET6_ADDRSTRLEN];
     std::stringstream ss;
-    ss << str << ":" << ntohs(s->sin_port);
+    if (GetFamily() == AF_INET6)
+    {
+        const sockaddr_in6* s = GetAsSockAddrIn6();
+        inet_ntop(AF_INET6, &s->sin6_addr, host, INET6_ADDRSTRLEN);
+        ss << "[" << host;
+        if (s->sin6_scope_id != 0)
+        {
+            ss << "%" << s->sin6_scope_id;
+        }
+        ss << "]:" << ntohs(s->sin6_port);
+    }
+    else
+    {
+        const sockaddr_in* s = GetAsSockAddrIn();
+        inet_ntop(AF_INET, &s->sin_addr, host, INET6_ADDRSTRLEN);
+        ss << host << ":" << ntohs(s->sin_port);
+    }
     return ss.str();
-
-    //WCHAR destinationBuffer[ 128 ];
-    //InetNtop( s->sin_family, const_cast< in_addr* >( &s->sin_addr ), destinationBuffer, sizeof( destinationBuffer ) );
-    ////const char* destinationBufferChar = _bstr_t (destinationBuffer);
-    //return StringUtils::Sprintf( "%s:%d",
-    //       destinationBuffer,
-    //       ntohs( s->sin_port ) );
-#else
- //not implement on mac for now...
- return string( "not implemented on mac for now" );
-#endif
 }
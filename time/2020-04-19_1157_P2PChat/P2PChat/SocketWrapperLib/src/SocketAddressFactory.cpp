@@ -3,9 +3,37 @@
 
 SocketAddressPtr SocketAddressFactory::CreateIPv4FromString(const string& inString)
 {
+    vector<SocketAddress> addresses;
+    int error = CreateAllFromString(inString, addresses, AF_INET);
+    if (error != NO_ERROR || addresses.empty())
+    {
+        SocketUtil::ReportError("SocketAddressFactory::CreateIPv4FromString");
+        return nullptr;
+    }
+
+    return std::make_shared<SocketAddress>(addresses.front());
+}
+
+int SocketAddressFactory::CreateAllFromString(const string& inString, vector<SocketAddress>& outAddresses,
+                                              int inFamily)
+{
+    outAddresses.clear();
+
     auto pos = inString.find_last_of(':');
-    string host, service;
-    if (pos != string::npos)
+    //the default port, replaced where the string has one
+    string host;
+    string service = "0";
+    if (!inString.empty() && inString[0] == '[' && inString.find(']') != string::npos)
+    {
+        //[ipv6]:port, the address itself is full of colons
+        auto end = inString.find(']');
+        host = inString.substr(1, end - 1);
+        if (end + 1 < inString.size() && inString[end + 1] == ':')
+        {
+            service = inString.substr(end + 2);
+        }
+    }
+    else if (pos != string::npos)
     {
         host = inString.substr(0, pos);
         service = inString.substr(pos + 1);
@@ -13,39 +41,36 @@ SocketAddressPtr SocketAddressFactory::CreateIPv4FromString(const string& inStri
     else
     {
         host = inString;
-        //use default port...
-        service = "0";
     }
     addrinfo hint;
     memset(&hint, 0, sizeof(hint));
-    hint.ai_family = AF_INET;
+    hint.ai_family = inFamily;
+    //one entry per address instead of one per socket type
+    hint.ai_socktype = SOCK_STREAM;
 
     addrinfo* result = nullptr;
     int error = getaddrinfo(host.c_str(), service.c_str(), &hint, &result);
+#if _WIN32
     if(error == WSANOTINITIALISED)
     {
-        SocketUtil::ReportError("SocketAddressFactory::CreateIPv4FromString WSANOTINITIALISED");
-        return nullptr;        
+        SocketUtil::ReportError("SocketAddressFactory::CreateAllFromString WSANOTINITIALISED");
+        return error;
     }
-    else if (error != 0 && result != nullptr)
+#endif
+    if (error != 0)
     {
-        SocketUtil::ReportError("SocketAddressFactory::CreateIPv4FromString");
-        return nullptr;
+        return error;
     }
 
-    while (!result->ai_addr && result->ai_next)
+    for (addrinfo* info = result; info; info = info->ai_next)
     {
-        result = result->ai_next;
+        if (info->ai_addr)
+        {
+            outAddresses.emplace_back(*info->ai_addr);
+        }
     }
 
-    if (!result->ai_addr)
-    {
-        return nullptr;
-    }
-
-    auto toRet = std::make_shared<SocketAddress>(*result->ai_addr);
-
     freeaddrinfo(result);
 
-    return toRet;
+    return NO_ERROR;
 }
@@ -0,0 +1,257 @@
+#include "SocketWrapperShared.h"
+#include "SocketCoroutines.h"
+
+// Coroutine which owns a spawned task. It starts suspended, so Spawn can link it into mSpawned first,
+// and destroys itself when the task returned.
+struct SocketScheduler::SpawnedTask
+{
+    struct promise_type
+    {
+        SpawnedTask get_return_object() { return SpawnedTask{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept
+        {
+            mScheduler->mSpawned.erase(mPosition);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        SocketScheduler* mScheduler = nullptr;
+        std::list<std::coroutine_handle<>>::iterator mPosition;
+    };
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+SocketScheduler::SocketScheduler(): mPollCount(0), mIsStopping(false)
+{
+}
+
+SocketScheduler::~SocketScheduler()
+{
+    //destroying a frame destroys the tasks and AsyncSockets in it, they unregister from mPoller
+    for (std::coroutine_handle<> handle : mSpawned)
+    {
+        handle.destroy();
+    }
+}
+
+SocketScheduler::SpawnedTask SocketScheduler::RunSpawned(SocketTask<void> inTask)
+{
+    try
+    {
+        co_await inTask;
+    }
+    catch (const std::exception& inException)
+    {
+        LOG("SocketScheduler: task failed with %s", inException.what());
+    }
+}
+
+void SocketScheduler::Spawn(SocketTask<void> inTask)
+{
+    SpawnedTask spawned = RunSpawned(std::move(inTask));
+    mSpawned.push_front(spawned.mHandle);
+    spawned.mHandle.promise().mScheduler = this;
+    spawned.mHandle.promise().mPosition = mSpawned.begin();
+    mReady.push_back(spawned.mHandle);
+}
+
+int SocketScheduler::Run()
+{
+    mIsStopping = false;
+    vector<SocketPollEvent> events;
+    while (true)
+    {
+        ResumeReady();
+        if (mIsStopping || mSpawned.empty())
+        {
+            return NO_ERROR;
+        }
+
+        int result = mPoller.Wait(events, GetPollTimeout(Clock::now()));
+        if (result < 0)
+        {
+            return result;
+        }
+        ++mPollCount;
+
+        //no coroutine runs before all events are handled, so every SocketWaiters is still alive
+        for (const SocketPollEvent& event : events)
+        {
+            SocketWaiters& waiters = *static_cast<SocketWaiters*>(event.userData);
+            bool hasCompleted = false;
+            if ((event.isReadable || event.isClosed) && waiters.reader && waiters.reader->TryComplete())
+            {
+                mReady.push_back(waiters.reader->mContinuation);
+                waiters.reader = nullptr;
+                hasCompleted = true;
+            }
+            if ((event.isWritable || event.isClosed) && waiters.writer && waiters.writer->TryComplete())
+            {
+                mReady.push_back(waiters.writer->mContinuation);
+                waiters.writer = nullptr;
+                hasCompleted = true;
+            }
+            if (hasCompleted)
+            {
+                UpdateInterest(waiters);
+            }
+        }
+
+        mTimers.Advance(Clock::now());
+    }
+}
+
+void SocketScheduler::SleepOperation::await_suspend(std::coroutine_handle<> inAwaiting)
+{
+    SocketScheduler& scheduler = mScheduler;
+    scheduler.mTimers.Schedule(std::chrono::milliseconds(mMilliseconds), [&scheduler, inAwaiting]
+    {
+        scheduler.mReady.push_back(inAwaiting);
+    });
+}
+
+int SocketScheduler::Register(SocketWaiters& inWaiters)
+{
+    return mPoller.Add(inWaiters.socket, 0, &inWaiters);
+}
+
+void SocketScheduler::Unregister(SocketWaiters& inWaiters)
+{
+    mPoller.Remove(inWaiters.socket);
+}
+
+void SocketScheduler::UpdateInterest(SocketWaiters& inWaiters)
+{
+    //only what a coroutine waits for, the select fallback is level triggered and would report an idle socket forever.
+    //on epoll the modification also reports a socket which became ready before the coroutine suspended
+    int interest = (inWaiters.reader ? POLL_READ : 0) | (inWaiters.writer ? POLL_WRITE : 0);
+    mPoller.Modify(inWaiters.socket, interest, &inWaiters);
+}
+
+int SocketScheduler::GetPollTimeout(Clock::time_point inNow) const
+{
+    if (!mReady.empty())
+    {
+        return 0;
+    }
+    return mTimers.GetTimeoutMs(inNow);
+}
+
+void SocketScheduler::ResumeReady()
+{
+    //coroutines resumed now may make others ready, they run in the next round after the poller was checked
+    deque<std::coroutine_handle<>> ready;
+    ready.swap(mReady);
+    for (std::coroutine_handle<> handle : ready)
+    {
+        handle.resume();
+    }
+}
+
+AsyncSocket::AsyncSocket(SocketScheduler& inScheduler, TCPSocketPtr inSocket):
+    mScheduler(&inScheduler),
+    mWaiters(new SocketWaiters())
+{
+    if (!inSocket || inSocket->SetNonBlockingMode(true) != NO_ERROR)
+    {
+        return;
+    }
+    mWaiters->socket = inSocket;
+    if (mScheduler->Register(*mWaiters) != NO_ERROR)
+    {
+        mWaiters->socket = nullptr;
+    }
+}
+
+AsyncSocket& AsyncSocket::operator=(AsyncSocket&& inOther) noexcept
+{
+    if (this != &inOther)
+    {
+        Close();
+        mScheduler = inOther.mScheduler;
+        mWaiters = std::move(inOther.mWaiters);
+    }
+    return *this;
+}
+
+AsyncSocket::~AsyncSocket()
+{
+    Close();
+}
+
+void AsyncSocket::Close()
+{
+    if (mWaiters && mWaiters->socket)
+    {
+        mScheduler->Unregister(*mWaiters);
+    }
+    mWaiters.reset();
+}
+
+void AsyncSocket::Wait(SocketOperation& inOperation, std::coroutine_handle<> inAwaiting, bool inIsWrite)
+{
+    inOperation.mContinuation = inAwaiting;
+    (inIsWrite ? mWaiters->writer : mWaiters->reader) = &inOperation;
+    mScheduler->UpdateInterest(*mWaiters);
+}
+
+bool AsyncSocket::ReceiveOperation::TryComplete()
+{
+    mResult = mSocket.GetSocket()->Receive(mBuffer, mLength);
+    return mResult != -WSAEWOULDBLOCK;
+}
+
+bool AsyncSocket::SendOperation::TryComplete()
+{
+    while (mSent < mLength)
+    {
+        int32_t sent = mSocket.GetSocket()->Send(mData + mSent, mLength - mSent);
+        if (sent == -WSAEWOULDBLOCK)
+        {
+            return false;
+        }
+        if (sent < 0)
+        {
+            mResult = sent;
+            return true;
+        }
+        mSent += sent;
+    }
+    mResult = static_cast<int32_t>(mSent);
+    return true;
+}
+
+bool AsyncSocket::AcceptOperation::TryComplete()
+{
+    mAccepted = mSocket.GetSocket()->Accept(mAddress);
+    if (!mAccepted)
+    {
+        int error = SocketUtil::GetLastError();
+        if (error == WSAEWOULDBLOCK)
+        {
+            return false;
+        }
+        mError = -error;
+    }
+    return true;
+}
+
+AsyncSocket AsyncSocket::AcceptOperation::await_resume()
+{
+    return mAccepted ? AsyncSocket(*mSocket.mScheduler, mAccepted) : AsyncSocket();
+}
+
+bool AsyncSocket::ConnectOperation::await_ready()
+{
+    mResult = mSocket.GetSocket()->StartConnect(mAddress);
+    return mResult != -WSAEWOULDBLOCK;
+}
+
+bool AsyncSocket::ConnectOperation::TryComplete()
+{
+    mResult = mSocket.GetSocket()->GetConnectResult();
+    return true;
+}
@@ -0,0 +1,72 @@
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    thread_local const SocketErrorCallBack* tCurrentCallBack = nullptr;
+}
+
+SocketErrorLog::SocketErrorLog(): mNextIndex(0)
+{
+    for (Slot& slot : mSlots)
+    {
+        slot.sequence.store(0, std::memory_order_relaxed);
+        slot.operation.store(nullptr, std::memory_order_relaxed);
+        slot.error.store(NO_ERROR, std::memory_order_relaxed);
+        slot.time.store(0, std::memory_order_relaxed);
+    }
+}
+
+void SocketErrorLog::Add(const char* inOperation, int inError)
+{
+    uint64_t index = mNextIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = mSlots[index % CAPACITY];
+
+    //a sequence lock: readers which see 0 or another index before or after copying drop the entry
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.operation.store(inOperation, std::memory_order_relaxed);
+    slot.error.store(inError, std::memory_order_relaxed);
+    slot.time.store(std::chrono::system_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void SocketErrorLog::GetRecent(vector<SocketError>& outErrors) const
+{
+    outErrors.clear();
+    uint64_t end = mNextIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    for (uint64_t index = begin; index < end; ++index)
+    {
+        const Slot& slot = mSlots[index % CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+        {
+            continue;
+        }
+
+        SocketError entry;
+        entry.operation = slot.operation.load(std::memory_order_relaxed);
+        entry.error = slot.error.load(std::memory_order_relaxed);
+        entry.time = std::chrono::system_clock::time_point(
+            std::chrono::system_clock::duration(slot.time.load(std::memory_order_relaxed)));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == index + 1)
+        {
+            outErrors.push_back(entry);
+        }
+    }
+}
+
+SocketErrorScope::SocketErrorScope(const SocketErrorCallBack& inCallBack): mPrevious(tCurrentCallBack)
+{
+    tCurrentCallBack = &inCallBack;
+}
+
+SocketErrorScope::~SocketErrorScope()
+{
+    tCurrentCallBack = mPrevious;
+}
+
+const SocketErrorCallBack* SocketErrorScope::GetCurrentCallBack()
+{
+    return tCurrentCallBack;
+}
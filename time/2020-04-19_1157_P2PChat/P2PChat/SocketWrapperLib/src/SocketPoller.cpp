@@ -0,0 +1,207 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+#ifdef __linux__
+
+namespace
+{
+    const size_t INITIAL_READY_EVENTS = 64;
+
+    uint32_t ToEpollEvents(int inInterest)
+    {
+        uint32_t events = EPOLLET | EPOLLRDHUP;
+        if (inInterest & POLL_READ)
+        {
+            events |= EPOLLIN;
+        }
+        if (inInterest & POLL_WRITE)
+        {
+            events |= EPOLLOUT;
+        }
+        return events;
+    }
+}
+
+SocketPoller::SocketPoller(): mEpoll(epoll_create1(EPOLL_CLOEXEC)), mReadyEvents(INITIAL_READY_EVENTS)
+{
+    if (mEpoll < 0)
+    {
+        SocketUtil::ReportError("SocketPoller::SocketPoller");
+    }
+}
+
+SocketPoller::~SocketPoller()
+{
+    if (mEpoll >= 0)
+    {
+        close(mEpoll);
+    }
+}
+
+int SocketPoller::Control(int inOperation, SOCKET inSocket, int inInterest, void* inUserData)
+{
+    epoll_event event{};
+    event.events = ToEpollEvents(inInterest);
+    event.data.ptr = inUserData;
+
+    if (epoll_ctl(mEpoll, inOperation, inSocket, &event) < 0)
+    {
+        SocketUtil::ReportError("SocketPoller::Control");
+        return -SocketUtil::GetLastError();
+    }
+    return NO_ERROR;
+}
+
+int SocketPoller::Add(const TCPSocketPtr& inSocket, int inInterest, void* inUserData)
+{
+    return Control(EPOLL_CTL_ADD, inSocket->mSocket, inInterest, inUserData);
+}
+
+int SocketPoller::Modify(const TCPSocketPtr& inSocket, int inInterest, void* inUserData)
+{
+    return Control(EPOLL_CTL_MOD, inSocket->mSocket, inInterest, inUserData);
+}
+
+int SocketPoller::Remove(const TCPSocketPtr& inSocket)
+{
+    return Control(EPOLL_CTL_DEL, inSocket->mSocket, 0, nullptr);
+}
+
+int SocketPoller::Wait(vector<SocketPollEvent>& outEvents, int inTimeoutMs)
+{
+    outEvents.clear();
+
+    int readyCount = epoll_wait(mEpoll, mReadyEvents.data(), static_cast<int>(mReadyEvents.size()), inTimeoutMs);
+    if (readyCount < 0)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        SocketUtil::ReportError("SocketPoller::Wait");
+        return -SocketUtil::GetLastError();
+    }
+
+    for (int i = 0; i < readyCount; ++i)
+    {
+        const epoll_event& event = mReadyEvents[i];
+        SocketPollEvent pollEvent;
+        pollEvent.userData = event.data.ptr;
+        pollEvent.isReadable = (event.events & EPOLLIN) != 0;
+        pollEvent.isWritable = (event.events & EPOLLOUT) != 0;
+        pollEvent.isClosed = (event.events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) != 0;
+        outEvents.push_back(pollEvent);
+    }
+
+    //the buffer was too small, the rest of the events will be delivered by the next call
+    if (readyCount == static_cast<int>(mReadyEvents.size()))
+    {
+        mReadyEvents.resize(mReadyEvents.size() * 2);
+    }
+
+    return readyCount;
+}
+
+#else
+
+SocketPoller::SocketPoller()
+{
+}
+
+SocketPoller::~SocketPoller()
+{
+}
+
+int SocketPoller::Add(const TCPSocketPtr& inSocket, int inInterest, void* inUserData)
+{
+    //FD_SET ignores a socket past the end of the set, it would be registered but never reported
+#if _WIN32
+    bool isFull = mRegistrations.size() >= FD_SETSIZE;
+#else
+    bool isFull = inSocket->mSocket >= FD_SETSIZE;
+#endif
+    if (isFull)
+    {
+        return -WSAEMFILE;
+    }
+    mRegistrations[inSocket->mSocket] = Registration{inInterest, inUserData};
+    return NO_ERROR;
+}
+
+int SocketPoller::Modify(const TCPSocketPtr& inSocket, int inInterest, void* inUserData)
+{
+    auto registration = mRegistrations.find(inSocket->mSocket);
+    if (registration == mRegistrations.end())
+    {
+        return -WSAEINVAL;
+    }
+    registration->second = Registration{inInterest, inUserData};
+    return NO_ERROR;
+}
+
+int SocketPoller::Remove(const TCPSocketPtr& inSocket)
+{
+    mRegistrations.erase(inSocket->mSocket);
+    return NO_ERROR;
+}
+
+int SocketPoller::Wait(vector<SocketPollEvent>& outEvents, int inTimeoutMs)
+{
+    outEvents.clear();
+
+    fd_set read, write, except;
+    FD_ZERO(&read);
+    FD_ZERO(&write);
+    FD_ZERO(&except);
+
+    int nfds = 0;
+    for (const auto& registration : mRegistrations)
+    {
+        SOCKET socket = registration.first;
+        if (registration.second.interest & POLL_READ)
+        {
+            FD_SET(socket, &read);
+        }
+        if (registration.second.interest & POLL_WRITE)
+        {
+            FD_SET(socket, &write);
+        }
+        FD_SET(socket, &except);
+#if !_WIN32
+        nfds = std::max(nfds, socket);
+#endif
+    }
+
+    timeval timeout;
+    timeout.tv_sec = inTimeoutMs / 1000;
+    timeout.tv_usec = (inTimeoutMs % 1000) * 1000;
+
+    int toRet = select(nfds + 1, &read, &write, &except, inTimeoutMs < 0 ? nullptr : &timeout);
+    if (toRet < 0)
+    {
+        SocketUtil::ReportError("SocketPoller::Wait");
+        return -SocketUtil::GetLastError();
+    }
+
+    if (toRet > 0)
+    {
+        for (const auto& registration : mRegistrations)
+        {
+            SOCKET socket = registration.first;
+            SocketPollEvent pollEvent;
+            pollEvent.userData = registration.second.userData;
+            pollEvent.isReadable = FD_ISSET(socket, &read) != 0;
+            pollEvent.isWritable = FD_ISSET(socket, &write) != 0;
+            pollEvent.isClosed = FD_ISSET(socket, &except) != 0;
+            if (pollEvent.isReadable || pollEvent.isWritable || pollEvent.isClosed)
+            {
+                outEvents.push_back(pollEvent);
+            }
+        }
+    }
+
+    return static_cast<int>(outEvents.size());
+}
+
+#endif
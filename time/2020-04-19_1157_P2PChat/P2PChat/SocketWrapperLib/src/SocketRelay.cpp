@@ -0,0 +1,296 @@
+#include "SocketWrapperShared.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#elif _WIN32
+#include <io.h>
+#endif
+
+namespace
+{
+    //larger sendfile calls are split, the count has to fit into the return value
+    const size_t MAX_SENDFILE_LENGTH = 1 << 30;
+
+    // Copy buffers shared by all relays of the process, never destroyed like BufferPool::GetDefault.
+    BufferPool& GetBufferPool()
+    {
+        static BufferPool* pool = new BufferPool(SocketRelay::CHUNK_SIZE, 16, 4);
+        return *pool;
+    }
+
+    // pread where the platform has it
+    int64_t ReadAt(int inFile, char* outBuffer, size_t inLength, int64_t inOffset)
+    {
+#if _WIN32
+        if (_lseeki64(inFile, inOffset, SEEK_SET) < 0)
+        {
+            return -1;
+        }
+        return _read(inFile, outBuffer, static_cast<unsigned int>(inLength));
+#else
+        return pread(inFile, outBuffer, inLength, static_cast<off_t>(inOffset));
+#endif
+    }
+}
+
+SocketRelay::SocketRelay(bool inIsCopyForced):
+#ifdef __linux__
+    mIsCopying(inIsCopyForced),
+    mIsFileCopying(inIsCopyForced),
+#else
+    mIsCopying(true),
+    mIsFileCopying(true),
+#endif
+    mPipe{-1, -1},
+    mBufferOffset(0),
+    mPendingLength(0),
+    mZeroCopyBytes(0),
+    mCopiedBytes(0)
+{
+}
+
+SocketRelay::~SocketRelay()
+{
+#ifdef __linux__
+    if (mPipe[0] >= 0)
+    {
+        close(mPipe[0]);
+        close(mPipe[1]);
+    }
+#endif
+    ReleaseBuffer();
+}
+
+bool SocketRelay::OpenPipe()
+{
+#ifdef __linux__
+    if (mPipe[0] >= 0)
+    {
+        return true;
+    }
+    //non-blocking, so a full pipe returns instead of waiting for a reader on the same thread;
+    //the sockets keep their own blocking mode
+    if (pipe2(mPipe, O_NONBLOCK | O_CLOEXEC) < 0)
+    {
+        SocketUtil::ReportError("SocketRelay::OpenPipe");
+        mPipe[0] = mPipe[1] = -1;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+int32_t SocketRelay::Forward(const TCPSocketPtr& inFrom, const TCPSocketPtr& inTo, size_t inMaxLength)
+{
+    //without descriptors left for the pipe the relay copies from now on
+    if (!mIsCopying && mPendingLength == 0 && !OpenPipe())
+    {
+        mIsCopying = true;
+    }
+
+    int64_t forwardedLength = 0;
+    while (true)
+    {
+        if (mPendingLength > 0)
+        {
+            int result = mIsCopying ? DrainBuffer(inTo) : DrainPipe(inTo);
+            if (result < 0)
+            {
+                return forwardedLength > 0 ? static_cast<int32_t>(forwardedLength) : result;
+            }
+            forwardedLength += result;
+        }
+
+        //a blocking source would wait for more data, so it gets one round per call
+        bool isDone = !inFrom->mIsNonBlocking && forwardedLength > 0;
+        if (isDone || forwardedLength > INT32_MAX - static_cast<int64_t>(CHUNK_SIZE))
+        {
+            return static_cast<int32_t>(forwardedLength);
+        }
+
+        int result = mIsCopying ? FillBuffer(inFrom, inMaxLength) : FillPipe(inFrom, inMaxLength);
+        if (result <= 0)
+        {
+            return forwardedLength > 0 ? static_cast<int32_t>(forwardedLength) : result;
+        }
+    }
+}
+
+int SocketRelay::FillPipe(const TCPSocketPtr& inFrom, size_t inMaxLength)
+{
+#ifdef __linux__
+    ssize_t movedLength = splice(inFrom->mSocket, nullptr, mPipe[1], nullptr, std::min(inMaxLength, CHUNK_SIZE), SPLICE_F_MOVE);
+    if (movedLength < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        //the socket does not support splice, it is copied from now on
+        if (error == EINVAL)
+        {
+            close(mPipe[0]);
+            close(mPipe[1]);
+            mPipe[0] = mPipe[1] = -1;
+            mIsCopying = true;
+            return FillBuffer(inFrom, inMaxLength);
+        }
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("SocketRelay::Forward");
+        }
+        return -error;
+    }
+    mPendingLength = static_cast<size_t>(movedLength);
+    return static_cast<int>(movedLength);
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int SocketRelay::DrainPipe(const TCPSocketPtr& inTo)
+{
+#ifdef __linux__
+    int drainedLength = 0;
+    while (mPendingLength > 0)
+    {
+        ssize_t movedLength = splice(mPipe[0], nullptr, inTo->mSocket, nullptr, mPendingLength, SPLICE_F_MOVE);
+        if (movedLength < 0)
+        {
+            int error = SocketUtil::GetLastError();
+            //the pipe has data, so only the target can be full
+            if (error != WSAEWOULDBLOCK)
+            {
+                SocketUtil::ReportError("SocketRelay::Forward");
+            }
+            return drainedLength > 0 ? drainedLength : -error;
+        }
+        mPendingLength -= movedLength;
+        mZeroCopyBytes += movedLength;
+        drainedLength += static_cast<int>(movedLength);
+    }
+    return drainedLength;
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int SocketRelay::FillBuffer(const TCPSocketPtr& inFrom, size_t inMaxLength)
+{
+    if (!mBuffer)
+    {
+        mBuffer = GetBufferPool().Acquire();
+    }
+    int receivedLength = inFrom->Receive(mBuffer->GetData(), std::min(inMaxLength, CHUNK_SIZE));
+    if (receivedLength <= 0)
+    {
+        ReleaseBuffer();
+        return receivedLength;
+    }
+    mBufferOffset = 0;
+    mPendingLength = static_cast<size_t>(receivedLength);
+    return receivedLength;
+}
+
+int SocketRelay::DrainBuffer(const TCPSocketPtr& inTo)
+{
+    int drainedLength = 0;
+    while (mPendingLength > 0)
+    {
+        int sentLength = inTo->Send(mBuffer->GetData() + mBufferOffset, mPendingLength);
+        if (sentLength < 0)
+        {
+            return drainedLength > 0 ? drainedLength : sentLength;
+        }
+        mBufferOffset += sentLength;
+        mPendingLength -= sentLength;
+        mCopiedBytes += sentLength;
+        drainedLength += sentLength;
+    }
+    //an idle relay gives its buffer back
+    ReleaseBuffer();
+    return drainedLength;
+}
+
+int64_t SocketRelay::SendFile(int inFile, int64_t& ioOffset, size_t inLength, const TCPSocketPtr& inTo)
+{
+#ifdef __linux__
+    if (!mIsFileCopying)
+    {
+        int64_t sentLength = 0;
+        while (static_cast<size_t>(sentLength) < inLength)
+        {
+            off_t offset = static_cast<off_t>(ioOffset);
+            ssize_t result = sendfile(inTo->mSocket, inFile, &offset, std::min(inLength - sentLength, MAX_SENDFILE_LENGTH));
+            if (result < 0)
+            {
+                int error = SocketUtil::GetLastError();
+                //the file can not be mapped into the socket, e.g. a pipe or a special file system
+                if ((error == EINVAL || error == ENOSYS) && sentLength == 0)
+                {
+                    mIsFileCopying = true;
+                    return CopyFile(inFile, ioOffset, inLength, inTo);
+                }
+                if (error != WSAEWOULDBLOCK)
+                {
+                    SocketUtil::ReportError("SocketRelay::SendFile");
+                }
+                return sentLength > 0 ? sentLength : -error;
+            }
+            //end of the file
+            if (result == 0)
+            {
+                break;
+            }
+            ioOffset = offset;
+            sentLength += result;
+            mZeroCopyBytes += result;
+        }
+        return sentLength;
+    }
+#endif
+    return CopyFile(inFile, ioOffset, inLength, inTo);
+}
+
+int64_t SocketRelay::CopyFile(int inFile, int64_t& ioOffset, size_t inLength, const TCPSocketPtr& inTo)
+{
+    PooledBufferPtr pooledBuffer = GetBufferPool().Acquire();
+    char* buffer = pooledBuffer->GetData();
+    int64_t sentLength = 0;
+    while (static_cast<size_t>(sentLength) < inLength)
+    {
+        int64_t readLength = ReadAt(inFile, buffer, std::min(inLength - sentLength, CHUNK_SIZE), ioOffset);
+        if (readLength < 0)
+        {
+            SocketUtil::ReportError("SocketRelay::SendFile");
+            int error = SocketUtil::GetLastError();
+            return sentLength > 0 ? sentLength : -error;
+        }
+        if (readLength == 0)
+        {
+            break;
+        }
+
+        //what the socket did not take is read again by the next call
+        int chunkSentLength = 0;
+        while (chunkSentLength < readLength)
+        {
+            int result = inTo->Send(buffer + chunkSentLength, static_cast<size_t>(readLength - chunkSentLength));
+            if (result < 0)
+            {
+                return sentLength > 0 ? sentLength : result;
+            }
+            chunkSentLength += result;
+            ioOffset += result;
+            sentLength += result;
+            mCopiedBytes += result;
+        }
+    }
+    return sentLength;
+}
+
+void SocketRelay::ReleaseBuffer()
+{
+    mBuffer.Reset();
+    mBufferOffset = 0;
+}
@@ -0,0 +1,531 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+#ifdef __linux__
+
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+namespace
+{
+    const uint16_t BUFFER_GROUP = 0;
+    const uint64_t CANCEL_USER_DATA = ~0ULL;
+    // multishot receive appeared in 6.0, it can not be probed like an opcode
+    const int MIN_KERNEL_MAJOR = 6;
+
+    template <typename T>
+    T* MapOffset(void* inMap, uint32_t inOffset)
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(inMap) + inOffset);
+    }
+
+    bool IsKernelRecentEnough()
+    {
+        utsname name;
+        if (uname(&name) != 0)
+        {
+            return false;
+        }
+        int major = 0;
+        return sscanf(name.release, "%d", &major) == 1 && major >= MIN_KERNEL_MAJOR;
+    }
+
+    uint32_t RoundUpToPowerOfTwo(uint32_t inValue)
+    {
+        uint32_t result = 1;
+        while (result < inValue)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+bool SocketRing::IsSupported()
+{
+    static const bool isSupported = Create(8, 8, 64) != nullptr;
+    return isSupported;
+}
+
+SocketRingPtr SocketRing::Create(uint32_t inQueueDepth, uint32_t inBufferCount, uint32_t inBufferSize)
+{
+    SocketRingPtr ring(new SocketRing());
+    if (!ring->Init(inQueueDepth, inBufferCount, inBufferSize))
+    {
+        return nullptr;
+    }
+    return ring;
+}
+
+SocketRing::SocketRing():
+    mRing(-1),
+    mSubmissionMap(MAP_FAILED), mSubmissionMapSize(0),
+    mSubmissionHead(nullptr), mSubmissionTail(nullptr), mSubmissionMask(0), mSubmissionArray(nullptr),
+    mSubmissionEntries(static_cast<io_uring_sqe*>(MAP_FAILED)), mSubmissionEntriesSize(0),
+    mLocalTail(0), mToSubmit(0),
+    mCompletionMap(MAP_FAILED), mCompletionMapSize(0),
+    mCompletionHead(nullptr), mCompletionTail(nullptr), mCompletionMask(0), mCompletionEntries(nullptr),
+    mBufferRing(static_cast<io_uring_buf_ring*>(MAP_FAILED)), mBufferRingSize(0),
+    mBufferCount(0), mBufferSize(0)
+{
+}
+
+SocketRing::~SocketRing()
+{
+    //closing the ring cancels everything which is still in flight
+    if (mRing >= 0)
+    {
+        close(mRing);
+    }
+    if (mBufferRing != MAP_FAILED)
+    {
+        munmap(mBufferRing, mBufferRingSize);
+    }
+    if (mSubmissionEntries != MAP_FAILED)
+    {
+        munmap(mSubmissionEntries, mSubmissionEntriesSize);
+    }
+    if (mCompletionMap != MAP_FAILED && mCompletionMap != mSubmissionMap)
+    {
+        munmap(mCompletionMap, mCompletionMapSize);
+    }
+    if (mSubmissionMap != MAP_FAILED)
+    {
+        munmap(mSubmissionMap, mSubmissionMapSize);
+    }
+}
+
+bool SocketRing::Init(uint32_t inQueueDepth, uint32_t inBufferCount, uint32_t inBufferSize)
+{
+    if (!IsKernelRecentEnough())
+    {
+        return false;
+    }
+
+    //multishot requests produce many completions per submission, so the completion queue is larger
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = inQueueDepth * 4;
+    mRing = static_cast<int>(syscall(__NR_io_uring_setup, inQueueDepth, &params));
+    if (mRing < 0)
+    {
+        return false;
+    }
+
+    const uint32_t requiredFeatures = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & requiredFeatures) != requiredFeatures)
+    {
+        return false;
+    }
+
+    mSubmissionMapSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    mCompletionMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (isSingleMap)
+    {
+        mSubmissionMapSize = mCompletionMapSize = std::max(mSubmissionMapSize, mCompletionMapSize);
+    }
+
+    mSubmissionMap = mmap(nullptr, mSubmissionMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          mRing, IORING_OFF_SQ_RING);
+    if (mSubmissionMap == MAP_FAILED)
+    {
+        return false;
+    }
+    mCompletionMap = isSingleMap ? mSubmissionMap :
+        mmap(nullptr, mCompletionMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             mRing, IORING_OFF_CQ_RING);
+    if (mCompletionMap == MAP_FAILED)
+    {
+        return false;
+    }
+    mSubmissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+    mSubmissionEntries = static_cast<io_uring_sqe*>(mmap(nullptr, mSubmissionEntriesSize, PROT_READ | PROT_WRITE,
+                                                         MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES));
+    if (mSubmissionEntries == MAP_FAILED)
+    {
+        return false;
+    }
+
+    mSubmissionHead = MapOffset<uint32_t>(mSubmissionMap, params.sq_off.head);
+    mSubmissionTail = MapOffset<uint32_t>(mSubmissionMap, params.sq_off.tail);
+    mSubmissionMask = *MapOffset<uint32_t>(mSubmissionMap, params.sq_off.ring_mask);
+    mSubmissionArray = MapOffset<uint32_t>(mSubmissionMap, params.sq_off.array);
+    mCompletionHead = MapOffset<uint32_t>(mCompletionMap, params.cq_off.head);
+    mCompletionTail = MapOffset<uint32_t>(mCompletionMap, params.cq_off.tail);
+    mCompletionMask = *MapOffset<uint32_t>(mCompletionMap, params.cq_off.ring_mask);
+    mCompletionEntries = MapOffset<io_uring_cqe>(mCompletionMap, params.cq_off.cqes);
+    mLocalTail = *mSubmissionTail;
+
+    //entries are always taken in order, so the indirection array is the identity
+    for (uint32_t i = 0; i < params.sq_entries; ++i)
+    {
+        mSubmissionArray[i] = i;
+    }
+
+    //opcodes are probed, flags of the opcodes are covered by the kernel version check
+    vector<char> probeMemory(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+    if (syscall(__NR_io_uring_register, mRing, IORING_REGISTER_PROBE, probe, 256) < 0)
+    {
+        return false;
+    }
+    for (int op : {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL})
+    {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+        {
+            return false;
+        }
+    }
+
+    //buffer ids are 16 bit and the ring size must be a power of two
+    mBufferCount = std::min(RoundUpToPowerOfTwo(inBufferCount), 32768u);
+    mBufferSize = inBufferSize;
+    mBufferRingSize = mBufferCount * sizeof(io_uring_buf);
+    mBufferRing = static_cast<io_uring_buf_ring*>(mmap(nullptr, mBufferRingSize, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (mBufferRing == MAP_FAILED)
+    {
+        return false;
+    }
+
+    io_uring_buf_reg bufferRegistration;
+    memset(&bufferRegistration, 0, sizeof(bufferRegistration));
+    bufferRegistration.ring_addr = reinterpret_cast<uint64_t>(mBufferRing);
+    bufferRegistration.ring_entries = mBufferCount;
+    bufferRegistration.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, mRing, IORING_REGISTER_PBUF_RING, &bufferRegistration, 1) < 0)
+    {
+        return false;
+    }
+
+    mBuffers.resize(static_cast<size_t>(mBufferCount) * mBufferSize);
+    for (uint32_t i = 0; i < mBufferCount; ++i)
+    {
+        mUsedBuffers.push_back(static_cast<uint16_t>(i));
+    }
+    RecycleBuffers();
+
+    return true;
+}
+
+io_uring_sqe* SocketRing::GetSubmissionEntry()
+{
+    uint32_t entryCount = mSubmissionMask + 1;
+    if (mLocalTail - __atomic_load_n(mSubmissionHead, __ATOMIC_ACQUIRE) >= entryCount)
+    {
+        //the queue is full, pass what is there to the kernel first
+        Submit();
+        if (mLocalTail - __atomic_load_n(mSubmissionHead, __ATOMIC_ACQUIRE) >= entryCount)
+        {
+            return nullptr;
+        }
+    }
+
+    io_uring_sqe* entry = &mSubmissionEntries[mLocalTail & mSubmissionMask];
+    memset(entry, 0, sizeof(io_uring_sqe));
+    ++mLocalTail;
+    ++mToSubmit;
+    return entry;
+}
+
+uint32_t SocketRing::AddOperation(SocketCompletionType inType, const TCPSocketPtr& inSocket, void* inUserData)
+{
+    if (mFreeOperations.empty())
+    {
+        mFreeOperations.push_back(static_cast<uint32_t>(mOperations.size()));
+        mOperations.emplace_back();
+    }
+    uint32_t index = mFreeOperations.back();
+    mFreeOperations.pop_back();
+
+    Operation& operation = mOperations[index];
+    operation.type = inType;
+    operation.userData = inUserData;
+    operation.socket = inSocket;
+    return index;
+}
+
+int SocketRing::Accept(const TCPSocketPtr& inListenSocket, void* inUserData)
+{
+    io_uring_sqe* entry = GetSubmissionEntry();
+    if (!entry)
+    {
+        return -EBUSY;
+    }
+
+    entry->opcode = IORING_OP_ACCEPT;
+    entry->fd = inListenSocket->mSocket;
+    entry->ioprio = IORING_ACCEPT_MULTISHOT;
+    entry->accept_flags = SOCK_CLOEXEC;
+    entry->user_data = AddOperation(COMPLETION_ACCEPT, inListenSocket, inUserData);
+    return NO_ERROR;
+}
+
+void SocketRing::PrepareReceive(uint32_t inOperation)
+{
+    io_uring_sqe* entry = GetSubmissionEntry();
+    if (!entry)
+    {
+        mStarvedReceives.push_back(inOperation);
+        return;
+    }
+
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = mOperations[inOperation].socket->mSocket;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = BUFFER_GROUP;
+    entry->user_data = inOperation;
+}
+
+int SocketRing::Receive(const TCPSocketPtr& inSocket, void* inUserData)
+{
+    PrepareReceive(AddOperation(COMPLETION_RECEIVE, inSocket, inUserData));
+    return NO_ERROR;
+}
+
+int SocketRing::Send(const TCPSocketPtr& inSocket, const void* inData, size_t inLen, void* inUserData)
+{
+    io_uring_sqe* entry = GetSubmissionEntry();
+    if (!entry)
+    {
+        return -EBUSY;
+    }
+
+    entry->opcode = IORING_OP_SEND;
+    entry->fd = inSocket->mSocket;
+    entry->addr = reinterpret_cast<uint64_t>(inData);
+    entry->len = static_cast<uint32_t>(inLen);
+    entry->msg_flags = MSG_NOSIGNAL;
+    entry->user_data = AddOperation(COMPLETION_SEND, inSocket, inUserData);
+    return NO_ERROR;
+}
+
+int SocketRing::Cancel(const TCPSocketPtr& inSocket)
+{
+    //receives waiting for buffers are not in the kernel, so they are cancelled here
+    for (auto it = mStarvedReceives.begin(); it != mStarvedReceives.end();)
+    {
+        if (mOperations[*it].socket == inSocket)
+        {
+            mCancelledReceives.push_back(*it);
+            it = mStarvedReceives.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    io_uring_sqe* entry = GetSubmissionEntry();
+    if (!entry)
+    {
+        return -EBUSY;
+    }
+
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = inSocket->mSocket;
+    entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    entry->user_data = CANCEL_USER_DATA;
+    return NO_ERROR;
+}
+
+void SocketRing::RecycleBuffers()
+{
+    if (!mUsedBuffers.empty())
+    {
+        //the entries start at the beginning of the ring, the bufs member is shifted when compiled as C++
+        io_uring_buf* entries = reinterpret_cast<io_uring_buf*>(mBufferRing);
+        uint16_t tail = mBufferRing->tail;
+        uint32_t mask = mBufferCount - 1;
+        for (uint16_t bufferId : mUsedBuffers)
+        {
+            io_uring_buf& buffer = entries[tail & mask];
+            buffer.addr = reinterpret_cast<uint64_t>(&mBuffers[static_cast<size_t>(bufferId) * mBufferSize]);
+            buffer.len = mBufferSize;
+            buffer.bid = bufferId;
+            ++tail;
+        }
+        __atomic_store_n(&mBufferRing->tail, tail, __ATOMIC_RELEASE);
+        mUsedBuffers.clear();
+    }
+
+    if (!mStarvedReceives.empty())
+    {
+        vector<uint32_t> starved;
+        starved.swap(mStarvedReceives);
+        for (uint32_t operation : starved)
+        {
+            PrepareReceive(operation);
+        }
+    }
+}
+
+int SocketRing::Enter(uint32_t inToSubmit, uint32_t inMinComplete, int inTimeoutMs)
+{
+    __atomic_store_n(mSubmissionTail, mLocalTail, __ATOMIC_RELEASE);
+
+    uint32_t flags = 0;
+    __kernel_timespec timeout;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (inMinComplete > 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if (inTimeoutMs >= 0)
+        {
+            timeout.tv_sec = inTimeoutMs / 1000;
+            timeout.tv_nsec = (inTimeoutMs % 1000) * 1000000LL;
+            arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        }
+    }
+
+    long submitted = syscall(__NR_io_uring_enter, mRing, inToSubmit, inMinComplete, flags, &arg, sizeof(arg));
+    if (submitted < 0)
+    {
+        //timeout, signal or full completion queue only mean that there is nothing to wait for right now
+        if (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN)
+        {
+            return NO_ERROR;
+        }
+        SocketUtil::ReportError("SocketRing::Enter");
+        return -SocketUtil::GetLastError();
+    }
+
+    mToSubmit -= std::min(mToSubmit, static_cast<uint32_t>(submitted));
+    return NO_ERROR;
+}
+
+int SocketRing::Submit()
+{
+    if (mToSubmit == 0)
+    {
+        return NO_ERROR;
+    }
+    return Enter(mToSubmit, 0, -1);
+}
+
+int SocketRing::Wait(vector<SocketCompletion>& outCompletions, int inTimeoutMs)
+{
+    outCompletions.clear();
+
+    //the data of the previous completions is not used any more
+    RecycleBuffers();
+
+    for (uint32_t index : mCancelledReceives)
+    {
+        Operation& operation = mOperations[index];
+        outCompletions.push_back({operation.type, operation.userData, -ECANCELED, nullptr, nullptr, true});
+        operation.socket.reset();
+        mFreeOperations.push_back(index);
+    }
+    mCancelledReceives.clear();
+
+    uint32_t head = *mCompletionHead;
+    bool isReady = !outCompletions.empty() || head != __atomic_load_n(mCompletionTail, __ATOMIC_ACQUIRE);
+    int error = Enter(mToSubmit, isReady ? 0 : 1, inTimeoutMs);
+    if (error != NO_ERROR)
+    {
+        return error;
+    }
+
+    uint32_t tail = __atomic_load_n(mCompletionTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe& entry = mCompletionEntries[head & mCompletionMask];
+        if (entry.user_data == CANCEL_USER_DATA)
+        {
+            continue;
+        }
+
+        uint32_t index = static_cast<uint32_t>(entry.user_data);
+        Operation& operation = mOperations[index];
+        bool isFinal = !(entry.flags & IORING_CQE_F_MORE);
+        SocketCompletion completion{operation.type, operation.userData, entry.res, nullptr, nullptr, isFinal};
+
+        if (operation.type == COMPLETION_ACCEPT && entry.res >= 0)
+        {
+            completion.acceptedSocket = TCPSocketPtr(new TCPSocket(entry.res));
+        }
+        else if (operation.type == COMPLETION_RECEIVE)
+        {
+            if (entry.flags & IORING_CQE_F_BUFFER)
+            {
+                uint16_t bufferId = static_cast<uint16_t>(entry.flags >> IORING_CQE_BUFFER_SHIFT);
+                completion.data = &mBuffers[static_cast<size_t>(bufferId) * mBufferSize];
+                mUsedBuffers.push_back(bufferId);
+            }
+            else if (entry.res == -ENOBUFS && isFinal)
+            {
+                //the reader is slower than the peers, restart when buffers come back
+                mStarvedReceives.push_back(index);
+                continue;
+            }
+        }
+
+        outCompletions.push_back(std::move(completion));
+        if (isFinal)
+        {
+            operation.socket.reset();
+            mFreeOperations.push_back(index);
+        }
+    }
+    __atomic_store_n(mCompletionHead, head, __ATOMIC_RELEASE);
+
+    return static_cast<int>(outCompletions.size());
+}
+
+#else
+
+bool SocketRing::IsSupported()
+{
+    return false;
+}
+
+SocketRingPtr SocketRing::Create(uint32_t, uint32_t, uint32_t)
+{
+    return nullptr;
+}
+
+SocketRing::~SocketRing()
+{
+}
+
+int SocketRing::Accept(const TCPSocketPtr&, void*)
+{
+    return SOCKET_ERROR;
+}
+
+int SocketRing::Receive(const TCPSocketPtr&, void*)
+{
+    return SOCKET_ERROR;
+}
+
+int SocketRing::Send(const TCPSocketPtr&, const void*, size_t, void*)
+{
+    return SOCKET_ERROR;
+}
+
+int SocketRing::Cancel(const TCPSocketPtr&)
+{
+    return SOCKET_ERROR;
+}
+
+int SocketRing::Submit()
+{
+    return SOCKET_ERROR;
+}
+
+int SocketRing::Wait(vector<SocketCompletion>&, int)
+{
+    return SOCKET_ERROR;
+}
+
+#endif
@@ -1,8 +1,14 @@
-#include <sstream>
+#include <chrono>
 
 #include "SocketWrapperShared.h"
 
-std::function<void(std::string)> SocketUtil::m_errorCallBack;
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+SocketErrorCallBack SocketUtil::m_errorCallBack;
+SocketErrorLog SocketUtil::m_errorLog;
 
 bool SocketUtil::StaticInit()
 {
@@ -25,7 +31,7 @@ void SocketUtil::CleanUp()
 #endif
 }
 
-void SocketUtil::SetErrorCallBack(std::function<void(std::string)> errorCallback)
+void SocketUtil::SetErrorCallBack(SocketErrorCallBack errorCallback)
 {
     m_errorCallBack = errorCallback;
 }
@@ -33,30 +39,26 @@ void SocketUtil::SetErrorCallBack(std::function<void(std::string)> errorCallback
 
 void SocketUtil::ReportError(const char* inOperationDesc)
 {
-#if _WIN32
-    LPVOID lpMsgBuf;
-    DWORD errorNum = GetLastError();
+    int error = GetLastError();
+    m_errorLog.Add(inOperationDesc, error);
 
-    FormatMessage(
-        FORMAT_MESSAGE_ALLOCATE_BUFFER |
-        FORMAT_MESSAGE_FROM_SYSTEM |
-        FORMAT_MESSAGE_IGNORE_INSERTS,
-        NULL,
-        errorNum,
-        MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-        (LPTSTR)&lpMsgBuf,
-        0, NULL);
-
-    if(m_errorCallBack)
+    const SocketErrorCallBack* callBack = SocketErrorScope::GetCurrentCallBack();
+    if (!callBack && m_errorCallBack)
+    {
+        callBack = &m_errorCallBack;
+    }
+    if (callBack)
     {
-        std::stringstream ss;
-        ss << inOperationDesc << ". GLE=" << errorNum;
-        m_errorCallBack(ss.str());
+        (*callBack)(SocketError{inOperationDesc, error, std::chrono::system_clock::now()});
     }
 
-    LOG("Error %s: %d- %s", inOperationDesc, errorNum, lpMsgBuf);
+    LOG("Error %s: %d", inOperationDesc, error);
+
+    //the callers read the error after reporting it
+#if _WIN32
+    WSASetLastError(error);
 #else
- LOG( "Error: %hs", inOperationDesc );
+    errno = error;
 #endif
 }
 
@@ -69,6 +71,33 @@ int SocketUtil::GetLastError()
 #endif
 }
 
+int SocketUtil::SetOption(SOCKET inSocket, int inLevel, int inName, int inValue, const char* inOperationDesc)
+{
+    if (setsockopt(inSocket, inLevel, inName, reinterpret_cast<const char*>(&inValue), sizeof(inValue)) < 0)
+    {
+        ReportError(inOperationDesc);
+        return -GetLastError();
+    }
+    return NO_ERROR;
+}
+
+int SocketUtil::GetOption(SOCKET inSocket, int inLevel, int inName, const char* inOperationDesc)
+{
+    int value = 0;
+    socklen_t length = sizeof(value);
+    if (getsockopt(inSocket, inLevel, inName, reinterpret_cast<char*>(&value), &length) < 0)
+    {
+        ReportError(inOperationDesc);
+        return -GetLastError();
+    }
+    return value;
+}
+
+const SocketErrorLog& SocketUtil::GetErrorLog()
+{
+    return m_errorLog;
+}
+
 UDPSocketPtr SocketUtil::CreateUDPSocket(SocketAddressFamily inFamily)
 {
     SOCKET s = socket(inFamily, SOCK_DGRAM, IPPROTO_UDP);
@@ -99,6 +128,133 @@ TCPSocketPtr SocketUtil::CreateTCPSocket(SocketAddressFamily inFamily)
     }
 }
 
+LocalSocketPtr SocketUtil::CreateLocalSocket(LocalSocketType inType)
+{
+#if _WIN32
+    WSASetLastError(WSAEOPNOTSUPP);
+    return nullptr;
+#else
+    SOCKET s = socket(AF_UNIX, static_cast<int>(inType) | SOCK_CLOEXEC, 0);
+
+    if (s != INVALID_SOCKET)
+    {
+        return LocalSocketPtr(new LocalSocket(s, inType));
+    }
+    else
+    {
+        ReportError("SocketUtil::CreateLocalSocket");
+        return nullptr;
+    }
+#endif
+}
+
+int SocketUtil::CreateLocalSocketPair(LocalSocketPtr& outFirst, LocalSocketPtr& outSecond, LocalSocketType inType)
+{
+#if _WIN32
+    return -WSAEOPNOTSUPP;
+#else
+    SOCKET sockets[2];
+    if (socketpair(AF_UNIX, static_cast<int>(inType) | SOCK_CLOEXEC, 0, sockets) < 0)
+    {
+        ReportError("SocketUtil::CreateLocalSocketPair");
+        return -GetLastError();
+    }
+    outFirst.reset(new LocalSocket(sockets[0], inType));
+    outSecond.reset(new LocalSocket(sockets[1], inType));
+    return NO_ERROR;
+#endif
+}
+
+int SocketUtil::SetCurrentThreadAffinity(size_t inCpu)
+{
+#ifdef __linux__
+    if (inCpu >= CPU_SETSIZE)
+    {
+        return -WSAEINVAL;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(inCpu, &cpus);
+    //pthread functions return the error instead of setting errno
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (error != 0)
+    {
+        errno = error;
+        ReportError("SocketUtil::SetCurrentThreadAffinity");
+        return -error;
+    }
+    return NO_ERROR;
+#elif _WIN32
+    if (inCpu >= sizeof(DWORD_PTR) * 8)
+    {
+        return -WSAEINVAL;
+    }
+    if (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << inCpu) == 0)
+    {
+        //not a socket error, WSAGetLastError would not see it
+        int error = static_cast<int>(::GetLastError());
+        WSASetLastError(error);
+        ReportError("SocketUtil::SetCurrentThreadAffinity");
+        return -error;
+    }
+    return NO_ERROR;
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int SocketUtil::Poll(pollfd* ioPollFds, size_t inCount, int inTimeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(inTimeoutMs, 0));
+    while (true)
+    {
+#if _WIN32
+        int readyCount = WSAPoll(ioPollFds, static_cast<ULONG>(inCount), inTimeoutMs);
+#else
+        int readyCount = poll(ioPollFds, static_cast<nfds_t>(inCount), inTimeoutMs);
+        if (readyCount < 0 && errno == EINTR)
+        {
+            if (inTimeoutMs > 0)
+            {
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                inTimeoutMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+            }
+            continue;
+        }
+#endif
+        if (readyCount < 0)
+        {
+            ReportError("SocketUtil::Poll");
+            return -GetLastError();
+        }
+        return readyCount;
+    }
+}
+
+int SocketUtil::Poll(const vector<TCPSocketPtr>& inSockets, int inInterest, vector<TCPSocketPtr>& outReady,
+                     int inTimeoutMs)
+{
+    short events = ((inInterest & POLL_READ) ? POLLIN : 0) | ((inInterest & POLL_WRITE) ? POLLOUT : 0);
+    vector<pollfd> pollFds;
+    pollFds.reserve(inSockets.size());
+    for (const TCPSocketPtr& socket : inSockets)
+    {
+        pollFds.push_back({socket->mSocket, events, 0});
+    }
+
+    outReady.clear();
+    int readyCount = Poll(pollFds.data(), pollFds.size(), inTimeoutMs);
+    for (size_t i = 0; readyCount > 0 && i < pollFds.size(); ++i)
+    {
+        //errors and hang ups are reported without being asked for
+        if (pollFds[i].revents != 0)
+        {
+            outReady.push_back(inSockets[i]);
+        }
+    }
+    return readyCount;
+}
+
 fd_set* SocketUtil::FillSetFromVector(fd_set& outSet, const vector<TCPSocketPtr>* inSockets, int& ioNaxNfds)
 {
     if (inSockets)
@@ -141,7 +297,8 @@ int SocketUtil::Select(const vector<TCPSocketPtr>* inReadSet,
                        const vector<TCPSocketPtr>* inWriteSet,
                        vector<TCPSocketPtr>* outWriteSet,
                        const vector<TCPSocketPtr>* inExceptSet,
-                       vector<TCPSocketPtr>* outExceptSet)
+                       vector<TCPSocketPtr>* outExceptSet,
+                       int inTimeoutMs)
 {
     //build up some sets from our vectors
     fd_set read, write, except;
@@ -152,7 +309,11 @@ int SocketUtil::Select(const vector<TCPSocketPtr>* inReadSet,
     fd_set* writePtr = FillSetFromVector(write, inWriteSet, nfds);
     fd_set* exceptPtr = FillSetFromVector(except, inExceptSet, nfds);
 
-    int toRet = select(nfds + 1, readPtr, writePtr, exceptPtr, nullptr);
+    timeval timeout;
+    timeout.tv_sec = inTimeoutMs / 1000;
+    timeout.tv_usec = (inTimeoutMs % 1000) * 1000;
+
+    int toRet = select(nfds + 1, readPtr, writePtr, exceptPtr, inTimeoutMs < 0 ? nullptr : &timeout);
 
     if (toRet > 0)
     {
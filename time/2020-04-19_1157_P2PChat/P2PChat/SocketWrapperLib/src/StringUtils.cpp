@@ -1,8 +1,7 @@
 #include "SocketWrapperShared.h"
+#include <fstream>
 
 #if !_WIN32
-extern const char** __argv;
-extern int __argc;
 void OutputDebugString( const char* inString )
 {
  printf( "%s", inString );
@@ -11,10 +10,23 @@ void OutputDebugString( const char* inString )
 
 string StringUtils::GetCommandLineArg(int inIndex)
 {
+#if _WIN32
     if (inIndex < __argc)
     {
         return string(__argv[inIndex]);
     }
+#elif defined(__linux__)
+    //no __argv outside the Microsoft runtime, the kernel keeps the arguments separated by '\0'
+    std::ifstream commandLine("/proc/self/cmdline", std::ios::binary);
+    string arg;
+    for (int i = 0; std::getline(commandLine, arg, '\0'); ++i)
+    {
+        if (i == inIndex)
+        {
+            return arg;
+        }
+    }
+#endif
 
     return string();
 }
@@ -22,8 +34,8 @@ string StringUtils::GetCommandLineArg(int inIndex)
 
 string StringUtils::Sprintf(const char* inFormat, ...)
 {
-    //not thread safe...
-    static char temp[ 4096 ];
+    //every thread formats into its own buffer
+    thread_local char temp[ 4096 ];
 
     va_list args;
     va_start(args, inFormat);
@@ -33,6 +45,7 @@ string StringUtils::Sprintf(const char* inFormat, ...)
 #else
  vsnprintf(temp, 4096, inFormat, args);
 #endif
+    va_end(args);
     return string(temp);
 }
 
@@ -44,8 +57,8 @@ string StringUtils::Sprintf(const char* inFormat, ...)
 
 void StringUtils::Log(const char* inFormat, ...)
 {
-    //not thread safe...
-    static char temp[ 4096 ];
+    //every thread formats into its own buffer
+    thread_local char temp[ 4096 ];
 
     va_list args;
     va_start(args, inFormat);
@@ -55,6 +68,7 @@ void StringUtils::Log(const char* inFormat, ...)
 #else
  vsnprintf(temp, 4096, inFormat, args);
 #endif
+    va_end(args);
     // OutputDebugString( temp ); // TODO
     // OutputDebugString( "\n" ); // TODO
 }
@@ -0,0 +1,183 @@
+#include <algorithm>
+
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    bool Contains(const vector<TCPSocketPtr>& inSockets, const TCPSocketPtr& inSocket)
+    {
+        return std::find(inSockets.begin(), inSockets.end(), inSocket) != inSockets.end();
+    }
+}
+
+TCPConnector::TCPConnector(const vector<SocketAddress>& inAddresses, const ConnectOptions& inOptions):
+    mOptions(inOptions),
+    mNextAddress(0),
+    mNextAttemptTime(Clock::now()),
+    mDeadline(mNextAttemptTime + std::chrono::milliseconds(inOptions.totalTimeoutMs)),
+    mError(NO_ERROR),
+    mIsFinished(false)
+{
+    //the family of the first address first, then alternating, so a broken IPv6 path costs one attempt delay
+    vector<SocketAddress> preferred, others;
+    for (const SocketAddress& address : inAddresses)
+    {
+        (address.GetFamily() == inAddresses.front().GetFamily() ? preferred : others).push_back(address);
+    }
+    for (size_t i = 0; i < std::max(preferred.size(), others.size()); ++i)
+    {
+        if (i < preferred.size())
+        {
+            mAddresses.push_back(preferred[i]);
+        }
+        if (i < others.size())
+        {
+            mAddresses.push_back(others[i]);
+        }
+    }
+
+    if (mAddresses.empty())
+    {
+        Finish(nullptr, -WSAEINVAL);
+    }
+}
+
+TCPSocketPtr TCPConnector::Update(int inWaitMs)
+{
+    if (mIsFinished)
+    {
+        return nullptr;
+    }
+
+    auto now = Clock::now();
+    if (TCPSocketPtr socket = StartAttempts(now))
+    {
+        return Finish(socket, NO_ERROR);
+    }
+    if (mAttempts.empty())
+    {
+        return Finish(nullptr, mError);
+    }
+
+    //wake up for the next attempt and for the deadlines
+    Clock::time_point wakeTime = std::min(mDeadline, now + std::chrono::milliseconds(inWaitMs));
+    if (mNextAddress < mAddresses.size())
+    {
+        wakeTime = std::min(wakeTime, mNextAttemptTime);
+    }
+    vector<TCPSocketPtr> sockets;
+    for (const Attempt& attempt : mAttempts)
+    {
+        wakeTime = std::min(wakeTime, attempt.deadline);
+        sockets.push_back(attempt.socket);
+    }
+    auto waitTime = std::chrono::ceil<std::chrono::milliseconds>(std::max(wakeTime - now, Clock::duration::zero()));
+
+    //a connect which succeeded is writable, a failed one comes with POLLERR or POLLHUP
+    vector<TCPSocketPtr> ready;
+    int readyCount = SocketUtil::Poll(sockets, POLL_WRITE, ready, static_cast<int>(waitTime.count()));
+    if (readyCount < 0)
+    {
+        return Finish(nullptr, readyCount);
+    }
+
+    now = Clock::now();
+    for (auto attempt = mAttempts.begin(); attempt != mAttempts.end();)
+    {
+        if (Contains(ready, attempt->socket))
+        {
+            int result = attempt->socket->GetConnectResult();
+            if (result == NO_ERROR)
+            {
+                TCPSocketPtr socket = attempt->socket;
+                mAttempts.erase(attempt);
+                return Finish(socket, NO_ERROR);
+            }
+            mError = result;
+        }
+        else if (now >= attempt->deadline)
+        {
+            mError = -WSAETIMEDOUT;
+        }
+        else
+        {
+            ++attempt;
+            continue;
+        }
+
+        //a failed attempt does not wait for the attempt delay
+        attempt = mAttempts.erase(attempt);
+        mNextAttemptTime = now;
+    }
+
+    if (now >= mDeadline)
+    {
+        return Finish(nullptr, -WSAETIMEDOUT);
+    }
+    if (mAttempts.empty() && mNextAddress == mAddresses.size())
+    {
+        return Finish(nullptr, mError);
+    }
+    return nullptr;
+}
+
+TCPSocketPtr TCPConnector::StartAttempts(Clock::time_point inNow)
+{
+    while (mNextAddress < mAddresses.size() && (mAttempts.empty() || inNow >= mNextAttemptTime))
+    {
+        const SocketAddress& address = mAddresses[mNextAddress++];
+        mNextAttemptTime = inNow + std::chrono::milliseconds(mOptions.attemptDelayMs);
+
+        TCPSocketPtr socket = SocketUtil::CreateTCPSocket(static_cast<SocketAddressFamily>(address.GetFamily()));
+        if (!socket || socket->SetNonBlockingMode(true) != NO_ERROR)
+        {
+            mError = -SocketUtil::GetLastError();
+            continue;
+        }
+
+        int result = socket->StartConnect(address);
+        if (result == NO_ERROR)
+        {
+            return socket;
+        }
+        if (result == -WSAEWOULDBLOCK)
+        {
+            mAttempts.push_back({socket, inNow + std::chrono::milliseconds(mOptions.attemptTimeoutMs)});
+        }
+        else
+        {
+            mError = result;
+        }
+    }
+    return nullptr;
+}
+
+TCPSocketPtr TCPConnector::Finish(TCPSocketPtr inSocket, int inError)
+{
+    mIsFinished = true;
+    mError = inError;
+    //closes the attempts which lost the race
+    mAttempts.clear();
+    return inSocket;
+}
+
+TCPSocketPtr TCPConnector::Connect(const vector<SocketAddress>& inAddresses, const ConnectOptions& inOptions,
+                                   int* outError)
+{
+    TCPConnector connector(inAddresses, inOptions);
+    TCPSocketPtr socket;
+    while (!socket && !connector.IsFinished())
+    {
+        socket = connector.Update(inOptions.totalTimeoutMs);
+    }
+
+    if (outError)
+    {
+        *outError = connector.GetError();
+    }
+    if (socket)
+    {
+        socket->SetNonBlockingMode(false);
+    }
+    return socket;
+}
@@ -1,8 +1,67 @@
+#include <algorithm>
+
 #include "SocketWrapperShared.h"
 
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <sys/uio.h>
+#endif
+
+namespace
+{
+    //below this size page pinning and the completion cost more than copying
+    const size_t ZERO_COPY_MIN_SIZE = 10 * 1024;
+
+#if _WIN32
+    DWORD FillSystemBuffers(WSABUF* outBuffers, const SendBuffer* inBuffers, size_t inCount)
+    {
+        inCount = std::min(inCount, MAX_SOCKET_BUFFERS);
+        for (size_t i = 0; i < inCount; ++i)
+        {
+            outBuffers[i].buf = static_cast<char*>(const_cast<void*>(inBuffers[i].data));
+            outBuffers[i].len = static_cast<ULONG>(inBuffers[i].length);
+        }
+        return static_cast<DWORD>(inCount);
+    }
+
+    DWORD FillSystemBuffers(WSABUF* outBuffers, const ReceiveBuffer* inBuffers, size_t inCount)
+    {
+        inCount = std::min(inCount, MAX_SOCKET_BUFFERS);
+        for (size_t i = 0; i < inCount; ++i)
+        {
+            outBuffers[i].buf = static_cast<char*>(inBuffers[i].data);
+            outBuffers[i].len = static_cast<ULONG>(inBuffers[i].length);
+        }
+        return static_cast<DWORD>(inCount);
+    }
+#else
+    size_t FillSystemBuffers(iovec* outBuffers, const SendBuffer* inBuffers, size_t inCount)
+    {
+        inCount = std::min(inCount, MAX_SOCKET_BUFFERS);
+        for (size_t i = 0; i < inCount; ++i)
+        {
+            outBuffers[i].iov_base = const_cast<void*>(inBuffers[i].data);
+            outBuffers[i].iov_len = inBuffers[i].length;
+        }
+        return inCount;
+    }
+
+    size_t FillSystemBuffers(iovec* outBuffers, const ReceiveBuffer* inBuffers, size_t inCount)
+    {
+        inCount = std::min(inCount, MAX_SOCKET_BUFFERS);
+        for (size_t i = 0; i < inCount; ++i)
+        {
+            outBuffers[i].iov_base = inBuffers[i].data;
+            outBuffers[i].iov_len = inBuffers[i].length;
+        }
+        return inCount;
+    }
+#endif
+}
+
 int TCPSocket::Connect(const SocketAddress& inAddress)
 {
-    int err = connect(mSocket, &inAddress.mSockAddr, inAddress.GetSize());
+    int err = connect(mSocket, inAddress.GetSockAddr(), inAddress.GetSize());
     if (err < 0)
     {
         SocketUtil::ReportError("TCPSocket::Connect");
@@ -11,6 +70,67 @@ int TCPSocket::Connect(const SocketAddress& inAddress)
     return NO_ERROR;
 }
 
+int TCPSocket::Connect(const SocketAddress& inAddress, int inTimeoutMs)
+{
+    if (inTimeoutMs < 0)
+    {
+        return -WSAEINVAL;
+    }
+    bool wasNonBlocking = mIsNonBlocking;
+    if (!wasNonBlocking && SetNonBlockingMode(true) != NO_ERROR)
+    {
+        return -SocketUtil::GetLastError();
+    }
+
+    int result = StartConnect(inAddress);
+    if (result == -WSAEWOULDBLOCK)
+    {
+        //a failed connect comes as POLLERR or POLLHUP, which poll reports without being asked for
+        pollfd pollFd = {mSocket, POLLOUT, 0};
+        int readyCount = SocketUtil::Poll(&pollFd, 1, inTimeoutMs);
+        result = readyCount > 0 ? GetConnectResult() : readyCount == 0 ? -WSAETIMEDOUT : readyCount;
+    }
+
+    if (!wasNonBlocking)
+    {
+        SetNonBlockingMode(false);
+    }
+    return result;
+}
+
+int TCPSocket::StartConnect(const SocketAddress& inAddress)
+{
+    int err = connect(mSocket, inAddress.GetSockAddr(), inAddress.GetSize());
+    if (err < 0)
+    {
+        int error = SocketUtil::GetLastError();
+#if !_WIN32
+        if (error == EINPROGRESS)
+        {
+            error = WSAEWOULDBLOCK;
+        }
+#endif
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("TCPSocket::StartConnect");
+        }
+        return -error;
+    }
+    return NO_ERROR;
+}
+
+int TCPSocket::GetConnectResult()
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(mSocket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) < 0)
+    {
+        SocketUtil::ReportError("TCPSocket::GetConnectResult");
+        return -SocketUtil::GetLastError();
+    }
+    return error == 0 ? NO_ERROR : -error;
+}
+
 int TCPSocket::Listen(int inBackLog)
 {
     int err = listen(mSocket, inBackLog);
@@ -24,8 +144,8 @@ int TCPSocket::Listen(int inBackLog)
 
 TCPSocketPtr TCPSocket::Accept(SocketAddress& inFromAddress)
 {
-    socklen_t length = inFromAddress.GetSize();
-    SOCKET newSocket = accept(mSocket, &inFromAddress.mSockAddr, &length);
+    socklen_t length = sizeof(sockaddr_storage);
+    SOCKET newSocket = accept(mSocket, inFromAddress.GetSockAddr(), &length);
 
     if (newSocket != INVALID_SOCKET)
     {
@@ -33,7 +153,11 @@ TCPSocketPtr TCPSocket::Accept(SocketAddress& inFromAddress)
     }
     else
     {
-        SocketUtil::ReportError("TCPSocket::Accept");
+        //in non-blocking mode an empty backlog is not an error
+        if (SocketUtil::GetLastError() != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("TCPSocket::Accept");
+        }
         return nullptr;
     }
 }
@@ -43,8 +167,13 @@ int32_t TCPSocket::Send(const void* inData, size_t inLen)
     int bytesSentCount = send(mSocket, static_cast<const char*>(inData), inLen, 0);
     if (bytesSentCount < 0)
     {
-        SocketUtil::ReportError("TCPSocket::Send");
-        return -SocketUtil::GetLastError();
+        int error = SocketUtil::GetLastError();
+        //in non-blocking mode the send buffer is full
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("TCPSocket::Send");
+        }
+        return -error;
     }
     return bytesSentCount;
 }
@@ -54,15 +183,208 @@ int32_t TCPSocket::Receive(void* inData, size_t inLen)
     int bytesReceivedCount = recv(mSocket, static_cast<char*>(inData), inLen, 0);
     if (bytesReceivedCount < 0)
     {
-        SocketUtil::ReportError("TCPSocket::Receive");
-        return -SocketUtil::GetLastError();
+        int error = SocketUtil::GetLastError();
+        //in non-blocking mode it only means that everything is read
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("TCPSocket::Receive");
+        }
+        return -error;
+    }
+    return bytesReceivedCount;
+}
+
+int32_t TCPSocket::SendV(const SendBuffer* inBuffers, size_t inCount)
+{
+#if _WIN32
+    WSABUF buffers[MAX_SOCKET_BUFFERS];
+    DWORD bytesSentCount = 0;
+    int result = WSASend(mSocket, buffers, FillSystemBuffers(buffers, inBuffers, inCount), &bytesSentCount, 0,
+                         nullptr, nullptr);
+    bool isFailed = result == SOCKET_ERROR;
+#else
+    iovec buffers[MAX_SOCKET_BUFFERS];
+    ssize_t bytesSentCount = writev(mSocket, buffers, static_cast<int>(FillSystemBuffers(buffers, inBuffers, inCount)));
+    bool isFailed = bytesSentCount < 0;
+#endif
+
+    if (isFailed)
+    {
+        int error = SocketUtil::GetLastError();
+        //in non-blocking mode the send buffer is full
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("TCPSocket::SendV");
+        }
+        return -error;
+    }
+    return static_cast<int32_t>(bytesSentCount);
+}
+
+int32_t TCPSocket::ReceiveV(const ReceiveBuffer* inBuffers, size_t inCount)
+{
+#if _WIN32
+    WSABUF buffers[MAX_SOCKET_BUFFERS];
+    DWORD bytesReceivedCount = 0;
+    DWORD flags = 0;
+    int result = WSARecv(mSocket, buffers, FillSystemBuffers(buffers, inBuffers, inCount), &bytesReceivedCount,
+                         &flags, nullptr, nullptr);
+    bool isFailed = result == SOCKET_ERROR;
+#else
+    iovec buffers[MAX_SOCKET_BUFFERS];
+    ssize_t bytesReceivedCount = readv(mSocket, buffers,
+                                       static_cast<int>(FillSystemBuffers(buffers, inBuffers, inCount)));
+    bool isFailed = bytesReceivedCount < 0;
+#endif
+
+    if (isFailed)
+    {
+        int error = SocketUtil::GetLastError();
+        //in non-blocking mode it only means that everything is read
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("TCPSocket::ReceiveV");
+        }
+        return -error;
+    }
+    return static_cast<int32_t>(bytesReceivedCount);
+}
+
+int32_t TCPSocket::Send(const MemoryOutputStream& inMOS)
+{
+    return Send(inMOS.GetBufferPtr(), inMOS.GetLength());
+}
+
+int32_t TCPSocket::Receive(MemoryInputStream& inMIS)
+{
+    int32_t bytesReceivedCount = Receive(inMIS.GetReceiveBuffer(), inMIS.GetCapacity());
+    inMIS.Reset(bytesReceivedCount > 0 ? bytesReceivedCount : 0);
+    return bytesReceivedCount;
+}
+
+int32_t TCPSocket::Receive(PooledBuffer& ioBuffer)
+{
+    size_t length = ioBuffer.GetLength();
+    int32_t bytesReceivedCount = Receive(ioBuffer.GetData() + length, ioBuffer.GetCapacity() - length);
+    if (bytesReceivedCount > 0)
+    {
+        ioBuffer.SetLength(length + bytesReceivedCount);
     }
     return bytesReceivedCount;
 }
 
+int TCPSocket::EnableZeroCopy()
+{
+#ifdef __linux__
+    int isEnabled = 1;
+    if (setsockopt(mSocket, SOL_SOCKET, SO_ZEROCOPY, &isEnabled, sizeof(isEnabled)) < 0)
+    {
+        SocketUtil::ReportError("TCPSocket::EnableZeroCopy");
+        return -SocketUtil::GetLastError();
+    }
+    mIsZeroCopyEnabled = true;
+    return NO_ERROR;
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int32_t TCPSocket::SendZeroCopy(const SendBuffer* inBuffers, size_t inCount, shared_ptr<const void> inOwner)
+{
+#ifdef __linux__
+    size_t totalLength = 0;
+    for (size_t i = 0; i < inCount; ++i)
+    {
+        totalLength += inBuffers[i].length;
+    }
+    if (!mIsZeroCopyEnabled || totalLength < ZERO_COPY_MIN_SIZE)
+    {
+        return SendV(inBuffers, inCount);
+    }
+
+    iovec buffers[MAX_SOCKET_BUFFERS];
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = buffers;
+    message.msg_iovlen = FillSystemBuffers(buffers, inBuffers, inCount);
+
+    ssize_t bytesSentCount = sendmsg(mSocket, &message, MSG_ZEROCOPY);
+    if (bytesSentCount < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        //the send buffer is full or too many pages are pinned already
+        if (error != WSAEWOULDBLOCK && error != ENOBUFS)
+        {
+            SocketUtil::ReportError("TCPSocket::SendZeroCopy");
+        }
+        return -error;
+    }
+
+    //every successful call gets the next notification id
+    mZeroCopyOwners.emplace_back(mZeroCopySendCount++, std::move(inOwner));
+    return static_cast<int32_t>(bytesSentCount);
+#else
+    return SendV(inBuffers, inCount);
+#endif
+}
+
+int TCPSocket::ProcessZeroCopyCompletions()
+{
+#ifdef __linux__
+    while (!mZeroCopyOwners.empty())
+    {
+        char control[CMSG_SPACE(sizeof(sock_extended_err)) + 64];
+        msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        if (recvmsg(mSocket, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+        {
+            int error = SocketUtil::GetLastError();
+            if (error == WSAEWOULDBLOCK)
+            {
+                break;
+            }
+            SocketUtil::ReportError("TCPSocket::ProcessZeroCopyCompletions");
+            return -error;
+        }
+
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+        {
+            bool isRecvErr = (header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR)
+                || (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR);
+            if (!isRecvErr)
+            {
+                continue;
+            }
+
+            const sock_extended_err* notification = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+            if (notification->ee_errno != 0 || notification->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+                continue;
+            }
+
+            //sends from ee_info to ee_data inclusive are completed, ids wrap around
+            uint32_t first = notification->ee_info;
+            uint32_t count = notification->ee_data - first + 1;
+            mZeroCopyOwners.erase(std::remove_if(mZeroCopyOwners.begin(), mZeroCopyOwners.end(),
+                                                 [=](const std::pair<uint32_t, shared_ptr<const void>>& owner)
+                                                 {
+                                                     return owner.first - first < count;
+                                                 }),
+                                  mZeroCopyOwners.end());
+        }
+    }
+    return static_cast<int>(mZeroCopyOwners.size());
+#else
+    return 0;
+#endif
+}
+
 int TCPSocket::Bind(const SocketAddress& inBindAddress)
 {
-    int error = bind(mSocket, &inBindAddress.mSockAddr, inBindAddress.GetSize());
+    int error = bind(mSocket, inBindAddress.GetSockAddr(), inBindAddress.GetSize());
     if (error != 0)
     {
         SocketUtil::ReportError("TCPSocket::Bind");
@@ -100,10 +422,96 @@ int TCPSocket::SetNonBlockingMode(bool inShouldBeNonBlocking)
     }
     else
     {
+        mIsNonBlocking = inShouldBeNonBlocking;
         return NO_ERROR;
     }
 }
 
-TCPSocket::TCPSocket(SOCKET inSocket): mSocket(inSocket)
+int TCPSocket::SetNoDelay(bool inIsEnabled)
+{
+    return SocketUtil::SetOption(mSocket, IPPROTO_TCP, TCP_NODELAY, inIsEnabled ? 1 : 0, "TCPSocket::SetNoDelay");
+}
+
+int TCPSocket::SetReuseAddress(bool inIsEnabled)
+{
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_REUSEADDR, inIsEnabled ? 1 : 0, "TCPSocket::SetReuseAddress");
+}
+
+int TCPSocket::SetReusePort(bool inIsEnabled)
+{
+#ifdef SO_REUSEPORT
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_REUSEPORT, inIsEnabled ? 1 : 0, "TCPSocket::SetReusePort");
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int TCPSocket::SetSendBufferSize(int inSize)
+{
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_SNDBUF, inSize, "TCPSocket::SetSendBufferSize");
+}
+
+int TCPSocket::SetReceiveBufferSize(int inSize)
+{
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_RCVBUF, inSize, "TCPSocket::SetReceiveBufferSize");
+}
+
+int TCPSocket::GetSendBufferSize()
+{
+    return SocketUtil::GetOption(mSocket, SOL_SOCKET, SO_SNDBUF, "TCPSocket::GetSendBufferSize");
+}
+
+int TCPSocket::GetReceiveBufferSize()
+{
+    return SocketUtil::GetOption(mSocket, SOL_SOCKET, SO_RCVBUF, "TCPSocket::GetReceiveBufferSize");
+}
+
+int TCPSocket::SetKeepAlive(bool inIsEnabled, int inIdleSeconds, int inIntervalSeconds, int inProbeCount)
+{
+    int result = SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_KEEPALIVE, inIsEnabled ? 1 : 0, "TCPSocket::SetKeepAlive");
+    if (result != NO_ERROR || !inIsEnabled)
+    {
+        return result;
+    }
+#ifdef TCP_KEEPIDLE
+    if (inIdleSeconds > 0)
+    {
+        result = SocketUtil::SetOption(mSocket, IPPROTO_TCP, TCP_KEEPIDLE, inIdleSeconds, "TCPSocket::SetKeepAlive");
+    }
+    if (result == NO_ERROR && inIntervalSeconds > 0)
+    {
+        result = SocketUtil::SetOption(mSocket, IPPROTO_TCP, TCP_KEEPINTVL, inIntervalSeconds, "TCPSocket::SetKeepAlive");
+    }
+    if (result == NO_ERROR && inProbeCount > 0)
+    {
+        result = SocketUtil::SetOption(mSocket, IPPROTO_TCP, TCP_KEEPCNT, inProbeCount, "TCPSocket::SetKeepAlive");
+    }
+    return result;
+#else
+    return inIdleSeconds > 0 || inIntervalSeconds > 0 || inProbeCount > 0 ? -WSAEOPNOTSUPP : NO_ERROR;
+#endif
+}
+
+int TCPSocket::SetDeferAccept(int inSeconds)
+{
+#ifdef TCP_DEFER_ACCEPT
+    return SocketUtil::SetOption(mSocket, IPPROTO_TCP, TCP_DEFER_ACCEPT, inSeconds, "TCPSocket::SetDeferAccept");
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+bool TCPSocket::IsIdleConnectionAlive()
+{
+    //nothing should arrive on an idle connection, readable means closed, reset or stray data
+    pollfd pollFd = {mSocket, POLLIN, 0};
+    return SocketUtil::Poll(&pollFd, 1, 0) == 0;
+}
+
+TCPSocket::TCPSocket(SOCKET inSocket):
+    mSocket(inSocket),
+    mIsNonBlocking(false),
+    mIsZeroCopyEnabled(false),
+    mZeroCopySendCount(0)
 {
 }
@@ -0,0 +1,264 @@
+#include "SocketWrapperShared.h"
+
+namespace
+{
+    const uint64_t NO_TICK = UINT64_MAX;
+
+    // index of the lowest set bit, inBits is not 0
+    int LowestBit(uint64_t inBits)
+    {
+#if _WIN32
+        unsigned long index;
+        _BitScanForward64(&index, inBits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(inBits);
+#endif
+    }
+}
+
+TimerWheel::TimerWheel(Clock::duration inTick, Clock::time_point inNow):
+    mStart(inNow),
+    mTick(inTick),
+    mCurrentTick(0),
+    mFreeList(NIL),
+    mCount(0)
+{
+    std::fill(std::begin(mHeads), std::end(mHeads), NIL);
+    std::fill(std::begin(mOccupied), std::end(mOccupied), 0);
+}
+
+uint64_t TimerWheel::ToTick(Clock::time_point inTime) const
+{
+    if (inTime <= mStart)
+    {
+        return 0;
+    }
+    //rounded up, a timer never fires before its time
+    Clock::duration elapsed = inTime - mStart;
+    return static_cast<uint64_t>((elapsed + mTick - Clock::duration(1)) / mTick);
+}
+
+TimerWheel::Node* TimerWheel::Find(TimerId inTimer)
+{
+    uint32_t index = static_cast<uint32_t>(inTimer);
+    uint32_t generation = static_cast<uint32_t>(inTimer >> 32);
+    if (index >= mNodes.size())
+    {
+        return nullptr;
+    }
+    Node& node = mNodes[index];
+    return node.generation == generation && node.bucket != NIL ? &node : nullptr;
+}
+
+void TimerWheel::Link(uint32_t inIndex, uint64_t inEarliestTick)
+{
+    Node& node = mNodes[inIndex];
+    uint64_t expiry = std::max(node.expiry, inEarliestTick);
+    uint64_t delta = expiry - mCurrentTick;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))
+    {
+        ++level;
+    }
+    //beyond the last level the timer waits in the slot furthest away and is cascaded again
+    if (delta >= (uint64_t(1) << (LEVEL_BITS * LEVELS)))
+    {
+        expiry = mCurrentTick + (uint64_t(1) << (LEVEL_BITS * LEVELS)) - 1;
+    }
+    int slot = static_cast<int>((expiry >> (LEVEL_BITS * level)) & (SLOTS_PER_LEVEL - 1));
+    uint32_t bucket = level * SLOTS_PER_LEVEL + slot;
+
+    node.bucket = bucket;
+    node.previous = NIL;
+    node.next = mHeads[bucket];
+    if (node.next != NIL)
+    {
+        mNodes[node.next].previous = inIndex;
+    }
+    mHeads[bucket] = inIndex;
+    mOccupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::Unlink(uint32_t inIndex)
+{
+    Node& node = mNodes[inIndex];
+    if (node.previous != NIL)
+    {
+        mNodes[node.previous].next = node.next;
+    }
+    else
+    {
+        mHeads[node.bucket] = node.next;
+        if (node.next == NIL)
+        {
+            mOccupied[node.bucket / SLOTS_PER_LEVEL] &= ~(uint64_t(1) << (node.bucket % SLOTS_PER_LEVEL));
+        }
+    }
+    if (node.next != NIL)
+    {
+        mNodes[node.next].previous = node.previous;
+    }
+    node.bucket = NIL;
+}
+
+void TimerWheel::Release(uint32_t inIndex)
+{
+    Node& node = mNodes[inIndex];
+    node.callback = nullptr;
+    //old ids of this node do not find it anymore
+    ++node.generation;
+    node.next = mFreeList;
+    mFreeList = inIndex;
+    --mCount;
+}
+
+TimerId TimerWheel::ScheduleAt(Clock::time_point inTime, Callback inCallback)
+{
+    uint32_t index = mFreeList;
+    if (index != NIL)
+    {
+        mFreeList = mNodes[index].next;
+    }
+    else
+    {
+        index = static_cast<uint32_t>(mNodes.size());
+        mNodes.emplace_back();
+        mNodes[index].generation = 1;
+    }
+
+    Node& node = mNodes[index];
+    node.expiry = ToTick(inTime);
+    node.callback = std::move(inCallback);
+    //a timer which is already due fires in the next tick
+    Link(index, mCurrentTick + 1);
+    ++mCount;
+    return (static_cast<TimerId>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::Cancel(TimerId inTimer)
+{
+    Node* node = Find(inTimer);
+    if (!node)
+    {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(inTimer);
+    Unlink(index);
+    Release(index);
+    return true;
+}
+
+bool TimerWheel::RescheduleAt(TimerId inTimer, Clock::time_point inTime)
+{
+    Node* node = Find(inTimer);
+    if (!node)
+    {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(inTimer);
+    Unlink(index);
+    node->expiry = ToTick(inTime);
+    Link(index, mCurrentTick + 1);
+    return true;
+}
+
+uint64_t TimerWheel::GetNextEventTick() const
+{
+    uint64_t nextTick = NO_TICK;
+    for (int level = 0; level < LEVELS; ++level)
+    {
+        uint64_t occupied = mOccupied[level];
+        if (occupied == 0)
+        {
+            continue;
+        }
+        //the first occupied slot after the current one, the current slot itself counts a full turn later
+        int shift = LEVEL_BITS * level;
+        uint64_t position = mCurrentTick >> shift;
+        int current = static_cast<int>(position & (SLOTS_PER_LEVEL - 1));
+        int rotate = (current + 1) & (SLOTS_PER_LEVEL - 1);
+        uint64_t rotated = rotate == 0 ? occupied : (occupied >> rotate) | (occupied << (SLOTS_PER_LEVEL - rotate));
+        uint64_t distance = LowestBit(rotated) + 1;
+
+        //a slot of a higher level is cascaded when the lower levels wrap to it
+        uint64_t tick = (position + distance) << shift;
+        nextTick = std::min(nextTick, tick);
+    }
+    return nextTick;
+}
+
+size_t TimerWheel::ProcessTick()
+{
+    //move the timers of the higher slots which start now down, they land in lower levels or in this tick
+    for (int level = LEVELS - 1; level > 0; --level)
+    {
+        int shift = LEVEL_BITS * level;
+        if ((mCurrentTick & ((uint64_t(1) << shift) - 1)) != 0)
+        {
+            continue;
+        }
+        uint32_t bucket = level * SLOTS_PER_LEVEL + static_cast<uint32_t>((mCurrentTick >> shift) & (SLOTS_PER_LEVEL - 1));
+        uint32_t index = mHeads[bucket];
+        mHeads[bucket] = NIL;
+        mOccupied[level] &= ~(uint64_t(1) << (bucket % SLOTS_PER_LEVEL));
+        while (index != NIL)
+        {
+            uint32_t next = mNodes[index].next;
+            Link(index, mCurrentTick);
+            index = next;
+        }
+    }
+
+    //the slot holds exactly the timers due in this tick
+    size_t firedCount = 0;
+    uint32_t bucket = static_cast<uint32_t>(mCurrentTick & (SLOTS_PER_LEVEL - 1));
+    while (mHeads[bucket] != NIL)
+    {
+        //one at a time, the callback may cancel other timers of the slot
+        uint32_t index = mHeads[bucket];
+        Unlink(index);
+        Callback callback = std::move(mNodes[index].callback);
+        Release(index);
+        callback();
+        ++firedCount;
+    }
+    return firedCount;
+}
+
+size_t TimerWheel::Advance(Clock::time_point inNow)
+{
+    uint64_t targetTick = inNow <= mStart ? 0 : static_cast<uint64_t>((inNow - mStart) / mTick);
+    size_t firedCount = 0;
+    while (mCurrentTick < targetTick)
+    {
+        //jump over the ticks where no slot has work
+        uint64_t nextTick = GetNextEventTick();
+        if (nextTick > targetTick)
+        {
+            mCurrentTick = targetTick;
+            break;
+        }
+        mCurrentTick = nextTick;
+        firedCount += ProcessTick();
+    }
+    return firedCount;
+}
+
+int TimerWheel::GetTimeoutMs(Clock::time_point inNow) const
+{
+    uint64_t nextTick = GetNextEventTick();
+    if (nextTick == NO_TICK)
+    {
+        return -1;
+    }
+    Clock::time_point nextTime = mStart + mTick * static_cast<Clock::rep>(nextTick);
+    if (nextTime <= inNow)
+    {
+        return 0;
+    }
+    //rounded up, waking before the tick starts would find nothing to do
+    auto timeout = std::chrono::ceil<std::chrono::milliseconds>(nextTime - inNow).count();
+    return static_cast<int>(std::min<decltype(timeout)>(timeout, INT32_MAX));
+}
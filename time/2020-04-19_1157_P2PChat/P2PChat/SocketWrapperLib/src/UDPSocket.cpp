@@ -1,8 +1,20 @@
 #include "SocketWrapperShared.h"
 
+#ifdef __linux__
+#include <netinet/udp.h>
+
+namespace
+{
+    //limits of one GSO send in the kernel
+    const size_t MAX_GSO_SEGMENTS = 64;
+    const size_t MAX_GSO_BYTES = 65000;
+    const size_t CONTROL_SIZE = CMSG_SPACE(sizeof(int));
+}
+#endif
+
 int UDPSocket::Bind(const SocketAddress& inBindAddress)
 {
-    int error = bind(mSocket, &inBindAddress.mSockAddr, inBindAddress.GetSize());
+    int error = bind(mSocket, inBindAddress.GetSockAddr(), inBindAddress.GetSize());
     if (error != 0)
     {
         SocketUtil::ReportError("UDPSocket::Bind");
@@ -17,7 +29,7 @@ int UDPSocket::SendTo(const void* inToSend, int inLength, const SocketAddress& i
     int byteSentCount = sendto(mSocket,
                                static_cast<const char*>(inToSend),
                                inLength,
-                               0, &inToAddress.mSockAddr, inToAddress.GetSize());
+                               0, inToAddress.GetSockAddr(), inToAddress.GetSize());
     if (byteSentCount <= 0)
     {
         //we'll return error as negative number to indicate less than requested amount of bytes sent...
@@ -32,12 +44,12 @@ int UDPSocket::SendTo(const void* inToSend, int inLength, const SocketAddress& i
 
 int UDPSocket::ReceiveFrom(void* inToReceive, int inMaxLength, SocketAddress& outFromAddress)
 {
-    socklen_t fromLength = outFromAddress.GetSize();
+    socklen_t fromLength = sizeof(sockaddr_storage);
 
     int readByteCount = recvfrom(mSocket,
                                  static_cast<char*>(inToReceive),
                                  inMaxLength,
-                                 0, &outFromAddress.mSockAddr, &fromLength);
+                                 0, outFromAddress.GetSockAddr(), &fromLength);
     if (readByteCount >= 0)
     {
         return readByteCount;
@@ -65,6 +77,222 @@ int UDPSocket::ReceiveFrom(void* inToReceive, int inMaxLength, SocketAddress& ou
     }
 }
 
+int UDPSocket::SendTo(const MemoryOutputStream& inMOS, const SocketAddress& inToAddress)
+{
+    return SendTo(inMOS.GetBufferPtr(), static_cast<int>(inMOS.GetLength()), inToAddress);
+}
+
+int UDPSocket::ReceiveFrom(MemoryInputStream& inMIS, SocketAddress& outFromAddress)
+{
+    int readByteCount = ReceiveFrom(inMIS.GetReceiveBuffer(), static_cast<int>(inMIS.GetCapacity()), outFromAddress);
+    inMIS.Reset(readByteCount > 0 ? readByteCount : 0);
+    return readByteCount;
+}
+
+int UDPSocket::SendBatch(const DatagramBatch& inBatch, size_t inFirst)
+{
+#ifdef __linux__
+    size_t messageCount = 0;
+    for (size_t i = inFirst; i < inBatch.mCount; ++messageCount)
+    {
+        mmsghdr& header = inBatch.mHeaders[messageCount];
+        memset(&header, 0, sizeof(header));
+        header.msg_hdr.msg_name = const_cast<sockaddr*>(inBatch.mAddresses[i].GetSockAddr());
+        header.msg_hdr.msg_namelen = inBatch.mAddresses[i].GetSize();
+        header.msg_hdr.msg_iov = &inBatch.mBuffers[i];
+
+        //with GSO equal datagrams to one address go as one message, only the last one may be shorter
+        size_t segmentSize = inBatch.mLengths[i];
+        size_t totalSize = 0;
+        size_t runLength = 0;
+        do
+        {
+            iovec& buffer = inBatch.mBuffers[i + runLength];
+            buffer.iov_base = const_cast<char*>(inBatch.GetData(i + runLength));
+            buffer.iov_len = inBatch.mLengths[i + runLength];
+            totalSize += buffer.iov_len;
+            ++runLength;
+        } while (mIsSegmentationOffloadEnabled && i + runLength < inBatch.mCount && runLength < MAX_GSO_SEGMENTS
+                 && inBatch.mLengths[i + runLength - 1] == segmentSize
+                 && inBatch.mLengths[i + runLength] <= segmentSize
+                 && totalSize + inBatch.mLengths[i + runLength] <= MAX_GSO_BYTES
+                 && inBatch.mAddresses[i + runLength] == inBatch.mAddresses[i]);
+        header.msg_hdr.msg_iovlen = runLength;
+
+        if (runLength > 1)
+        {
+            header.msg_hdr.msg_control = &inBatch.mControl[messageCount * CONTROL_SIZE];
+            header.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            cmsghdr* control = CMSG_FIRSTHDR(&header.msg_hdr);
+            control->cmsg_level = SOL_UDP;
+            control->cmsg_type = UDP_SEGMENT;
+            control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment = static_cast<uint16_t>(segmentSize);
+            memcpy(CMSG_DATA(control), &segment, sizeof(segment));
+        }
+        i += runLength;
+    }
+
+    if (messageCount == 0)
+    {
+        return 0;
+    }
+
+    int sentMessageCount = sendmmsg(mSocket, inBatch.mHeaders.data(), static_cast<unsigned int>(messageCount), 0);
+    if (sentMessageCount < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        //in non-blocking mode the send buffer is full
+        if (error != WSAEWOULDBLOCK)
+        {
+            SocketUtil::ReportError("UDPSocket::SendBatch");
+        }
+        return -error;
+    }
+
+    int sentCount = 0;
+    for (int i = 0; i < sentMessageCount; ++i)
+    {
+        sentCount += static_cast<int>(inBatch.mHeaders[i].msg_hdr.msg_iovlen);
+    }
+    return sentCount;
+#else
+    int sentCount = 0;
+    for (size_t i = inFirst; i < inBatch.mCount; ++i)
+    {
+        int result = SendTo(inBatch.GetData(i), static_cast<int>(inBatch.mLengths[i]), inBatch.mAddresses[i]);
+        if (result < 0)
+        {
+            return sentCount > 0 ? sentCount : result;
+        }
+        ++sentCount;
+    }
+    return sentCount;
+#endif
+}
+
+int UDPSocket::ReceiveBatch(DatagramBatch& outBatch)
+{
+    outBatch.Clear();
+
+#ifdef __linux__
+    size_t capacity = outBatch.GetCapacity();
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        iovec& buffer = outBatch.mBuffers[i];
+        buffer.iov_base = &outBatch.mArena[i * outBatch.mMaxDatagramSize];
+        buffer.iov_len = outBatch.mMaxDatagramSize;
+
+        mmsghdr& header = outBatch.mHeaders[i];
+        memset(&header, 0, sizeof(header));
+        header.msg_hdr.msg_name = outBatch.mAddresses[i].GetSockAddr();
+        header.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        header.msg_hdr.msg_iov = &buffer;
+        header.msg_hdr.msg_iovlen = 1;
+        header.msg_hdr.msg_control = &outBatch.mControl[i * CONTROL_SIZE];
+        header.msg_hdr.msg_controllen = CONTROL_SIZE;
+    }
+
+    //blocks only until the first datagram, the rest is what is already queued
+    int receivedCount = recvmmsg(mSocket, outBatch.mHeaders.data(), static_cast<unsigned int>(capacity),
+                                 MSG_WAITFORONE, nullptr);
+    if (receivedCount < 0)
+    {
+        int error = SocketUtil::GetLastError();
+        if (error == WSAEWOULDBLOCK)
+        {
+            return 0;
+        }
+        else if (error == WSAECONNRESET)
+        {
+            return -WSAECONNRESET;
+        }
+        SocketUtil::ReportError("UDPSocket::ReceiveBatch");
+        return -error;
+    }
+
+    for (int i = 0; i < receivedCount; ++i)
+    {
+        mmsghdr& header = outBatch.mHeaders[i];
+        outBatch.mLengths[i] = header.msg_len;
+        outBatch.mSegmentSizes[i] = 0;
+        for (cmsghdr* control = CMSG_FIRSTHDR(&header.msg_hdr); control;
+             control = CMSG_NXTHDR(&header.msg_hdr, control))
+        {
+            if (control->cmsg_level == SOL_UDP && control->cmsg_type == UDP_GRO)
+            {
+                int segmentSize = 0;
+                memcpy(&segmentSize, CMSG_DATA(control), sizeof(segmentSize));
+                outBatch.mSegmentSizes[i] = static_cast<size_t>(segmentSize);
+            }
+        }
+    }
+    outBatch.mCount = static_cast<size_t>(receivedCount);
+    return receivedCount;
+#else
+    while (outBatch.mCount < outBatch.GetCapacity())
+    {
+        if (outBatch.mCount > 0)
+        {
+            //do not block once something is received
+            u_long pendingSize = 0;
+            if (ioctlsocket(mSocket, FIONREAD, &pendingSize) != 0 || pendingSize == 0)
+            {
+                break;
+            }
+        }
+
+        size_t index = outBatch.mCount;
+        int result = ReceiveFrom(outBatch.GetNextSlot(), static_cast<int>(outBatch.mMaxDatagramSize),
+                                 outBatch.mAddresses[index]);
+        if (result < 0)
+        {
+            return outBatch.mCount > 0 ? static_cast<int>(outBatch.mCount) : result;
+        }
+        if (result == 0)
+        {
+            break;
+        }
+        outBatch.mLengths[index] = result;
+        outBatch.mSegmentSizes[index] = 0;
+        ++outBatch.mCount;
+    }
+    return static_cast<int>(outBatch.mCount);
+#endif
+}
+
+int UDPSocket::EnableSegmentationOffload()
+{
+#ifdef __linux__
+    //the size is given per send, setting 0 only checks that the kernel knows the option
+    int segmentSize = 0;
+    if (setsockopt(mSocket, SOL_UDP, UDP_SEGMENT, &segmentSize, sizeof(segmentSize)) < 0)
+    {
+        SocketUtil::ReportError("UDPSocket::EnableSegmentationOffload");
+        return -SocketUtil::GetLastError();
+    }
+    mIsSegmentationOffloadEnabled = true;
+    return NO_ERROR;
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int UDPSocket::EnableReceiveOffload()
+{
+#ifdef __linux__
+    int isEnabled = 1;
+    if (setsockopt(mSocket, SOL_UDP, UDP_GRO, &isEnabled, sizeof(isEnabled)) < 0)
+    {
+        SocketUtil::ReportError("UDPSocket::EnableReceiveOffload");
+        return -SocketUtil::GetLastError();
+    }
+    return NO_ERROR;
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
 UDPSocket::~UDPSocket()
 {
 #if _WIN32
@@ -97,6 +325,40 @@ int UDPSocket::SetNonBlockingMode(bool inShouldBeNonBlocking)
     }
 }
 
-UDPSocket::UDPSocket(SOCKET inSocket): mSocket(inSocket)
+int UDPSocket::SetReuseAddress(bool inIsEnabled)
+{
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_REUSEADDR, inIsEnabled ? 1 : 0, "UDPSocket::SetReuseAddress");
+}
+
+int UDPSocket::SetReusePort(bool inIsEnabled)
+{
+#ifdef SO_REUSEPORT
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_REUSEPORT, inIsEnabled ? 1 : 0, "UDPSocket::SetReusePort");
+#else
+    return -WSAEOPNOTSUPP;
+#endif
+}
+
+int UDPSocket::SetSendBufferSize(int inSize)
+{
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_SNDBUF, inSize, "UDPSocket::SetSendBufferSize");
+}
+
+int UDPSocket::SetReceiveBufferSize(int inSize)
+{
+    return SocketUtil::SetOption(mSocket, SOL_SOCKET, SO_RCVBUF, inSize, "UDPSocket::SetReceiveBufferSize");
+}
+
+int UDPSocket::GetSendBufferSize()
+{
+    return SocketUtil::GetOption(mSocket, SOL_SOCKET, SO_SNDBUF, "UDPSocket::GetSendBufferSize");
+}
+
+int UDPSocket::GetReceiveBufferSize()
+{
+    return SocketUtil::GetOption(mSocket, SOL_SOCKET, SO_RCVBUF, "UDPSocket::GetReceiveBufferSize");
+}
+
+UDPSocket::UDPSocket(SOCKET inSocket): mSocket(inSocket), mIsSegmentationOffloadEnabled(false)
 {
 }
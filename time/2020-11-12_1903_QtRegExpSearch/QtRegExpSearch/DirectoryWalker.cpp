@@ -0,0 +1,167 @@
+#include "DirectoryWalker.h"
+
+#include <QDir>
+#include <QFile>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+DirectoryWalker::DirectoryWalker(QStringList rootPaths, bool isStayOnFileSystem)
+    : m_isStayOnFileSystem(isStayOnFileSystem)
+    , m_currentRootDevice(0)
+    , m_duplicateCount(0)
+    , m_otherFileSystemCount(0)
+{
+    // pending directories are a stack, so roots are pushed in reverse order
+    for(int i = rootPaths.size() - 1; i >= 0; i--)
+    {
+        FileId rootId;
+        quint64 rootDevice = readFileId(rootPaths[i], rootId) ? rootId.device : 0;
+        m_pendingDirectories.append({rootPaths[i], rootDevice});
+    }
+}
+
+bool DirectoryWalker::hasNext()
+{
+    while(m_nextFile.isEmpty())
+    {
+        if(m_pCurrentDirectory && m_pCurrentDirectory->hasNext())
+        {
+            m_pCurrentDirectory->next();
+            QFileInfo fileInfo = m_pCurrentDirectory->fileInfo();
+            if(fileInfo.isDir())
+            {
+                m_pendingDirectories.append({fileInfo.filePath(), m_currentRootDevice});
+            }
+            else if(fileInfo.isFile() && !isVisitedFile(fileInfo))
+            {
+                m_nextFile = fileInfo.filePath();
+            }
+            continue;
+        }
+
+        if(m_pendingDirectories.isEmpty())
+        {
+            m_pCurrentDirectory.reset();
+            return false;
+        }
+
+        PendingDirectory directory = m_pendingDirectories.takeLast();
+        enterDirectory(directory.path, directory.rootDevice);
+    }
+    return true;
+}
+
+QString DirectoryWalker::next()
+{
+    hasNext();
+    QString filePath = m_nextFile;
+    m_nextFile.clear();
+    return filePath;
+}
+
+bool DirectoryWalker::readFileId(QString path, FileId & outId)
+{
+#ifdef Q_OS_WIN
+    // FILE_FLAG_BACKUP_SEMANTICS is required to open directories
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(path).utf16()),
+                                0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION info;
+    bool isOk = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if(!isOk)
+    {
+        return false;
+    }
+
+    outId.device = info.dwVolumeSerialNumber;
+    outId.inode = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+#else
+    // stat follows symlinks, so a link and its target get the same id
+    struct stat st;
+    if(::stat(QFile::encodeName(path).constData(), &st) != 0)
+    {
+        return false;
+    }
+
+    outId.device = st.st_dev;
+    outId.inode = st.st_ino;
+#endif
+    return true;
+}
+
+bool DirectoryWalker::isVisited(const FileId & id)
+{
+    auto key = qMakePair(id.device, id.inode);
+    if(m_visited.contains(key))
+    {
+        m_duplicateCount++;
+        return true;
+    }
+    m_visited.insert(key);
+    return false;
+}
+
+bool DirectoryWalker::isVisitedFile(const QFileInfo & fileInfo)
+{
+    // Every file is recorded, whichever of a plain name and a symlink to it comes first
+#ifdef Q_OS_WIN
+    // Opening every file to get its index is expensive on Windows and hard links are rare there,
+    // so files are told apart by path, a symlink by the path of its target
+    QString path = fileInfo.isSymLink() ? fileInfo.canonicalFilePath() : fileInfo.absoluteFilePath();
+    if(path.isEmpty())
+    {
+        return false;
+    }
+
+    QString key = QDir::cleanPath(path).toLower();
+    if(m_visitedFilePaths.contains(key))
+    {
+        m_duplicateCount++;
+        return true;
+    }
+    m_visitedFilePaths.insert(key);
+    return false;
+#else
+    FileId id;
+    if(!readFileId(fileInfo.filePath(), id))
+    {
+        return false;
+    }
+
+    return isVisited(id);
+#endif
+}
+
+void DirectoryWalker::enterDirectory(QString path, quint64 rootDevice)
+{
+    m_pCurrentDirectory.reset();
+
+    FileId id;
+    if(readFileId(path, id))
+    {
+        if(m_isStayOnFileSystem && id.device != rootDevice)
+        {
+            m_otherFileSystemCount++;
+            return;
+        }
+
+        if(isVisited(id))
+        {
+            return;
+        }
+    }
+
+    m_currentRootDevice = rootDevice;
+    m_pCurrentDirectory.reset(new QDirIterator(path, QDir::AllEntries | QDir::NoDotAndDotDot
+                                               | QDir::Hidden | QDir::System));
+}
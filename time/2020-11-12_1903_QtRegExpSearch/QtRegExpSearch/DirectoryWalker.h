@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+// Recursive file iterator over several root directories. Visited directories
+// and files are remembered by (device, inode), files on Windows by path, so
+// overlapping roots, bind mounts, symlink loops and links to files are walked only once.
+class DirectoryWalker
+{
+public:
+    DirectoryWalker(QStringList rootPaths, bool isStayOnFileSystem);
+
+    bool hasNext();
+    QString next();
+
+    int duplicateCount() const { return m_duplicateCount; }
+    int otherFileSystemCount() const { return m_otherFileSystemCount; }
+
+private:
+    struct FileId
+    {
+        quint64 device;
+        quint64 inode;
+    };
+
+    struct PendingDirectory
+    {
+        QString path;
+        quint64 rootDevice;
+    };
+
+    static bool readFileId(QString path, FileId & outId);
+    bool isVisited(const FileId & id);
+    bool isVisitedFile(const QFileInfo & fileInfo);
+    void enterDirectory(QString path, quint64 rootDevice);
+
+    bool m_isStayOnFileSystem;
+    QVector<PendingDirectory> m_pendingDirectories;
+    std::unique_ptr<QDirIterator> m_pCurrentDirectory;
+    quint64 m_currentRootDevice;
+    QSet<QPair<quint64, quint64>> m_visited;
+    // lower case, clean absolute paths of the files, only on Windows
+    QSet<QString> m_visitedFilePaths;
+    QString m_nextFile;
+    int m_duplicateCount;
+    int m_otherFileSystemCount;
+};
@@ -0,0 +1,139 @@
+#include "FileReplacer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace
+{
+
+QByteArray takeLineEnding(QByteArray & line)
+{
+    int endingSize = 0;
+    if(line.endsWith("\r\n"))
+    {
+        endingSize = 2;
+    }
+    else if(line.endsWith('\n') || line.endsWith('\r'))
+    {
+        endingSize = 1;
+    }
+
+    QByteArray ending = line.right(endingSize);
+    line.chop(endingSize);
+    return ending;
+}
+
+}
+
+namespace FileReplacer
+{
+
+ReplaceResult previewReplace(QString fileName, QRegExp lineRegExp, QString replaceTemplate,
+                             int maxPreviewLines)
+{
+    ReplaceResult result;
+    result.fileName = fileName;
+
+    QFile inputFile(fileName);
+    if(!inputFile.open(QIODevice::ReadOnly))
+    {
+        result.error = inputFile.errorString();
+        return result;
+    }
+
+    QFileInfo fileInfo(inputFile);
+    result.fileSize = fileInfo.size();
+    result.lastModified = fileInfo.lastModified();
+
+    int lineNumber = 1;
+    while(!inputFile.atEnd())
+    {
+        QByteArray rawLine = inputFile.readLine();
+        takeLineEnding(rawLine);
+
+        // the same decoding as QTextStream uses in the line search
+        QString line = QString::fromLocal8Bit(rawLine);
+        if(line.contains(lineRegExp))
+        {
+            QString replacedLine = line;
+            replacedLine.replace(lineRegExp, replaceTemplate);
+            if(replacedLine != line)
+            {
+                result.replacedLineCount++;
+                result.lineNumbers.append(lineNumber);
+                if(result.preview.size() < maxPreviewLines)
+                {
+                    result.preview.append({lineNumber, line, replacedLine});
+                }
+            }
+        }
+        lineNumber++;
+    }
+    return result;
+}
+
+ReplaceResult applyReplace(const ReplaceResult & preview, QRegExp lineRegExp, QString replaceTemplate)
+{
+    ReplaceResult result;
+    result.fileName = preview.fileName;
+
+    QFile inputFile(preview.fileName);
+    if(!inputFile.open(QIODevice::ReadOnly))
+    {
+        result.error = inputFile.errorString();
+        return result;
+    }
+
+    QFileInfo fileInfo(inputFile);
+    if(fileInfo.size() != preview.fileSize || fileInfo.lastModified() != preview.lastModified)
+    {
+        result.error = "File has been changed since the preview";
+        return result;
+    }
+
+    QSaveFile outputFile(preview.fileName);
+    if(!outputFile.open(QIODevice::WriteOnly))
+    {
+        result.error = outputFile.errorString();
+        return result;
+    }
+
+    int lineNumber = 1;
+    auto nextReplacedLine = preview.lineNumbers.cbegin();
+    while(!inputFile.atEnd())
+    {
+        QByteArray rawLine = inputFile.readLine();
+        QByteArray lineEnding = takeLineEnding(rawLine);
+
+        if(nextReplacedLine != preview.lineNumbers.cend() && *nextReplacedLine == lineNumber)
+        {
+            QString line = QString::fromLocal8Bit(rawLine);
+            line.replace(lineRegExp, replaceTemplate);
+            rawLine = line.toLocal8Bit();
+            result.replacedLineCount++;
+            ++nextReplacedLine;
+        }
+
+        // untouched lines are written back byte to byte
+        outputFile.write(rawLine);
+        outputFile.write(lineEnding);
+        lineNumber++;
+    }
+    inputFile.close();
+
+    if(result.replacedLineCount == 0)
+    {
+        outputFile.cancelWriting();
+        return result;
+    }
+
+    // closes the temporary file and renames it over the original one
+    if(!outputFile.commit())
+    {
+        result.error = outputFile.errorString();
+    }
+    return result;
+}
+
+}
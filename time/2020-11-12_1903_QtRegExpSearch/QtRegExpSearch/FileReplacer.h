@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QDateTime>
+#include <QRegExp>
+#include <QString>
+#include <QVector>
+
+// Replaces line mask matches in the file. The file is streamed line by line
+// into a temporary file which atomically replaces the original one, so memory
+// usage doesn't depend on the file size and the file is never left half written.
+namespace FileReplacer
+{
+
+struct ReplacedLine
+{
+    int lineNumber;
+    QString before;
+    QString after;
+};
+
+struct ReplaceResult
+{
+    QString fileName;
+    int replacedLineCount = 0;
+    QVector<ReplacedLine> preview; // first replaced lines only
+    QVector<int> lineNumbers; // all replaced lines
+    // the file as the preview has seen it
+    qint64 fileSize = 0;
+    QDateTime lastModified;
+    QString error;
+};
+
+// replaceTemplate may refer captured texts of the line mask as \1 ... \9.
+// The file is not modified, only the lines to replace are found.
+ReplaceResult previewReplace(QString fileName, QRegExp lineRegExp, QString replaceTemplate,
+                             int maxPreviewLines);
+
+// Rewrites the lines found by previewReplace, other lines are copied without matching.
+// Fails when the file has been changed since the preview.
+ReplaceResult applyReplace(const ReplaceResult & preview, QRegExp lineRegExp, QString replaceTemplate);
+
+}
@@ -0,0 +1,113 @@
+#include "FuzzyMatcher.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+
+const int c_wordSize = 64;
+
+// One column step of Myers' algorithm for a 64 row block (G. Myers, 1999, fig. 8).
+// hin is the score difference coming from the block above, the returned value goes below.
+inline int advanceBlock(quint64 & pv, quint64 & mv, quint64 eq, quint64 highBit, int hin)
+{
+    quint64 xv = eq | mv;
+    if(hin < 0)
+    {
+        eq |= 1;
+    }
+    quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+    quint64 ph = mv | ~(xh | pv);
+    quint64 mh = pv & xh;
+
+    int hout = 0;
+    if(ph & highBit)
+    {
+        hout = 1;
+    }
+    else if(mh & highBit)
+    {
+        hout = -1;
+    }
+
+    ph <<= 1;
+    mh <<= 1;
+    if(hin < 0)
+    {
+        mh |= 1;
+    }
+    else if(hin > 0)
+    {
+        ph |= 1;
+    }
+
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+}
+
+FuzzyMatcher::FuzzyMatcher(QByteArray pattern, int maxDistance, Qt::CaseSensitivity caseSensitivity)
+    : m_patternSize(pattern.size())
+    , m_maxDistance(maxDistance)
+    , m_blockCount((pattern.size() + c_wordSize - 1) / c_wordSize)
+    , m_lastBitMask(pattern.isEmpty() ? 1 : quint64(1) << ((pattern.size() - 1) % c_wordSize))
+    , m_peq(256 * std::max(m_blockCount, 1), 0)
+    , m_pv(m_blockCount)
+    , m_mv(m_blockCount)
+{
+    for(int i = 0; i < m_patternSize; i++)
+    {
+        unsigned char c = static_cast<unsigned char>(pattern[i]);
+        quint64 bit = quint64(1) << (i % c_wordSize);
+        int block = i / c_wordSize;
+
+        m_peq[c * m_blockCount + block] |= bit;
+        if(caseSensitivity == Qt::CaseInsensitive)
+        {
+            m_peq[std::tolower(c) * m_blockCount + block] |= bit;
+            m_peq[std::toupper(c) * m_blockCount + block] |= bit;
+        }
+    }
+}
+
+int FuzzyMatcher::match(const char * line, int size)
+{
+    if(m_patternSize == 0)
+    {
+        return 0;
+    }
+
+    std::fill(m_pv.begin(), m_pv.end(), ~quint64(0));
+    std::fill(m_mv.begin(), m_mv.end(), 0);
+
+    // Score is the distance of the whole pattern to the best substring ending at the current byte.
+    // A match may start anywhere, so the top row is always zero and no delta enters the first block.
+    int score = m_patternSize;
+    int bestScore = m_patternSize;
+    const int lastBlock = m_blockCount - 1;
+
+    for(int j = 0; j < size; j++)
+    {
+        const quint64 * eq = &m_peq[static_cast<unsigned char>(line[j]) * m_blockCount];
+        int carry = 0;
+        for(int b = 0; b < lastBlock; b++)
+        {
+            carry = advanceBlock(m_pv[b], m_mv[b], eq[b], quint64(1) << (c_wordSize - 1), carry);
+        }
+        score += advanceBlock(m_pv[lastBlock], m_mv[lastBlock], eq[lastBlock], m_lastBitMask, carry);
+
+        if(score < bestScore)
+        {
+            bestScore = score;
+            if(bestScore == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return bestScore <= m_maxDistance ? bestScore : -1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <vector>
+
+// Approximate substring matching with Myers' bit-parallel algorithm.
+// Every 64 pattern bytes are processed as one machine word, so a line is
+// checked in O(ceil(m / 64) * n) whatever the allowed number of edits is.
+// The pattern and the lines are compared as raw bytes.
+class FuzzyMatcher
+{
+public:
+    FuzzyMatcher(QByteArray pattern, int maxDistance, Qt::CaseSensitivity caseSensitivity);
+
+    // Returns the minimal edit distance between the pattern and any substring
+    // of the line, or -1 if it is bigger than maxDistance.
+    int match(const char * line, int size);
+
+private:
+    int m_patternSize;
+    int m_maxDistance;
+    int m_blockCount;
+    quint64 m_lastBitMask;
+    std::vector<quint64> m_peq; // 256 * m_blockCount masks of pattern positions for every byte
+    std::vector<quint64> m_pv;
+    std::vector<quint64> m_mv;
+};
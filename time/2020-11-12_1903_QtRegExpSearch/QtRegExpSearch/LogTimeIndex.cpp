@@ -0,0 +1,308 @@
+#include "LogTimeIndex.h"
+
+#include <QByteArray>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+const qint64 c_msInDay = 24 * 60 * 60 * 1000;
+const int c_probeCount = 16;
+const int c_maxLinesWithoutTimestamp = 64;
+
+struct Timestamp
+{
+    bool hasDate = false;
+    qint64 days = 0;
+    qint64 msOfDay = 0;
+    qint64 precision = 1; // duration of the last parsed field in ms
+};
+
+bool readNumber(const char *& p, const char * end, int digits, int & out)
+{
+    if(end - p < digits)
+    {
+        return false;
+    }
+
+    out = 0;
+    for(int i = 0; i < digits; i++)
+    {
+        if(p[i] < '0' || p[i] > '9')
+        {
+            return false;
+        }
+        out = out * 10 + (p[i] - '0');
+    }
+    p += digits;
+    return true;
+}
+
+bool readSymbol(const char *& p, const char * end, char symbol)
+{
+    if(p < end && *p == symbol)
+    {
+        p++;
+        return true;
+    }
+    return false;
+}
+
+// http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+qint64 daysFromCivil(qint64 y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const qint64 era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<qint64>(doe) - 719468;
+}
+
+bool parseTimestamp(const char * begin, const char * end, Timestamp & out)
+{
+    const char * p = begin;
+    readSymbol(p, end, '[');
+
+    int year, month, day;
+    const char * dateBegin = p;
+    if(readNumber(p, end, 4, year) && readSymbol(p, end, '-')
+            && readNumber(p, end, 2, month) && readSymbol(p, end, '-')
+            && readNumber(p, end, 2, day))
+    {
+        if(month < 1 || month > 12 || day < 1 || day > 31)
+        {
+            return false;
+        }
+        if(!readSymbol(p, end, ' ') && !readSymbol(p, end, 'T'))
+        {
+            return false;
+        }
+        out.hasDate = true;
+        out.days = daysFromCivil(year, month, day);
+    }
+    else
+    {
+        p = dateBegin;
+        out.hasDate = false;
+        out.days = 0;
+    }
+
+    int hours, minutes, seconds = 0, ms = 0;
+    if(!readNumber(p, end, 2, hours) || !readSymbol(p, end, ':') || !readNumber(p, end, 2, minutes))
+    {
+        return false;
+    }
+    out.precision = 60 * 1000;
+
+    if(readSymbol(p, end, ':'))
+    {
+        if(!readNumber(p, end, 2, seconds))
+        {
+            return false;
+        }
+        out.precision = 1000;
+
+        if(readSymbol(p, end, '.') || readSymbol(p, end, ','))
+        {
+            int scale = 100;
+            while(p < end && *p >= '0' && *p <= '9')
+            {
+                ms += (*p - '0') * scale;
+                scale /= 10;
+                p++;
+            }
+            out.precision = 1;
+        }
+    }
+
+    if(hours > 23 || minutes > 59 || seconds > 60)
+    {
+        return false;
+    }
+
+    out.msOfDay = ((hours * 60 + minutes) * 60 + seconds) * 1000 + ms;
+    return true;
+}
+
+qint64 timestampKey(const Timestamp & stamp, bool withDate)
+{
+    return withDate ? stamp.days * c_msInDay + stamp.msOfDay : stamp.msOfDay;
+}
+
+qint64 lineEnd(const uchar * data, qint64 size, qint64 pos)
+{
+    const void * nl = std::memchr(data + pos, '\n', static_cast<size_t>(size - pos));
+    return nl ? static_cast<const uchar *>(nl) - data : size;
+}
+
+qint64 lineStartFrom(const uchar * data, qint64 size, qint64 pos)
+{
+    if(pos <= 0)
+    {
+        return 0;
+    }
+    if(pos >= size)
+    {
+        return size;
+    }
+    if(data[pos - 1] == '\n')
+    {
+        return pos;
+    }
+    qint64 end = lineEnd(data, size, pos);
+    return end < size ? end + 1 : size;
+}
+
+// Returns the start of the first line at or after pos which has timestamp, or size.
+// Lines without timestamp (e.g. stack traces) belong to the previous record and are skipped.
+qint64 nextStampedLine(const uchar * data, qint64 size, qint64 pos, bool withDate,
+                       int maxLines, qint64 & outKey)
+{
+    qint64 lineStart = lineStartFrom(data, size, pos);
+    for(int i = 0; lineStart < size && (maxLines < 0 || i < maxLines); i++)
+    {
+        qint64 end = lineEnd(data, size, lineStart);
+        if(LogTimeIndex::parseLineTimestamp(reinterpret_cast<const char *>(data + lineStart),
+                                            reinterpret_cast<const char *>(data + end),
+                                            withDate, outKey))
+        {
+            return lineStart;
+        }
+        lineStart = end + 1;
+    }
+    return size;
+}
+
+bool isTimeOrdered(const uchar * data, qint64 size, bool withDate)
+{
+    qint64 previousKey = std::numeric_limits<qint64>::min();
+    for(int i = 0; i <= c_probeCount; i++)
+    {
+        qint64 probe = size / c_probeCount * i;
+        qint64 key;
+        qint64 lineStart = nextStampedLine(data, size, probe, withDate, c_maxLinesWithoutTimestamp, key);
+        if(lineStart == size)
+        {
+            // probe landed behind the last record or inside a long multiline record
+            if(i == 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        if(key < previousKey)
+        {
+            return false;
+        }
+        previousKey = key;
+    }
+    return true;
+}
+
+// Returns the first stamped line which timestamp is not less than key.
+qint64 lowerBound(const uchar * data, qint64 size, qint64 key, bool withDate)
+{
+    qint64 lo = 0;
+    qint64 hi = size;
+    while(lo < hi)
+    {
+        qint64 mid = lo + (hi - lo) / 2;
+        qint64 midKey;
+        qint64 lineStart = nextStampedLine(data, size, mid, withDate, -1, midKey);
+        if(lineStart == size || midKey >= key)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = std::min(lineEnd(data, size, lineStart) + 1, hi);
+        }
+    }
+    qint64 unused;
+    return nextStampedLine(data, size, lo, withDate, -1, unused);
+}
+
+}
+
+namespace LogTimeIndex
+{
+
+bool parseTimeWindow(QString fromStr, QString toStr, TimeWindow & outWindow, QString & outError)
+{
+    QByteArray from = fromStr.trimmed().toLatin1();
+    QByteArray to = toStr.trimmed().toLatin1();
+
+    Timestamp fromStamp;
+    Timestamp toStamp;
+    bool hasFrom = !from.isEmpty();
+    bool hasTo = !to.isEmpty();
+
+    if(!hasFrom && !hasTo)
+    {
+        outError = "both time range bounds are empty";
+        return false;
+    }
+    if(hasFrom && !parseTimestamp(from.constData(), from.constData() + from.size(), fromStamp))
+    {
+        outError = QString("can't parse '%1'").arg(fromStr);
+        return false;
+    }
+    if(hasTo && !parseTimestamp(to.constData(), to.constData() + to.size(), toStamp))
+    {
+        outError = QString("can't parse '%1'").arg(toStr);
+        return false;
+    }
+    if(hasFrom && hasTo && fromStamp.hasDate != toStamp.hasDate)
+    {
+        outError = "both time range bounds should have date or both should not";
+        return false;
+    }
+
+    outWindow.hasDate = hasFrom ? fromStamp.hasDate : toStamp.hasDate;
+    outWindow.from = hasFrom ? timestampKey(fromStamp, outWindow.hasDate)
+                             : std::numeric_limits<qint64>::min();
+    // "to" bound is inclusive with its precision: 14:05 means up to 14:05:59.999
+    outWindow.to = hasTo ? timestampKey(toStamp, outWindow.hasDate) + toStamp.precision - 1
+                         : std::numeric_limits<qint64>::max() - 1;
+
+    if(outWindow.from > outWindow.to)
+    {
+        outError = "time range start is after its end";
+        return false;
+    }
+    return true;
+}
+
+bool parseLineTimestamp(const char * begin, const char * end, bool withDate, qint64 & outKey)
+{
+    Timestamp stamp;
+    if(!parseTimestamp(begin, end, stamp) || (withDate && !stamp.hasDate))
+    {
+        return false;
+    }
+    outKey = timestampKey(stamp, withDate);
+    return true;
+}
+
+bool isInTimeWindow(qint64 key, const TimeWindow & window)
+{
+    return key >= window.from && key <= window.to;
+}
+
+bool findTimeWindowRange(const uchar * data, qint64 size, const TimeWindow & window,
+                         qint64 & outBegin, qint64 & outEnd)
+{
+    if(data == nullptr || size <= 0 || !isTimeOrdered(data, size, window.hasDate))
+    {
+        return false;
+    }
+
+    outBegin = lowerBound(data, size, window.from, window.hasDate);
+    outEnd = lowerBound(data, size, window.to + 1, window.hasDate);
+    return true;
+}
+
+}
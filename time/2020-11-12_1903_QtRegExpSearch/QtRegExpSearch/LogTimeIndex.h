@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+// Helpers to search a time window in log files which lines start with timestamp.
+// Accepted timestamp forms: "hh:mm[:ss[.zzz]]" and "yyyy-MM-dd[ T]hh:mm[:ss[.zzz]]",
+// optionally preceded by '['.
+namespace LogTimeIndex
+{
+
+struct TimeWindow
+{
+    // Milliseconds since 1970-01-01 when hasDate is set, milliseconds of the day otherwise.
+    qint64 from = 0;
+    qint64 to = 0; // inclusive
+    bool hasDate = false;
+};
+
+bool parseTimeWindow(QString fromStr, QString toStr, TimeWindow & outWindow, QString & outError);
+
+bool parseLineTimestamp(const char * begin, const char * end, bool withDate, qint64 & outKey);
+
+bool isInTimeWindow(qint64 key, const TimeWindow & window);
+
+// Finds [outBegin, outEnd) byte range of the lines which belong to the time window.
+// Binary search is used, so only O(log n) lines are touched. Returns false when
+// data does not look like time ordered log, in this case the caller should scan all lines.
+bool findTimeWindowRange(const uchar * data, qint64 size, const TimeWindow & window,
+                         qint64 & outBegin, qint64 & outEnd);
+
+}
@@ -9,9 +9,15 @@
 #include <QLabel>
 #include <QDebug>
 #include <QProcess>
+#include <QCloseEvent>
+#include <QtConcurrent>
+#include <cstring>
 #include "MainWindow.h"
 #include "ui_mainwindow.h"
 #include "MyHelper.hpp"
+#include "FileReplacer.h"
+#include "FuzzyMatcher.h"
+#include "DirectoryWalker.h"
 
 using namespace MyHelper;
 
@@ -78,6 +84,28 @@ MainWindow::MainWindow(QWidget *parent)
     QObject::connect(ui->checkBoxWordWrapEnabled, SIGNAL(stateChanged(int)),
                      this, SLOT(slotWordWrapStateChanged(int)));
 
+    QObject::connect(ui->checkBoxIsLineTimeRangeEnabled, SIGNAL(stateChanged(int)),
+                     this, SLOT(slotLineTimeRangeStateChanged(int)));
+
+    QObject::connect(ui->checkBoxIsLineFuzzyModeEnabled, SIGNAL(stateChanged(int)),
+                     this, SLOT(slotLineFuzzyModeStateChanged(int)));
+
+    QObject::connect(ui->pushButtonReplacePreview, SIGNAL(clicked()),
+                     this, SLOT(slotReplacePreview()));
+
+    QObject::connect(ui->pushButtonReplace, SIGNAL(clicked()),
+                     this, SLOT(slotReplace()));
+
+    m_pReplaceWatcher = new QFutureWatcher<FileReplacer::ReplaceResult>(this);
+    m_isReplaceApplying = false;
+    m_isReplaceConfirmNeeded = false;
+    m_replaceFileCount = 0;
+
+    QObject::connect(m_pReplaceWatcher, SIGNAL(progressValueChanged(int)),
+                     this, SLOT(slotReplaceProgress(int)));
+
+    QObject::connect(m_pReplaceWatcher, SIGNAL(finished()),
+                     this, SLOT(slotReplaceFinished()));
 
     m_pSettings = new QSettings(this);
     m_defaultPresetName = "DefaultPreset";
@@ -99,15 +127,23 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+void MainWindow::closeEvent(QCloseEvent * event)
+{
+    // a file which is being rewritten is completed, the rest are left untouched
+    m_pReplaceWatcher->cancel();
+    m_pReplaceWatcher->waitForFinished();
+    QMainWindow::closeEvent(event);
+}
+
 void MainWindow::handleError(QString msg)
 {
     QMessageBox::warning(this, "Warning", msg);
 }
 
-void MainWindow::startSearchInDirectory(QString dirStr, QRegExp fileRegExp, QRegExp fileIgnoreRegExp)
+void MainWindow::startSearchInDirectory(QStringList rootDirs, QRegExp fileRegExp, QRegExp fileIgnoreRegExp)
 {
     ui->textEditFileList->clear();
-    QDirIterator dirIterator(dirStr, QDirIterator::Subdirectories);
+    DirectoryWalker dirIterator(rootDirs, ui->checkBoxStayOnFileSystem->isChecked());
     int scanFileNumber = 0;
     int foundFileNumber = 0;
     int ignoredFileNumber = 0;
@@ -142,7 +178,7 @@ void MainWindow::startSearchInDirectory(QString dirStr, QRegExp fileRegExp, QReg
             QString statusBarMessage;
             QTextStream out(&statusBarMessage);
             out << "File search. Scanned: " << scanFileNumber << "; Found: " << foundFileNumber
-                << "; Ignored: " << ignoredFileNumber;
+                << "; Ignored: " << ignoredFileNumber << "; Duplicates: " << dirIterator.duplicateCount();
             m_pStatusBarLabel->setText(statusBarMessage);
         }
     }
@@ -158,6 +194,8 @@ void MainWindow::setSearchActiveStatus(bool b)
     ui->buttonFindFiles->setEnabled(!b);
     ui->buttonFindLines->setEnabled(!b);
     ui->buttonComplexFind->setEnabled(!b);
+    ui->pushButtonReplacePreview->setEnabled(!b);
+    ui->pushButtonReplace->setEnabled(!b);
     ui->buttonStop->setEnabled(b);
 
     if(b == true)
@@ -175,10 +213,18 @@ void MainWindow::slotBrowseRootDirectory()
                                    QFileDialog::ShowDirsOnly
                                    | QFileDialog::DontResolveSymlinks);
     dir = QDir::toNativeSeparators(dir);
-    if(!dir.isEmpty())
+    if(dir.isEmpty())
     {
-        ui->lineEditRootPath->setText(dir);
+        return;
+    }
+
+    // the chosen directory is added to the roots, the others stay
+    QStringList rootPathList = getRootPathList();
+    if(!rootPathList.contains(dir))
+    {
+        rootPathList.append(dir);
     }
+    ui->lineEditRootPath->setText(rootPathList.join("; "));
 }
 
 void MainWindow::slotStartFileSearch()
@@ -202,21 +248,32 @@ void MainWindow::slotStartLineSearch()
         return;
     }
 
-    QRegExp lineRegExp = getLineRegExp();
-
-    if(lineRegExp.isEmpty())
+    if(ui->checkBoxIsLineFuzzyModeEnabled->isChecked())
     {
-        handleError(QString("Line reg exp is empty"));
+        startFuzzyLineSearch(fileList);
         return;
     }
 
-    if(!lineRegExp.isValid())
+    QRegExp lineRegExp = getLineRegExp();
+    if(!validateLineRegExp(lineRegExp))
     {
-        handleError(QString("Line reg exp is not valid: %1")
-                    .arg(lineRegExp.errorString()));
         return;
     }
 
+    LogTimeIndex::TimeWindow timeWindow;
+    bool isTimeRangeActive = ui->checkBoxIsLineTimeRangeEnabled->isChecked();
+    if(isTimeRangeActive)
+    {
+        QString timeRangeError;
+        if(!LogTimeIndex::parseTimeWindow(ui->lineEditLineTimeFrom->text(),
+                                          ui->lineEditLineTimeTo->text(),
+                                          timeWindow, timeRangeError))
+        {
+            handleError(QString("Time range is not valid: %1").arg(timeRangeError));
+            return;
+        }
+    }
+
     setSearchActiveStatus(true);
     setFileAndLineTabActive();
 
@@ -233,7 +290,14 @@ void MainWindow::slotStartLineSearch()
         {
             break;
         }
-        searchLinesInTheFile(fileName, lineRegExp);
+        if(isTimeRangeActive)
+        {
+            searchLinesInTheFileTimeRange(fileName, lineRegExp, timeWindow);
+        }
+        else
+        {
+            searchLinesInTheFile(fileName, lineRegExp);
+        }
 
         QString statusBarMessage;
         QTextStream out(&statusBarMessage);
@@ -254,6 +318,7 @@ void MainWindow::slotComplexFind()
 void MainWindow::slotStopSearch()
 {
     m_stopSearchFlag = true;
+    m_pReplaceWatcher->cancel();
 }
 
 void MainWindow::slotSaveAsPreset()
@@ -338,6 +403,7 @@ void MainWindow::slotFileListAsSourceStateChanged(int)
 
     ui->lineEditRootPath->setEnabled(useSearchInFileSystem);
     ui->buttonRootPathBrowse->setEnabled(useSearchInFileSystem);
+    ui->checkBoxStayOnFileSystem->setEnabled(useSearchInFileSystem);
 }
 
 void MainWindow::slotShowIgnoreFiltersStateChanged(int state)
@@ -409,6 +475,107 @@ void MainWindow::slotWordWrapStateChanged(int)
     ui->textEditResultFileList->setWordWrapMode(wordWrapMode);
 }
 
+void MainWindow::slotLineTimeRangeStateChanged(int)
+{
+    bool isTimeRangeActive = ui->checkBoxIsLineTimeRangeEnabled->isChecked();
+
+    ui->lineEditLineTimeFrom->setEnabled(isTimeRangeActive);
+    ui->lineEditLineTimeTo->setEnabled(isTimeRangeActive);
+}
+
+void MainWindow::slotLineFuzzyModeStateChanged(int)
+{
+    bool isFuzzyModeActive = ui->checkBoxIsLineFuzzyModeEnabled->isChecked();
+
+    ui->spinBoxLineFuzzyMaxDistance->setEnabled(isFuzzyModeActive);
+    ui->checkBoxIsLineRegExpModeEnabled->setEnabled(!isFuzzyModeActive);
+}
+
+void MainWindow::slotReplacePreview()
+{
+    startReplace(false);
+}
+
+void MainWindow::slotReplace()
+{
+    startReplace(true);
+}
+
+void MainWindow::slotReplaceProgress(int progress)
+{
+    QString statusBarMessage;
+    QTextStream out(&statusBarMessage);
+    out << (m_isReplaceApplying ? "Replace. " : "Replace preview. ")
+        << "File " << progress << "/" << m_replaceFileCount;
+    m_pStatusBarLabel->setText(statusBarMessage);
+}
+
+void MainWindow::slotReplaceFinished()
+{
+    QList<FileReplacer::ReplaceResult> results = m_pReplaceWatcher->future().results();
+    int replacedLineNumber = showReplaceResults(results);
+    setReplaceActiveStatus(false);
+
+    if(m_isReplaceApplying)
+    {
+        return;
+    }
+
+    if(replacedLineNumber == 0)
+    {
+        handleError("Nothing to replace");
+        return;
+    }
+
+    if(!m_isReplaceConfirmNeeded || m_pReplaceWatcher->isCanceled())
+    {
+        return;
+    }
+
+    auto answer = QMessageBox::question(this, "Replace",
+                                        "Replace the lines shown in the preview?");
+    if(answer != QMessageBox::Yes)
+    {
+        return;
+    }
+
+    // only the lines found by the preview are rewritten, other files are not opened again
+    QList<FileReplacer::ReplaceResult> previews;
+    for(const FileReplacer::ReplaceResult & result : results)
+    {
+        if(result.error.isEmpty() && result.replacedLineCount > 0)
+        {
+            previews.append(result);
+        }
+    }
+
+    m_isReplaceApplying = true;
+    m_replaceFileCount = previews.count();
+    setReplaceActiveStatus(true);
+
+    QRegExp lineRegExp = m_replaceLineRegExp;
+    QString replaceTemplate = m_replaceTemplate;
+    std::function<FileReplacer::ReplaceResult(const FileReplacer::ReplaceResult &)> applyFunction =
+            [=](const FileReplacer::ReplaceResult & preview)
+    {
+        return FileReplacer::applyReplace(preview, lineRegExp, replaceTemplate);
+    };
+    m_pReplaceWatcher->setFuture(QtConcurrent::mapped(previews, applyFunction));
+}
+
+void MainWindow::setReplaceActiveStatus(bool b)
+{
+    setSearchActiveStatus(b);
+
+    // the masks, the template and the presets stay as the running replace has taken them
+    ui->groupBox_3->setEnabled(!b);
+    ui->groupBox->setEnabled(!b);
+    ui->groupBoxFileIgnoreMask->setEnabled(!b);
+    ui->groupBox_4->setEnabled(!b);
+    ui->lineEditReplaceTemplate->setEnabled(!b);
+    ui->tabPresets->setEnabled(!b);
+}
+
 void MainWindow::setFileTabActive()
 {
     ui->tabWidget->setCurrentWidget(ui->tabFileList);
@@ -459,6 +626,7 @@ void MainWindow::writePresetSettings(QString presetName)
 {
     bool fileListAsSourceFlag = ui->checkBoxUseFileListAsSource->isChecked();
     QString rootPath = ui->lineEditRootPath->text();
+    bool stayOnFileSystem = ui->checkBoxStayOnFileSystem->isChecked();
     QString fileRegExp = ui->lineEditFileRegExp->text();
     QString fileIgnoreExp = ui->lineEditFileIgnoreRegExp->text();
     QString lineRegExp = ui->lineEditLineRegExp->text();
@@ -468,11 +636,18 @@ void MainWindow::writePresetSettings(QString presetName)
     bool fileCaseSensitiveMode = ui->checkBoxIsFileRegExpCaseSensitive->isChecked();
     bool fileIgnoreCaseSensitiveMode = ui->checkBoxIsFileIgnoreRegExpCaseSensitive->isChecked();
     bool lineCaseSensitiveMode = ui->checkBoxIsLineRegExpCaseSensitive->isChecked();
+    bool lineTimeRangeMode = ui->checkBoxIsLineTimeRangeEnabled->isChecked();
+    QString lineTimeFrom = ui->lineEditLineTimeFrom->text();
+    QString lineTimeTo = ui->lineEditLineTimeTo->text();
+    QString replaceTemplate = ui->lineEditReplaceTemplate->text();
+    bool lineFuzzyMode = ui->checkBoxIsLineFuzzyModeEnabled->isChecked();
+    int lineFuzzyMaxDistance = ui->spinBoxLineFuzzyMaxDistance->value();
 
     m_pSettings->beginGroup(m_presetsGroup);
     m_pSettings->beginGroup(presetName);
     m_pSettings->setValue("fileListAsSourceFlag", fileListAsSourceFlag);
     m_pSettings->setValue("rootPath", rootPath);
+    m_pSettings->setValue("stayOnFileSystem", stayOnFileSystem);
     m_pSettings->setValue("fileRegExp", fileRegExp);
     m_pSettings->setValue("fileIgnoreRegExp", fileIgnoreExp);
     m_pSettings->setValue("lineRegExp", lineRegExp);
@@ -482,6 +657,12 @@ void MainWindow::writePresetSettings(QString presetName)
     m_pSettings->setValue("fileCaseSensitiveMode", fileCaseSensitiveMode);
     m_pSettings->setValue("fileIgnoreCaseSensitiveMode", fileIgnoreCaseSensitiveMode);
     m_pSettings->setValue("lineCaseSensitiveMode", lineCaseSensitiveMode);
+    m_pSettings->setValue("lineTimeRangeMode", lineTimeRangeMode);
+    m_pSettings->setValue("lineTimeFrom", lineTimeFrom);
+    m_pSettings->setValue("lineTimeTo", lineTimeTo);
+    m_pSettings->setValue("replaceTemplate", replaceTemplate);
+    m_pSettings->setValue("lineFuzzyMode", lineFuzzyMode);
+    m_pSettings->setValue("lineFuzzyMaxDistance", lineFuzzyMaxDistance);
     m_pSettings->endGroup();
     m_pSettings->endGroup();
 }
@@ -494,6 +675,7 @@ void MainWindow::readPresetSettings(QString presetName)
     m_pSettings->beginGroup(presetName);
     bool fileListAsSourceFlag = m_pSettings->value("fileListAsSourceFlag", false).value<bool>();
     QString rootPath = m_pSettings->value("rootPath", QCoreApplication::applicationDirPath()).value<QString>();
+    bool stayOnFileSystem = m_pSettings->value("stayOnFileSystem", false).value<bool>();
     QString fileRegExp = m_pSettings->value("fileRegExp", "").value<QString>();
     QString fileIgnoreRegExp = m_pSettings->value("fileIgnoreRegExp", "").value<QString>();
     QString lineRegExp = m_pSettings->value("lineRegExp", "").value<QString>();
@@ -503,11 +685,18 @@ void MainWindow::readPresetSettings(QString presetName)
     bool fileCaseSensitiveMode = m_pSettings->value("fileCaseSensitiveMode", false).value<bool>();
     bool fileIgnoreCaseSensitiveMode = m_pSettings->value("fileIgnoreCaseSensitiveMode", false).value<bool>();
     bool lineCaseSensitiveMode = m_pSettings->value("lineCaseSensitiveMode", false).value<bool>();
+    bool lineTimeRangeMode = m_pSettings->value("lineTimeRangeMode", false).value<bool>();
+    QString lineTimeFrom = m_pSettings->value("lineTimeFrom", "").value<QString>();
+    QString lineTimeTo = m_pSettings->value("lineTimeTo", "").value<QString>();
+    QString replaceTemplate = m_pSettings->value("replaceTemplate", "").value<QString>();
+    bool lineFuzzyMode = m_pSettings->value("lineFuzzyMode", false).value<bool>();
+    int lineFuzzyMaxDistance = m_pSettings->value("lineFuzzyMaxDistance", 1).value<int>();
     m_pSettings->endGroup();
     m_pSettings->endGroup();
 
     ui->checkBoxUseFileListAsSource->setChecked(fileListAsSourceFlag);
     ui->lineEditRootPath->setText(rootPath);
+    ui->checkBoxStayOnFileSystem->setChecked(stayOnFileSystem);
     ui->lineEditFileRegExp->setText(fileRegExp);
     ui->lineEditFileIgnoreRegExp->setText(fileIgnoreRegExp);
     ui->lineEditLineRegExp->setText(lineRegExp);
@@ -517,7 +706,14 @@ void MainWindow::readPresetSettings(QString presetName)
     ui->checkBoxIsFileRegExpCaseSensitive->setChecked(fileCaseSensitiveMode);
     ui->checkBoxIsFileIgnoreRegExpCaseSensitive->setChecked(fileIgnoreCaseSensitiveMode);
     ui->checkBoxIsLineRegExpCaseSensitive->setChecked(lineCaseSensitiveMode);
-
+    ui->checkBoxIsLineTimeRangeEnabled->setChecked(lineTimeRangeMode);
+    ui->lineEditLineTimeFrom->setText(lineTimeFrom);
+    ui->lineEditLineTimeTo->setText(lineTimeTo);
+    slotLineTimeRangeStateChanged(0);
+    ui->lineEditReplaceTemplate->setText(replaceTemplate);
+    ui->checkBoxIsLineFuzzyModeEnabled->setChecked(lineFuzzyMode);
+    ui->spinBoxLineFuzzyMaxDistance->setValue(lineFuzzyMaxDistance);
+    slotLineFuzzyModeStateChanged(0);
 }
 
 void MainWindow::readPresetNameSettings()
@@ -545,6 +741,21 @@ QStringList MainWindow::getFileList()
     return fileList;
 }
 
+QStringList MainWindow::getRootPathList()
+{
+    // several roots are separated by ';' on all platforms
+    QStringList rootPathList;
+    for(auto rootPath : ui->lineEditRootPath->text().split(';', Qt::SkipEmptyParts))
+    {
+        rootPath = rootPath.trimmed();
+        if(!rootPath.isEmpty())
+        {
+            rootPathList.append(rootPath);
+        }
+    }
+    return rootPathList;
+}
+
 QRegExp MainWindow::getFileRegExp()
 {
     QRegExp fileRegExp(ui->lineEditFileRegExp->text());
@@ -605,47 +816,375 @@ void MainWindow::searchLinesInTheFile(QString fileName, QRegExp lineRegExp)
             QString line = textFileStream.readLine();
             if(line.contains(lineRegExp))
             {
-                if(!isAlreadyFoundInThisFile)
-                {
-                    ui->textEditLineList->append(" ");
+                onLineFound(fileName, QString::number(lineNumber), line, !isAlreadyFoundInThisFile);
+                isAlreadyFoundInThisFile = true;
+            }
+            lineNumber++;
+        }
+        inputFile.close();
+    }
+}
 
-                    QTextCharFormat fmt;
-                    QTextCursor cursor = ui->textEditLineList->textCursor();
+void MainWindow::searchLinesInTheFileTimeRange(QString fileName, QRegExp lineRegExp,
+                                               const LogTimeIndex::TimeWindow & timeWindow)
+{
+    QFile inputFile(fileName);
+    if (!inputFile.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
 
-                    // new color
-                    fmt.setBackground(Qt::lightGray);
-                    cursor.mergeCharFormat(fmt);
-                    ui->textEditLineList->mergeCurrentCharFormat(fmt);
+    const qint64 fileSize = inputFile.size();
+    const uchar * data = fileSize > 0 ? inputFile.map(0, fileSize) : nullptr;
+    if(data == nullptr)
+    {
+        return;
+    }
 
-                    ui->textEditLineList->append(QString("%1").arg(fileName));
-                    ui->textEditResultFileList->append(fileName);
+    // For time ordered logs only the lines of the window are read.
+    // Line numbers are unknown without reading the whole prefix, so byte offsets are shown instead.
+    qint64 begin = 0;
+    qint64 end = fileSize;
+    bool isSliceFound = LogTimeIndex::findTimeWindowRange(data, fileSize, timeWindow, begin, end);
 
-                    // restore color
-                    fmt.setBackground(Qt::white);
-                    cursor.mergeCharFormat(fmt);
-                    ui->textEditLineList->mergeCurrentCharFormat(fmt);
-                }
+    bool isAlreadyFoundInThisFile = false;
+    bool isInWindow = isSliceFound;
+    qint64 lineStart = begin;
+    while (lineStart < end)
+    {
+        const char * lineBegin = reinterpret_cast<const char *>(data + lineStart);
+        const char * newLine = static_cast<const char *>(memchr(lineBegin, '\n', end - lineStart));
+        qint64 lineLength = newLine ? newLine - lineBegin : end - lineStart;
 
-                ui->textEditLineList->append(QString("%1: %2").arg(lineNumber).arg(line));
+        if(!isSliceFound)
+        {
+            // lines without timestamp belong to the previous record
+            qint64 key;
+            if(LogTimeIndex::parseLineTimestamp(lineBegin, lineBegin + lineLength, timeWindow.hasDate, key))
+            {
+                isInWindow = LogTimeIndex::isInTimeWindow(key, timeWindow);
+            }
+        }
 
+        if(isInWindow)
+        {
+            QString line = QString::fromLocal8Bit(lineBegin, lineLength);
+            if(line.endsWith('\r'))
+            {
+                line.chop(1);
+            }
+            if(line.contains(lineRegExp))
+            {
+                onLineFound(fileName, QString("@%1").arg(lineStart), line, !isAlreadyFoundInThisFile);
                 isAlreadyFoundInThisFile = true;
             }
-            lineNumber++;
         }
-        inputFile.close();
+
+        lineStart += lineLength + 1;
+    }
+
+    inputFile.unmap(const_cast<uchar *>(data));
+    inputFile.close();
+}
+
+void MainWindow::onLineFound(QString fileName, QString lineLabel, QString line, bool isFirstInFile)
+{
+    if(isFirstInFile)
+    {
+        ui->textEditLineList->append(" ");
+
+        QTextCharFormat fmt;
+        QTextCursor cursor = ui->textEditLineList->textCursor();
+
+        // new color
+        fmt.setBackground(Qt::lightGray);
+        cursor.mergeCharFormat(fmt);
+        ui->textEditLineList->mergeCurrentCharFormat(fmt);
+
+        ui->textEditLineList->append(QString("%1").arg(fileName));
+        ui->textEditResultFileList->append(fileName);
+
+        // restore color
+        fmt.setBackground(Qt::white);
+        cursor.mergeCharFormat(fmt);
+        ui->textEditLineList->mergeCurrentCharFormat(fmt);
     }
+
+    ui->textEditLineList->append(QString("%1: %2").arg(lineLabel).arg(line));
+}
+
+bool MainWindow::validateLineRegExp(QRegExp lineRegExp)
+{
+    if(lineRegExp.isEmpty())
+    {
+        handleError(QString("Line reg exp is empty"));
+        return false;
+    }
+
+    if(!lineRegExp.isValid())
+    {
+        handleError(QString("Line reg exp is not valid: %1")
+                    .arg(lineRegExp.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+void MainWindow::startFuzzyLineSearch(QStringList fileList)
+{
+    // only the closest lines of a file are kept until the scan ends
+    const int maxHitsPerFile = 100;
+
+    struct FuzzyHit
+    {
+        int distance;
+        int lineNumber;
+        QString line;
+    };
+
+    struct FileHits
+    {
+        QString fileName;
+        int bestDistance;
+        int matchCount;
+        QVector<FuzzyHit> hits;
+    };
+
+    QByteArray pattern = ui->lineEditLineRegExp->text().toLocal8Bit();
+    if(pattern.isEmpty())
+    {
+        handleError(QString("Line mask is empty"));
+        return;
+    }
+
+    if(ui->checkBoxIsLineTimeRangeEnabled->isChecked())
+    {
+        handleError(QString("Time range is not supported in fuzzy mode"));
+        return;
+    }
+
+    // with as many typos as the mask has bytes every line matches
+    int maxDistance = ui->spinBoxLineFuzzyMaxDistance->value();
+    if(maxDistance >= pattern.size())
+    {
+        handleError(QString("Max typos must be smaller than the line mask length (%1)").arg(pattern.size()));
+        return;
+    }
+
+    auto caseSensitive = ui->checkBoxIsLineRegExpCaseSensitive->isChecked() ?
+                Qt::CaseSensitivity::CaseSensitive : Qt::CaseSensitivity::CaseInsensitive;
+    FuzzyMatcher matcher(pattern, maxDistance, caseSensitive);
+
+    setSearchActiveStatus(true);
+    setFileAndLineTabActive();
+
+    if(!ui->checkBoxAppendLinesInResultWindow->isChecked())
+    {
+        ui->textEditLineList->clear();
+    }
+    ui->textEditResultFileList->clear();
+
+    QVector<FileHits> foundFiles;
+    int currentFileNumber = 0;
+    for(auto fileName : fileList)
+    {
+        QApplication::processEvents();
+        if(m_stopSearchFlag == true)
+        {
+            break;
+        }
+
+        QFile inputFile(fileName);
+        if (inputFile.open(QIODevice::ReadOnly))
+        {
+            FileHits fileHits{fileName, pattern.size(), 0, {}};
+            int lineNumber = 1;
+            while (!inputFile.atEnd())
+            {
+                QByteArray line = inputFile.readLine();
+                while(line.endsWith('\n') || line.endsWith('\r'))
+                {
+                    line.chop(1);
+                }
+
+                int distance = matcher.match(line.constData(), line.size());
+                if(distance >= 0)
+                {
+                    fileHits.matchCount++;
+                    fileHits.bestDistance = std::min(fileHits.bestDistance, distance);
+                    if(fileHits.hits.size() < maxHitsPerFile)
+                    {
+                        fileHits.hits.append({distance, lineNumber, QString::fromLocal8Bit(line)});
+                    }
+                    else
+                    {
+                        // a full file gives up its farthest line for a closer one
+                        auto farthest = std::max_element(fileHits.hits.begin(), fileHits.hits.end(),
+                                                         [](const FuzzyHit & a, const FuzzyHit & b)
+                        {
+                            return a.distance < b.distance;
+                        });
+                        if(distance < farthest->distance)
+                        {
+                            *farthest = {distance, lineNumber, QString::fromLocal8Bit(line)};
+                        }
+                    }
+                }
+                lineNumber++;
+            }
+            inputFile.close();
+
+            if(!fileHits.hits.isEmpty())
+            {
+                foundFiles.append(fileHits);
+            }
+        }
+
+        QString statusBarMessage;
+        QTextStream out(&statusBarMessage);
+        currentFileNumber++;
+        out << "Fuzzy line search. " << "File " << currentFileNumber << "/" << fileList.count();
+        m_pStatusBarLabel->setText(statusBarMessage);
+    }
+
+    // the closest matches go first
+    std::stable_sort(foundFiles.begin(), foundFiles.end(), [](const FileHits & a, const FileHits & b)
+    {
+        return a.bestDistance < b.bestDistance;
+    });
+    for(FileHits & fileHits : foundFiles)
+    {
+        std::sort(fileHits.hits.begin(), fileHits.hits.end(), [](const FuzzyHit & a, const FuzzyHit & b)
+        {
+            return a.distance != b.distance ? a.distance < b.distance : a.lineNumber < b.lineNumber;
+        });
+
+        bool isFirstInFile = true;
+        for(const FuzzyHit & hit : fileHits.hits)
+        {
+            onLineFound(fileHits.fileName, QString("%1 [d=%2]").arg(hit.lineNumber).arg(hit.distance),
+                        hit.line, isFirstInFile);
+            isFirstInFile = false;
+        }
+        if(fileHits.matchCount > fileHits.hits.size())
+        {
+            ui->textEditLineList->append(QString("... %1 more lines")
+                                         .arg(fileHits.matchCount - fileHits.hits.size()));
+        }
+    }
+
+    setSearchActiveStatus(false);
+}
+
+void MainWindow::startReplace(bool isConfirmNeeded)
+{
+    const int maxPreviewLinesPerFile = 100;
+
+    QStringList fileList = getFileList();
+    if(fileList.isEmpty())
+    {
+        handleError("File list is empty");
+        return;
+    }
+
+    QRegExp lineRegExp = getLineRegExp();
+    if(!validateLineRegExp(lineRegExp))
+    {
+        return;
+    }
+
+    QString replaceTemplate = ui->lineEditReplaceTemplate->text();
+
+    m_isReplaceApplying = false;
+    m_isReplaceConfirmNeeded = isConfirmNeeded;
+    m_replaceFileCount = fileList.count();
+    m_replaceLineRegExp = lineRegExp;
+    m_replaceTemplate = replaceTemplate;
+
+    setReplaceActiveStatus(true);
+    setFileAndLineTabActive();
+    ui->textEditLineList->clear();
+    ui->textEditResultFileList->clear();
+
+    // Files are processed by the thread pool, the regexp is copied for every file
+    // as QRegExp keeps captured texts inside.
+    std::function<FileReplacer::ReplaceResult(const QString &)> previewFunction =
+            [=](const QString & fileName)
+    {
+        return FileReplacer::previewReplace(fileName, lineRegExp, replaceTemplate,
+                                            maxPreviewLinesPerFile);
+    };
+    m_pReplaceWatcher->setFuture(QtConcurrent::mapped(fileList, previewFunction));
+}
+
+int MainWindow::showReplaceResults(const QList<FileReplacer::ReplaceResult> & results)
+{
+    int changedFileNumber = 0;
+    int replacedLineNumber = 0;
+    int errorNumber = 0;
+    for(const FileReplacer::ReplaceResult & result : results)
+    {
+        if(!result.error.isEmpty())
+        {
+            onLineFound(result.fileName, "error", result.error, true);
+            errorNumber++;
+            continue;
+        }
+
+        // the apply keeps the preview on the screen, its results have no lines of their own
+        bool isFirstInFile = true;
+        for(const FileReplacer::ReplacedLine & replacedLine : result.preview)
+        {
+            onLineFound(result.fileName, QString("-%1").arg(replacedLine.lineNumber),
+                        replacedLine.before, isFirstInFile);
+            onLineFound(result.fileName, QString("+%1").arg(replacedLine.lineNumber),
+                        replacedLine.after, false);
+            isFirstInFile = false;
+        }
+        if(result.replacedLineCount > result.preview.size() && !m_isReplaceApplying)
+        {
+            ui->textEditLineList->append(QString("... %1 more lines")
+                                         .arg(result.replacedLineCount - result.preview.size()));
+        }
+
+        if(result.replacedLineCount > 0)
+        {
+            changedFileNumber++;
+            replacedLineNumber += result.replacedLineCount;
+        }
+    }
+
+    QString statusBarMessage;
+    QTextStream out(&statusBarMessage);
+    out << (m_isReplaceApplying ? "Replace. " : "Replace preview. ")
+        << (m_pReplaceWatcher->isCanceled() ? "Stopped. " : "")
+        << "Files: " << changedFileNumber << "; Lines: " << replacedLineNumber
+        << "; Errors: " << errorNumber;
+    m_pStatusBarLabel->setText(statusBarMessage);
+
+    return replacedLineNumber;
 }
 
 void MainWindow::searchFilesInDirectory()
 {
-    QString rootDir = ui->lineEditRootPath->text();
-    QFileInfo rootDirInfo(rootDir);
-    if(!rootDirInfo.isDir())
+    QStringList rootDirs = getRootPathList();
+    if(rootDirs.isEmpty())
     {
         handleError("File system file path is not valid");
         return;
     }
 
+    for(auto rootDir : rootDirs)
+    {
+        QFileInfo rootDirInfo(rootDir);
+        if(!rootDirInfo.isDir())
+        {
+            handleError(QString("File system file path is not valid: %1").arg(rootDir));
+            return;
+        }
+    }
+
     QRegExp fileRegExp = getFileRegExp();
     if(!fileRegExp.isValid())
     {
@@ -664,7 +1203,7 @@ void MainWindow::searchFilesInDirectory()
 
     setSearchActiveStatus(true);
     setFileTabActive();
-    startSearchInDirectory(rootDir, fileRegExp, fileIgnoreRegExp);
+    startSearchInDirectory(rootDirs, fileRegExp, fileIgnoreRegExp);
     setSearchActiveStatus(false);
 }
 
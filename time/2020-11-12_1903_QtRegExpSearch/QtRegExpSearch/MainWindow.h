@@ -1,6 +1,10 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QFutureWatcher>
+
+#include "LogTimeIndex.h"
+#include "FileReplacer.h"
 
 class QErrorMessage;
 
@@ -21,6 +25,9 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    void closeEvent(QCloseEvent * event) override;
+
 private:
     enum class FileMatch
     {
@@ -30,7 +37,7 @@ private:
     };
 
     void handleError(QString msg);
-    void startSearchInDirectory(QString dirStr, QRegExp fileRegExp, QRegExp fileIgnoreRegExp);
+    void startSearchInDirectory(QStringList rootDirs, QRegExp fileRegExp, QRegExp fileIgnoreRegExp);
     void onFileFound(QString filePath);
     void setSearchActiveStatus(bool b);
     void setFileTabActive();
@@ -41,10 +48,19 @@ private:
     void readPresetSettings(QString presetName);
     void readPresetNameSettings();
     QStringList getFileList();
+    QStringList getRootPathList();
     QRegExp getFileRegExp();
     QRegExp getFileIgnoreRegExp();
     QRegExp getLineRegExp();
     void searchLinesInTheFile(QString fileName, QRegExp lineRegExp);
+    void searchLinesInTheFileTimeRange(QString fileName, QRegExp lineRegExp,
+                                       const LogTimeIndex::TimeWindow & timeWindow);
+    void onLineFound(QString fileName, QString lineLabel, QString line, bool isFirstInFile);
+    bool validateLineRegExp(QRegExp lineRegExp);
+    void startFuzzyLineSearch(QStringList fileList);
+    void startReplace(bool isConfirmNeeded);
+    void setReplaceActiveStatus(bool b);
+    int showReplaceResults(const QList<FileReplacer::ReplaceResult> & results);
     void searchFilesInDirectory();
     void searchFilesInFileList();
     bool isFileListAsSourceFlagActive();
@@ -60,6 +76,13 @@ private:
     QStringList m_selectedLines;
     QString m_externalApplication;
     QString m_extraOptions;
+    // a replace runs in the thread pool, the preview first and then the apply
+    QFutureWatcher<FileReplacer::ReplaceResult> * m_pReplaceWatcher;
+    bool m_isReplaceApplying;
+    bool m_isReplaceConfirmNeeded;
+    int m_replaceFileCount;
+    QRegExp m_replaceLineRegExp;
+    QString m_replaceTemplate;
 
 private slots:
     void slotBrowseRootDirectory();
@@ -78,5 +101,11 @@ private slots:
     void slotTryOpenSelectedFiles();
     void slotBrowseExternalFileViewer();
     void slotWordWrapStateChanged(int state);
+    void slotLineTimeRangeStateChanged(int);
+    void slotLineFuzzyModeStateChanged(int);
+    void slotReplacePreview();
+    void slotReplace();
+    void slotReplaceProgress(int progress);
+    void slotReplaceFinished();
 };
 
@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 CONFIG += c++11
 
@@ -16,11 +16,19 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    DirectoryWalker.cpp \
+    FileReplacer.cpp \
+    FuzzyMatcher.cpp \
+    LogTimeIndex.cpp \
     Main.cpp \
     MainWindow.cpp \
     SmartCheckBox.cpp
 
 HEADERS += \
+    DirectoryWalker.h \
+    FileReplacer.h \
+    FuzzyMatcher.h \
+    LogTimeIndex.h \
     MainWindow.h \
     MyHelper.hpp \
     SmartCheckBox.h